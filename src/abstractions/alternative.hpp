@@ -9,6 +9,7 @@
 //   optional → optional_parser (“optional” is already taken by STL)
 
 #include <functional>
+#include <iterator>
 #include <optional>
 #include <vector>
 
@@ -76,12 +77,22 @@ template <template<typename>typename F, typename A>
 // and another one for all the other elements (tail) of the list.
 F<vector<A>> one_plus(F<A> head, F<A> tail)
 {
-	function<vector<A>(A, vector<A>)> cons = [](A x, vector<A> xs) {
-		vector list {x};
-		list.insert(list.end(), xs.begin(), xs.end());
-		return list;
+	// Curried by hand, the elements are moved rather than copied (every
+	// partial application is called only once)
+	function<function<vector<A>(vector<A>)>(A)> cons = [](A x) {
+		return [x = move(x)](vector<A> xs) mutable {
+			vector<A> list;
+			list.reserve(xs.size() + 1);
+			list.push_back(move(x));
+			list.insert(
+				list.end(),
+				make_move_iterator(xs.begin()),
+				make_move_iterator(xs.end())
+			);
+			return list;
+		};
 	};
-	return curry(cons) ^ head ^ many(tail);
+	return cons ^ head ^ many(tail);
 }
 
 template <template<typename>typename F, typename A, typename S>
@@ -55,9 +55,10 @@ template <template<typename>typename F, typename A, typename B>
 F<A> apply_first(F<A> functor_a, F<B> functor_b)
 {
 	// (\a _ -> a) <$> functor_a <*> functor_b
+	// (the function is called once, so “a” is moved rather than copied)
 	return apply<F, B, A>(
 		fmap<F, A, function<A(B)>>(
-			[](A a) { return [=](B) { return a; }; },
+			[](A a) { return [a = move(a)](B) mutable { return move(a); }; },
 			functor_a
 		),
 		functor_b
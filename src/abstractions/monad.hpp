@@ -0,0 +1,60 @@
+#pragma once
+
+// Monad implementation (mimicking Monad type class from Haskell)
+//
+// Definitions in relation to Haskell (Haskell version on the left):
+//   >>= → >>= (“monad_bind”, not to be confused with “std::bind”)
+//
+// Unlike in Haskell the continuation does not have to return “F<B>”. It can
+// return any callable that takes the input and returns the parsing result
+// (“F<B>” is just one of such callables). A plain lambda is preferred since
+// then nothing is allocated when the continuation is called.
+//
+// Mind that “>>=” is right-associative in C++ (it is an assignment operator)
+// and it has lower precedence than any other operator, so use parentheses for
+// chaining:
+//
+//   (parser >>= continuation_a) >>= continuation_b
+
+#include <type_traits>
+
+#include "abstractions/applicative.hpp"
+#include "helpers.hpp"
+
+using namespace std;
+
+
+// Only the types which have the instance (it is specialized next to it, see
+// “parser/types.hpp”), so that “>>=” stays out of the way of the other
+// templates of one type argument
+template <template<typename>typename F>
+struct IsMonad: false_type {};
+
+
+// monad_bind {{{1
+
+template <
+	template<typename>typename F,
+	typename A,
+	typename K,
+	typename = enable_if_t<IsMonad<F>::value>
+>
+// (>>=) :: m a → (a → m b) → m b
+auto monad_bind(F<A> m, K continuation)
+{
+	return monad_bind<A>(m, continuation);
+}
+
+template <
+	template<typename>typename F,
+	typename A,
+	typename K,
+	typename = enable_if_t<IsMonad<F>::value>
+>
+// Operator equivalent for “monad_bind”
+auto operator>>=(F<A> m, K continuation)
+{
+	return monad_bind<F, A, K>(m, continuation);
+}
+
+// }}}1
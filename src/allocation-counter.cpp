@@ -0,0 +1,40 @@
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "allocation-counter.hpp"
+
+using namespace std;
+
+
+// The counter is per thread so that counting does not cause any contention
+static thread_local size_t allocations_count = 0;
+static thread_local size_t allocated_bytes = 0;
+
+size_t allocations_counter()
+{
+	return allocations_count;
+}
+
+size_t allocated_bytes_counter()
+{
+	return allocated_bytes;
+}
+
+void* operator new(size_t size)
+{
+	++allocations_count;
+	allocated_bytes += size;
+	if (void *p = malloc(size == 0 ? 1 : size)) return p;
+	throw bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	free(p);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+// Global allocation functions are replaced in order to count how many times
+// memory was allocated. Used by the tests to make sure that some code does not
+// allocate memory, and by the benchmarks to see how much memory it takes.
+
+#include <cstddef>
+
+using namespace std;
+
+
+// Number of memory allocations made by the current thread so far
+size_t allocations_counter();
+// Number of bytes of them (freeing does not change it)
+size_t allocated_bytes_counter();
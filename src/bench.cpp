@@ -0,0 +1,1514 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <variant>
+#include <vector>
+
+#include "allocation-counter.hpp"
+#include "bench.hpp"
+#include "helpers.hpp"
+#include "json/cursor.hpp"
+#include "json/incremental.hpp"
+#include "json/lazy.hpp"
+#include "json/ndjson.hpp"
+#include "json/offset-index.hpp"
+#include "json/parallel.hpp"
+#include "json/parse-context.hpp"
+#include "json/parsers.hpp"
+#include "json/sax.hpp"
+#include "json/scanners.hpp"
+#include "json/select.hpp"
+#include "json/serialization.hpp"
+#include "json/structural-index.hpp"
+#include "json/tape.hpp"
+#include "json/transcoder.hpp"
+#include "json/types.hpp"
+#include "json/utf8.hpp"
+#include "parser/types.hpp"
+#include "thread-pool.hpp"
+
+using namespace std;
+
+// Local shorthands
+using I = ParserInputType<Parser>;
+using Clock = chrono::steady_clock;
+
+
+// Helpers {{{1
+
+inline double seconds_since(Clock::time_point start)
+{
+	return chrono::duration<double>(Clock::now() - start).count();
+}
+
+// A document of the same shape as “example.json” but with different values
+string make_document(size_t i)
+{
+	ostringstream out;
+	out
+		<< "{\n  \"firstName\": \"John #" << i << "\",\n"
+		<< "  \"lastName\": \"Smith\",\n"
+		<< "  \"isAlive\": " << (i % 2 == 0 ? "true" : "false") << ",\n"
+		<< "  \"age\": " << i % 100 << ",\n"
+		<< "  \"height\": " << 150 + i % 50 << ".25,\n"
+		<< "  \"address\": {\n"
+		<< "    \"streetAddress\": \"" << i << " 2nd Street\",\n"
+		<< "    \"city\": \"New York\",\n"
+		<< "    \"state\": \"NY\",\n"
+		<< "    \"postalCode\": \"10021-" << 1000 + i % 9000 << "\"\n"
+		<< "  },\n"
+		<< "  \"phoneNumbers\": [";
+	for (size_t j = 0; j < 1 + i % 4; ++j)
+		out
+			<< (j == 0 ? "\n" : ",\n")
+			<< "    { \"type\": \"home\", \"number\": \"212 555-" << i << j
+			<< "\" }";
+	out << "\n  ],\n  \"children\": [],\n  \"spouse\": null\n}\n";
+	return out.str();
+}
+
+vector<string> make_documents(size_t count)
+{
+	vector<string> documents;
+	for (size_t i = 0; i < count; ++i) documents.push_back(make_document(i));
+	return documents;
+}
+
+size_t total_size(const vector<string> &documents)
+{
+	size_t size = 0;
+	for (auto &x : documents) size += x.size();
+	return size;
+}
+
+// Run “fn” on the given amount of threads at the same time.
+// Returns the wall time in seconds (threads creation is not included).
+double run_on_threads(size_t threads_count, function<void(size_t)> fn)
+{
+	atomic<bool> started {false};
+	vector<thread> threads;
+
+	for (size_t i = 0; i < threads_count; ++i)
+		threads.emplace_back([&started, &fn, i]() {
+			while (!started.load()) this_thread::yield();
+			fn(i);
+		});
+
+	const Clock::time_point start = Clock::now();
+	started.store(true);
+	for (auto &x : threads) x.join();
+	return seconds_since(start);
+}
+
+// 1, 2, 4, … up to the amount of the hardware threads (including it)
+vector<size_t> threads_counts()
+{
+	const size_t max_threads = max(1u, thread::hardware_concurrency());
+	vector<size_t> counts;
+	for (size_t i = 1; i < max_threads; i *= 2) counts.push_back(i);
+	counts.push_back(max_threads);
+	return counts;
+}
+
+// Only counts the bytes written to it
+class CountingBuffer: public streambuf
+{
+public:
+	size_t size = 0;
+
+protected:
+	streamsize xsputn(const char*, streamsize n) override
+	{
+		size += n;
+		return n;
+	}
+	int overflow(int c) override
+	{
+		++size;
+		return c;
+	}
+};
+
+// }}}1
+
+
+// Benchmarks {{{1
+
+// Independent documents are parsed on 1…N threads at the same time, all of
+// them are sharing the same “parse_json” grammar. Each thread parses the same
+// amount of documents, so when it scales perfectly the time stays the same.
+bool bench_threads()
+{
+	const vector<string> documents = make_documents(1000);
+	const size_t documents_size = total_size(documents);
+	atomic<size_t> failures {0};
+
+	const auto parse_documents = [&](size_t passes) {
+		for (size_t pass = 0; pass < passes; ++pass)
+			for (auto &x : documents)
+				if (holds_alternative<ParsingError<I>>(parse_json(x)))
+					++failures;
+	};
+
+	// One pass to warm up and to pick the amount of passes per thread so that
+	// a single thread would run for about a second
+	const Clock::time_point calibration_start = Clock::now();
+	parse_documents(1);
+	const size_t passes =
+		size_t(max(1.0, 1.0 / max(seconds_since(calibration_start), 1e-6)));
+
+	cout
+		<< "threads: parsing " << documents.size() << " documents ("
+		<< documents_size / 1024 << " KiB) " << passes
+		<< " time(s) per thread with the shared “parse_json” grammar" << endl
+		<< endl
+		<< setw(10) << "threads"
+		<< setw(12) << "time, s"
+		<< setw(14) << "documents/s"
+		<< setw(10) << "MiB/s"
+		<< setw(13) << "efficiency" << endl;
+
+	double single_thread_throughput = 0;
+
+	for (size_t threads_count : threads_counts()) {
+		const double seconds = run_on_threads(
+			threads_count,
+			[&](size_t) { parse_documents(passes); }
+		);
+
+		const double runs = double(threads_count * passes);
+		const double throughput = runs * documents.size() / seconds;
+		if (threads_count == 1) single_thread_throughput = throughput;
+
+		cout
+			<< fixed << setprecision(3)
+			<< setw(10) << threads_count
+			<< setw(12) << seconds
+			<< setprecision(0)
+			<< setw(14) << throughput
+			<< setprecision(2)
+			<< setw(10) << runs * documents_size / seconds / 1024 / 1024
+			<< setprecision(1)
+			<< setw(12)
+			<< 100 * throughput / (threads_count * single_thread_throughput)
+			<< "%" << endl;
+	}
+
+	cout << defaultfloat << endl;
+
+	if (failures > 0)
+		cerr << "threads: failed to parse " << failures << " document(s)" << endl;
+
+	return failures == 0;
+}
+
+// The same documents are parsed by every JSON parsing engine one by one
+bool bench_engines()
+{
+	using Engine = function<variant<ParsingError<I>, JsonValue>(I)>;
+	ParseContext ctx;
+
+	// Only counts the values (there is no document to build)
+	class Counter: public JsonHandler
+	{
+	public:
+		size_t values = 0;
+		bool on_null() override { ++values; return true; }
+		bool on_bool(bool) override { ++values; return true; }
+		bool on_number(JsonNumber &&) override { ++values; return true; }
+		bool on_string(string_view) override { ++values; return true; }
+	};
+	Counter counter;
+
+	const vector<pair<string, Engine>> engines = {
+		{"combinators", [](I x) { return parse_json(x); }},
+		{"context", [&ctx](I x) {
+			auto result = parse_json(ctx, x);
+			// Giving the storage back for the next document
+			if (holds_alternative<JsonValue>(result)) {
+				ctx.recycle(move(get<JsonValue>(result)));
+				return variant<ParsingError<I>, JsonValue>{JsonValue{}};
+			}
+			return result;
+		}},
+		{"structural", [](I x) { return parse_json_structural(x); }},
+		{"events", [&counter](I x) -> variant<ParsingError<I>, JsonValue> {
+			if (auto err = parse_json_events(x, counter)) return *err;
+			return JsonValue{};
+		}},
+		{"validate", [](I x) -> variant<ParsingError<I>, JsonValue> {
+			if (auto err = validate_json(x)) return *err;
+			return JsonValue{};
+		}},
+	};
+
+	const vector<string> documents = make_documents(1000);
+	const size_t documents_size = total_size(documents);
+	size_t failures = 0;
+
+	cout
+		<< "engines: parsing " << documents.size() << " documents ("
+		<< documents_size / 1024 << " KiB) for about a second per engine"
+		<< endl << endl
+		<< setw(14) << "engine"
+		<< setw(14) << "documents/s"
+		<< setw(10) << "MiB/s" << endl;
+
+	for (auto &[ name, engine ] : engines) {
+		size_t passes = 0;
+		const Clock::time_point start = Clock::now();
+		do {
+			for (auto &x : documents)
+				if (holds_alternative<ParsingError<I>>(engine(x))) ++failures;
+			++passes;
+		} while (seconds_since(start) < 1);
+		const double seconds = seconds_since(start);
+
+		cout
+			<< fixed
+			<< setw(14) << name
+			<< setprecision(0)
+			<< setw(14) << passes * documents.size() / seconds
+			<< setprecision(2)
+			<< setw(10) << passes * documents_size / seconds / 1024 / 1024
+			<< endl;
+	}
+
+	cout << defaultfloat << endl;
+
+	if (failures > 0)
+		cerr << "engines: failed to parse " << failures << " document(s)" << endl;
+
+	return failures == 0;
+}
+
+// The same documents wrapped into arrays nested 1…4096 levels deep. “context”
+// engine keeps the nesting on the heap instead of the call stack, it shows
+// that it is not slower than the recursive “structural” engine on the usual
+// shallow documents (the values nested deeper than “recursive_json_max_depth”
+// are built the same way by “structural” engine).
+bool bench_depth()
+{
+	using Engine = function<variant<ParsingError<I>, JsonValue>(I)>;
+	ParseContext ctx;
+
+	const vector<pair<string, Engine>> engines = {
+		{"structural", [](I x) { return parse_json_structural(x); }},
+		{"context", [&ctx](I x) {
+			auto result = parse_json(ctx, x);
+			// Giving the storage back for the next document
+			if (holds_alternative<JsonValue>(result)) {
+				ctx.recycle(move(get<JsonValue>(result)));
+				return variant<ParsingError<I>, JsonValue>{JsonValue{}};
+			}
+			return result;
+		}},
+		{"validate", [](I x) -> variant<ParsingError<I>, JsonValue> {
+			if (auto err = validate_json(x)) return *err;
+			return JsonValue{};
+		}},
+	};
+
+	const vector<string> documents = make_documents(1000);
+	size_t failures = 0;
+
+	cout
+		<< "depth: parsing " << documents.size() << " documents ("
+		<< total_size(documents) / 1024 << " KiB without the nesting) "
+		<< "for about a second" << endl
+		<< "per engine and depth (MiB/s)" << endl << endl
+		<< setw(8) << "depth";
+	for (auto &x : engines) cout << setw(12) << x.first;
+	cout << endl;
+
+	for (size_t depth : {1, 16, 256, 4096}) {
+		vector<string> nested;
+		for (auto &x : documents) {
+			const string open(depth - 1, '['), close(depth - 1, ']');
+			nested.push_back(open + x + close);
+		}
+		const size_t nested_size = total_size(nested);
+
+		cout << setw(8) << depth;
+		for (auto &[ name, engine ] : engines) {
+			size_t passes = 0;
+			const Clock::time_point start = Clock::now();
+			do {
+				for (auto &x : nested) {
+					auto result = engine(x);
+					if (holds_alternative<ParsingError<I>>(result)) ++failures;
+				}
+				++passes;
+			} while (seconds_since(start) < 1);
+			const double seconds = seconds_since(start);
+
+			cout
+				<< fixed << setprecision(2)
+				<< setw(12) << passes * nested_size / seconds / 1024 / 1024;
+		}
+		cout << endl;
+	}
+
+	cout << defaultfloat << endl;
+
+	if (failures > 0)
+		cerr << "depth: failed to parse " << failures << " document(s)" << endl;
+
+	return failures == 0;
+}
+
+// A single huge array of documents is parsed with the structural index engine
+// on one thread and then with the parallel engine on 1…N threads
+bool bench_huge()
+{
+	string document = "[";
+	for (size_t i = 0; document.size() < 64 * 1024 * 1024; ++i)
+		document += (i == 0 ? "" : ",") + make_document(i);
+	document += "]";
+	const double size_mib = double(document.size()) / 1024 / 1024;
+	bool success = true;
+
+	cout
+		<< "huge: parsing a single array of " << fixed << setprecision(2)
+		<< size_mib << " MiB" << endl << endl
+		<< setw(12) << "engine"
+		<< setw(10) << "threads"
+		<< setw(12) << "time, s"
+		<< setw(10) << "MiB/s"
+		<< setw(10) << "speedup" << endl;
+
+	const auto measure = [&](string name, size_t threads_count, auto parse) {
+		const Clock::time_point start = Clock::now();
+		const auto result = parse();
+		const double seconds = seconds_since(start); // Not counting teardown
+		if (holds_alternative<ParsingError<I>>(result)) success = false;
+		return make_pair(name, make_pair(threads_count, seconds));
+	};
+
+	vector<pair<string, pair<size_t, double>>> results = {
+		measure("structural", 1, [&]() { return parse_json_structural(document); })
+	};
+
+	for (size_t threads_count : threads_counts()) {
+		ThreadPool pool(threads_count);
+		results.push_back(measure("parallel", threads_count, [&]() {
+			return parse_json_parallel(pool, document);
+		}));
+	}
+
+	for (auto &[ name, x ] : results)
+		cout
+			<< setw(12) << name
+			<< setw(10) << x.first
+			<< setprecision(3)
+			<< setw(12) << x.second
+			<< setprecision(2)
+			<< setw(10) << size_mib / x.second
+			<< setw(9) << results[0].second.second / x.second << "x" << endl;
+
+	cout << defaultfloat << endl;
+
+	if (!success) cerr << "huge: failed to parse the document" << endl;
+	return success;
+}
+
+// One field of every document of a huge array is summed up, with a document
+// built by the structural index engine, with the events and with the cursor
+// (that skips everything else)
+bool bench_cursor()
+{
+	string document = "[";
+	for (size_t i = 0; document.size() < 16 * 1024 * 1024; ++i)
+		document += (i == 0 ? "" : ",") + make_document(i);
+	document += "]";
+	const double size_mib = double(document.size()) / 1024 / 1024;
+
+	// “age” of the documents at depth 2
+	class AgeSum: public JsonHandler
+	{
+	public:
+		int64_t sum = 0;
+		bool on_number(JsonNumber &&x) override
+		{
+			if (is_age) sum += get<int64_t>(from_json_number(move(x)));
+			is_age = false;
+			return true;
+		}
+		bool on_array_begin() override { ++depth; is_age = false; return true; }
+		bool on_array_end() override { --depth; return true; }
+		bool on_object_begin() override { ++depth; is_age = false; return true; }
+		bool on_key(string_view x) override
+		{
+			is_age = depth == 2 && x == "age";
+			return true;
+		}
+		bool on_object_end() override { --depth; return true; }
+		bool on_string(string_view) override { is_age = false; return true; }
+		bool on_bool(bool) override { is_age = false; return true; }
+		bool on_null() override { is_age = false; return true; }
+
+	private:
+		size_t depth = 0;
+		bool is_age = false;
+	};
+
+	using Engine = function<optional<int64_t>()>;
+	const vector<pair<string, Engine>> engines = {
+		{"structural", [&document]() -> optional<int64_t> {
+			auto result = parse_json_structural(document);
+			if (holds_alternative<ParsingError<I>>(result)) return nullopt;
+			int64_t sum = 0;
+			for (auto &x : get<0>(get<JsonArray>(get<JsonValue>(result)))) {
+				auto &age = get<0>(get<JsonObject>(x)).at("age");
+				sum += get<int64_t>(from_json_number(get<JsonNumber>(age)));
+			}
+			return sum;
+		}},
+		{"events", [&document]() -> optional<int64_t> {
+			AgeSum handler;
+			if (parse_json_events(document, handler)) return nullopt;
+			return handler.sum;
+		}},
+		{"cursor", [&document]() -> optional<int64_t> {
+			JsonCursor cursor(document);
+			int64_t sum = 0, age = 0;
+			if (!cursor.enter_array()) return nullopt;
+			while (cursor.next_element()) {
+				if (!(
+					cursor.enter_object() &&
+					cursor.find_key("age") &&
+					cursor.get_int64(age) &&
+					cursor.leave()
+				)) return nullopt;
+				sum += age;
+			}
+			if (!cursor.finish()) return nullopt;
+			return sum;
+		}},
+	};
+	set<int64_t> sums;
+
+	cout
+		<< "cursor: summing a field of every document of a single array of "
+		<< fixed << setprecision(2) << size_mib << " MiB" << endl << endl
+		<< setw(12) << "engine"
+		<< setw(12) << "time, s"
+		<< setw(10) << "MiB/s" << endl;
+
+	for (auto &[ name, engine ] : engines) {
+		const Clock::time_point start = Clock::now();
+		const optional<int64_t> sum = engine();
+		const double seconds = seconds_since(start);
+		sums.insert(sum.value_or(-1));
+
+		cout
+			<< setw(12) << name
+			<< setprecision(3)
+			<< setw(12) << seconds
+			<< setprecision(2)
+			<< setw(10) << size_mib / seconds << endl;
+	}
+
+	cout << defaultfloat << endl;
+
+	const bool success = sums.size() == 1 && *sums.begin() >= 0;
+	if (!success) cerr << "cursor: the engines got different sums" << endl;
+	return success;
+}
+
+// Three fields out of 40 KiB documents are read with a document built by the
+// structural index engine, with a lazy document and with the cursor
+bool bench_lazy()
+{
+	vector<string> documents;
+	for (size_t i = 0; i < 100; ++i) {
+		string items;
+		for (size_t j = 0; items.size() < 40 * 1024; ++j)
+			items += (j == 0 ? "" : ",") + make_document(i + j);
+		documents.push_back(
+			"{\"id\": " + to_string(i) + ", \"items\": [" + items + "], "
+			"\"route\": {\"from\": \"A" + to_string(i) + "\", \"to\": \"B\"}, "
+			"\"priority\": " + to_string(i % 5) + "}"
+		);
+	}
+	const size_t documents_size = total_size(documents);
+
+	// Sum of “id” and “priority” and the length of “route.to”
+	using Engine = function<optional<int64_t>(I)>;
+	const vector<pair<string, Engine>> engines = {
+		{"structural", [](I x) -> optional<int64_t> {
+			auto result = parse_json_structural(x);
+			if (holds_alternative<ParsingError<I>>(result)) return nullopt;
+			auto &root = get<0>(get<JsonObject>(get<JsonValue>(result)));
+			const auto as_int = [](const JsonValue &y) {
+				return get<int64_t>(from_json_number(get<JsonNumber>(y)));
+			};
+			auto &route = get<0>(get<JsonObject>(root.at("route")));
+			return
+				as_int(root.at("id")) + as_int(root.at("priority")) +
+				int64_t(json_string_view(get<JsonString>(route.at("to"))).size());
+		}},
+		{"lazy", [](I x) -> optional<int64_t> {
+			auto root = parse_json_lazy(x);
+			if (holds_alternative<ParsingError<I>>(root)) return nullopt;
+			int64_t sum = 0;
+			for (auto key : {"id", "priority"}) {
+				auto y = in_key(key, get<LazyJsonValue>(root));
+				if (holds_alternative<ParsingError<I>>(y)) return nullopt;
+				auto z = to_json_value(get<LazyJsonValue>(y));
+				if (holds_alternative<ParsingError<I>>(z)) return nullopt;
+				sum += get<int64_t>(
+					from_json_number(get<JsonNumber>(get<JsonValue>(z)))
+				);
+			}
+			auto route = in_key("route", get<LazyJsonValue>(root));
+			if (holds_alternative<ParsingError<I>>(route)) return nullopt;
+			auto to = in_key("to", get<LazyJsonValue>(route));
+			if (holds_alternative<ParsingError<I>>(to)) return nullopt;
+			// A string in the source is its length plus the quotes
+			return sum + int64_t(get<LazyJsonValue>(to).source().size() - 2);
+		}},
+		{"cursor", [](I x) -> optional<int64_t> {
+			JsonCursor cursor(x);
+			int64_t id = 0, priority = 0;
+			string_view to;
+			if (!(
+				cursor.enter_object() &&
+				cursor.find_key("id") && cursor.get_int64(id) &&
+				cursor.find_key("route") && cursor.enter_object() &&
+				cursor.find_key("to") && cursor.get_string(to) &&
+				cursor.leave() &&
+				cursor.find_key("priority") && cursor.get_int64(priority) &&
+				cursor.finish()
+			)) return nullopt;
+			return id + priority + int64_t(to.size());
+		}},
+	};
+	set<int64_t> sums;
+
+	cout
+		<< "lazy: reading 3 fields out of " << documents.size() << " documents ("
+		<< documents_size / documents.size() / 1024 << " KiB each) for about"
+		<< " a second per engine" << endl << endl
+		<< setw(12) << "engine"
+		<< setw(14) << "documents/s"
+		<< setw(10) << "MiB/s" << endl;
+
+	for (auto &[ name, engine ] : engines) {
+		int64_t sum = 0;
+		size_t passes = 0;
+		const Clock::time_point start = Clock::now();
+		do {
+			sum = 0;
+			for (auto &x : documents) sum += engine(x).value_or(-1000000);
+			++passes;
+		} while (seconds_since(start) < 1);
+		const double seconds = seconds_since(start);
+		sums.insert(sum);
+
+		cout
+			<< fixed
+			<< setw(12) << name
+			<< setprecision(0)
+			<< setw(14) << passes * documents.size() / seconds
+			<< setprecision(2)
+			<< setw(10) << passes * documents_size / seconds / 1024 / 1024
+			<< endl;
+	}
+
+	cout << defaultfloat << endl;
+
+	const bool success = sums.size() == 1 && *sums.begin() >= 0;
+	if (!success) cerr << "lazy: the engines got different fields" << endl;
+	return success;
+}
+
+// A huge array is rewritten compact and indented by building a document with
+// the structural index engine and serializing it, and by the streaming
+// transcoder fed with 64 KiB pieces
+bool bench_transcode()
+{
+	string document = "[";
+	for (size_t i = 0; document.size() < 32 * 1024 * 1024; ++i)
+		document += (i == 0 ? "" : ",") + make_document(i);
+	document += "]";
+	const double size_mib = double(document.size()) / 1024 / 1024;
+
+	// Size of the output
+	using Engine = function<optional<size_t>(bool pretty)>;
+	const vector<pair<string, Engine>> engines = {
+		{"document", [&document](bool pretty) -> optional<size_t> {
+			auto result = parse_json_structural(document);
+			if (holds_alternative<ParsingError<I>>(result)) return nullopt;
+			return serialize_json(
+				get<JsonValue>(result),
+				pretty ? "\n" : "",
+				pretty ? "  " : ""
+			).size();
+		}},
+		{"transcoder", [&document](bool pretty) -> optional<size_t> {
+			CountingBuffer buffer;
+			ostream out(&buffer);
+			JsonTranscoder transcoder(
+				out,
+				pretty ? "\n" : "",
+				pretty ? "  " : ""
+			);
+			for (size_t i = 0; i < document.size(); i += 1 << 16)
+				if (!transcoder.feed(string_view(document).substr(i, 1 << 16)))
+					return nullopt;
+			if (!transcoder.finish()) return nullopt;
+			return buffer.size;
+		}},
+	};
+	// The keys are only reordered, so the sizes are the same
+	set<size_t> sizes;
+
+	cout
+		<< "transcode: rewriting a single array of " << fixed
+		<< setprecision(2) << size_mib << " MiB" << endl << endl
+		<< setw(12) << "engine"
+		<< setw(10) << "output"
+		<< setw(12) << "time, s"
+		<< setw(10) << "MiB/s" << endl;
+
+	for (bool pretty : {false, true})
+		for (auto &[ name, engine ] : engines) {
+			const Clock::time_point start = Clock::now();
+			const optional<size_t> size = engine(pretty);
+			const double seconds = seconds_since(start);
+			sizes.insert(size.value_or(0) + (pretty ? 1 : 0));
+
+			cout
+				<< setw(12) << name
+				<< setw(10) << (pretty ? "pretty" : "compact")
+				<< setprecision(3)
+				<< setw(12) << seconds
+				<< setprecision(2)
+				<< setw(10) << size_mib / seconds << endl;
+		}
+
+	cout << defaultfloat << endl;
+
+	const bool success = sizes.size() == 2 && *sizes.begin() > 0;
+	if (!success) cerr << "transcode: the outputs are different" << endl;
+	return success;
+}
+
+// NDJSON records are parsed and serialized on 1…N threads, the results are
+// written in the order of the input
+bool bench_ndjson()
+{
+	string input;
+	for (size_t i = 0; input.size() < 32 * 1024 * 1024; ++i) {
+		string record = make_document(i);
+		replace(record.begin(), record.end(), '\n', ' ');
+		input += record + "\n";
+	}
+	const double size_mib = double(input.size()) / 1024 / 1024;
+
+	const NdjsonProcessor::Transform transform =
+		[](string_view record, string &out) -> optional<string> {
+			auto x = parse_json_structural(record);
+			if (auto err = get_if<ParsingError<I>>(&x)) return err->first;
+			out += serialize_json(get<JsonValue>(x));
+			out += '\n';
+			return nullopt;
+		};
+
+	cout
+		<< "ndjson: parsing and serializing " << fixed << setprecision(2)
+		<< size_mib << " MiB of records" << endl << endl
+		<< setw(10) << "threads"
+		<< setw(12) << "time, s"
+		<< setw(10) << "MiB/s"
+		<< setw(10) << "speedup" << endl;
+
+	bool success = true;
+	double first_seconds = 0;
+	set<size_t> output_sizes;
+
+	for (size_t threads_count : threads_counts()) {
+		ThreadPool pool(threads_count);
+		CountingBuffer buffer;
+		ostream out(&buffer);
+		ostringstream failures;
+
+		const Clock::time_point start = Clock::now();
+		NdjsonProcessor processor(pool, transform, out, failures);
+		for (size_t i = 0; i < input.size(); i += 1 << 16)
+			processor.feed(string_view(input).substr(i, 1 << 16));
+		processor.finish();
+		const double seconds = seconds_since(start);
+		if (first_seconds == 0) first_seconds = seconds;
+
+		success = success && processor.failures_count() == 0;
+		output_sizes.insert(buffer.size);
+
+		cout
+			<< setw(10) << threads_count
+			<< setprecision(3)
+			<< setw(12) << seconds
+			<< setprecision(2)
+			<< setw(10) << size_mib / seconds
+			<< setw(9) << first_seconds / seconds << "x" << endl;
+	}
+
+	cout << defaultfloat << endl;
+
+	success = success && output_sizes.size() == 1;
+	if (!success) cerr << "ndjson: the records are processed differently" << endl;
+	return success;
+}
+
+// Small edits of a huge array: parsing all of it again after every edit
+// compared with re-parsing only what the edit touched
+bool bench_incremental()
+{
+	string document = "[";
+	for (size_t i = 0; document.size() < 32 * 1024 * 1024; ++i)
+		document += (i == 0 ? "" : ",") + make_document(i);
+	document += "]";
+	const double size_mib = double(document.size()) / 1024 / 1024;
+
+	// An edit replaces the value of an “age” field somewhere in the document
+	// with a number of another length
+	struct Edit
+	{
+		size_t offset;
+		size_t deleted;
+		string inserted;
+	};
+	const auto make_edit = [](string_view text, size_t i) -> Edit {
+		const string_view field = "\"age\": ";
+		size_t begin = text.find(field, (i * 2654435761) % text.size());
+		if (begin == string_view::npos) begin = text.find(field);
+		begin += field.size();
+		return {begin, text.find(',', begin) - begin, to_string(i % 1000)};
+	};
+
+	IncrementalJsonDocument incremental(document);
+	bool success = incremental.error() == nullptr;
+
+	cout
+		<< "incremental: editing a single array of " << fixed
+		<< setprecision(2) << size_mib << " MiB" << endl << endl
+		<< setw(12) << "engine"
+		<< setw(12) << "edits/s"
+		<< setw(16) << "parsed per edit" << endl;
+
+	for (bool full : {true, false}) {
+		size_t edits = 0;
+		size_t parsed = 0;
+		const Clock::time_point start = Clock::now();
+		do {
+			if (full) {
+				const Edit x = make_edit(document, edits);
+				document.replace(x.offset, x.deleted, x.inserted);
+				auto result = parse_json_structural(document);
+				success = success && holds_alternative<JsonValue>(result);
+				parsed += document.size();
+			} else {
+				const Edit x = make_edit(incremental.text(), edits);
+				success =
+					incremental.edit(x.offset, x.deleted, x.inserted) && success;
+				parsed += incremental.reparsed_size();
+			}
+			++edits;
+		} while (seconds_since(start) < 1);
+		const double seconds = seconds_since(start);
+
+		cout
+			<< setw(12) << (full ? "full" : "incremental")
+			<< setprecision(0)
+			<< setw(12) << edits / seconds
+			<< setw(16) << parsed / edits << endl;
+	}
+
+	cout << defaultfloat << endl;
+
+	// The tree is the same as the one of the whole text parsed again
+	const auto result = parse_json_structural(incremental.text());
+	success =
+		success &&
+		holds_alternative<JsonValue>(result) &&
+		serialize_json(get<JsonValue>(result)) ==
+			serialize_json(incremental.to_json_value());
+
+	if (!success) cerr << "incremental: the edits are parsed wrong" << endl;
+	return success;
+}
+
+// A field of a document somewhere in a huge array: parsing all of it and
+// taking the field compared with finding the field with an offset index and
+// parsing only the field
+bool bench_index()
+{
+	string document = "[";
+	size_t count = 0;
+	for (; document.size() < 32 * 1024 * 1024; ++count)
+		document += (count == 0 ? "" : ",") + make_document(count);
+	document += "]";
+	const double size_mib = double(document.size()) / 1024 / 1024;
+
+	ostringstream index_out;
+	Clock::time_point start = Clock::now();
+	bool success = !write_json_offset_index(document, index_out).has_value();
+	const double index_seconds = seconds_since(start);
+	const string index = index_out.str();
+
+	// “city” of the address of a document
+	using Engine = function<optional<string>(size_t i)>;
+	const vector<pair<string, Engine>> engines = {
+		{"full", [&document](size_t i) -> optional<string> {
+			auto result = parse_json_structural(document);
+			if (holds_alternative<ParsingError<I>>(result)) return nullopt;
+			auto &x = get<0>(get<JsonArray>(get<JsonValue>(result))).at(i);
+			auto &address = get<0>(get<JsonObject>(x)).at("address");
+			return serialize_json(get<0>(get<JsonObject>(address)).at("city"));
+		}},
+		{"index", [&document, &index](size_t i) -> optional<string> {
+			auto found = find_json_value(
+				document,
+				index,
+				"/" + to_string(i) + "/address/city"
+			);
+			if (holds_alternative<ParsingError<I>>(found)) return nullopt;
+			auto result = parse_json(get<string_view>(found));
+			if (holds_alternative<ParsingError<I>>(result)) return nullopt;
+			return serialize_json(get<JsonValue>(result));
+		}},
+	};
+	set<string> values;
+
+	cout
+		<< "index: a field of a single array of " << fixed << setprecision(2)
+		<< size_mib << " MiB" << endl
+		<< "the index of " << double(index.size()) / 1024 << " KiB is written in "
+		<< setprecision(3) << index_seconds << " s" << endl << endl
+		<< setw(12) << "engine"
+		<< setw(14) << "lookups/s" << endl;
+
+	for (auto &[ name, engine ] : engines) {
+		size_t lookups = 0;
+		start = Clock::now();
+		do {
+			const optional<string> x = engine((lookups * 2654435761) % count);
+			success = success && x.has_value();
+			values.insert(x.value_or(""));
+			++lookups;
+		} while (seconds_since(start) < 1);
+		const double seconds = seconds_since(start);
+
+		cout
+			<< setw(12) << name
+			<< setprecision(0)
+			<< setw(14) << lookups / seconds << endl;
+	}
+
+	cout << defaultfloat << endl;
+
+	success = success && values.size() == 1;
+	if (!success) cerr << "index: the fields are found wrong" << endl;
+	return success;
+}
+
+// Fields of a huge array: parsing all of it and taking the fields compared
+// with the selection that skips everything else
+bool bench_select()
+{
+	string document = "[";
+	for (size_t i = 0; document.size() < 32 * 1024 * 1024; ++i)
+		document += (i == 0 ? "" : ",") + make_document(i);
+	document += "]";
+	const double size_mib = double(document.size()) / 1024 / 1024;
+
+	// The fields of every document and the field of a single one
+	const vector<vector<string>> paths = {
+		{"*", "address", "city"},
+		{"1000", "age"},
+	};
+
+	// Serialized fields
+	using Engine = function<optional<string>(const vector<string> &path)>;
+	const vector<pair<string, Engine>> engines = {
+		{"full", [&document](const vector<string> &path) -> optional<string> {
+			auto result = parse_json_structural(document);
+			if (holds_alternative<ParsingError<I>>(result)) return nullopt;
+			string out;
+			size_t i = 0;
+			for (auto &x : get<0>(get<JsonArray>(get<JsonValue>(result)))) {
+				if (path[0] == "*" || path[0] == to_string(i))
+					out += serialize_json(
+						path.size() == 2
+							? get<0>(get<JsonObject>(x)).at(path[1])
+							: get<0>(get<JsonObject>(
+								get<0>(get<JsonObject>(x)).at(path[1])
+							)).at(path[2])
+					);
+				++i;
+			}
+			return out;
+		}},
+		{"select", [&document](const vector<string> &path) -> optional<string> {
+			auto result = select_json(document, {path});
+			if (holds_alternative<ParsingError<I>>(result)) return nullopt;
+			string out;
+			for (string_view x : get<vector<vector<string_view>>>(result)[0]) {
+				auto value = parse_json(x);
+				if (holds_alternative<ParsingError<I>>(value)) return nullopt;
+				out += serialize_json(get<JsonValue>(value));
+			}
+			return out;
+		}},
+	};
+
+	cout
+		<< "select: fields of a single array of " << fixed << setprecision(2)
+		<< size_mib << " MiB" << endl << endl
+		<< setw(22) << "path"
+		<< setw(10) << "engine"
+		<< setw(12) << "time, s"
+		<< setw(10) << "MiB/s" << endl;
+
+	bool success = true;
+	for (auto &path : paths) {
+		string pointer;
+		for (auto &x : path) pointer += "/" + x;
+
+		set<string> outputs;
+		for (auto &[ name, engine ] : engines) {
+			const Clock::time_point start = Clock::now();
+			const optional<string> out = engine(path);
+			const double seconds = seconds_since(start);
+			outputs.insert(out.value_or(""));
+
+			cout
+				<< setw(22) << pointer
+				<< setw(10) << name
+				<< setprecision(4)
+				<< setw(12) << seconds
+				<< setprecision(2)
+				<< setw(10) << size_mib / seconds << endl;
+		}
+		success = success && outputs.size() == 1 && !outputs.begin()->empty();
+	}
+
+	cout << defaultfloat << endl;
+
+	if (!success) cerr << "select: the fields are selected wrong" << endl;
+	return success;
+}
+
+// A huge array as a tree of “JsonValue” and as a flat tape: building it,
+// walking over all of its values and destroying it, and the memory it takes
+bool bench_tape()
+{
+	string document = "[";
+	for (size_t i = 0; document.size() < 32 * 1024 * 1024; ++i)
+		document += (i == 0 ? "" : ",") + make_document(i);
+	document += "]";
+	const double size_mib = double(document.size()) / 1024 / 1024;
+
+	// Number of the values that are not strings and the size of the strings
+	// (the keys included)
+	const function<size_t(const JsonValue&)> walk_tree =
+		[&walk_tree](const JsonValue &x) -> size_t {
+			return visit(overloaded {
+				[&walk_tree](const JsonObject &y) -> size_t {
+					size_t out = 1;
+					for (auto &[ key, value ] : get<0>(y))
+						out += key.size() + walk_tree(value);
+					return out;
+				},
+				[&walk_tree](const JsonArray &y) -> size_t {
+					size_t out = 1;
+					for (auto &value : get<0>(y)) out += walk_tree(value);
+					return out;
+				},
+				[](const JsonString &y) -> size_t {
+					return json_string_view(y).size();
+				},
+				[](const auto &) -> size_t { return 1; },
+			}, x);
+		};
+	// Same going through the tape forward (a key is a string as well)
+	const auto walk_tape = [](const JsonTape &x) -> size_t {
+		size_t out = 0;
+		for (size_t i = 0; i < x.words.size();) {
+			const JsonTapeValue value{&x, i};
+			const JsonValueKind kind = value.kind();
+			if (kind == JsonValueKind::String)
+				out += from_json_string(value)->size();
+			else if (kind != JsonValueKind::None)
+				++out;
+			i = kind == JsonValueKind::Object || kind == JsonValueKind::Array
+				? i + 1
+				: value.end();
+		}
+		return out;
+	};
+
+	cout
+		<< "tape: a single array of " << fixed << setprecision(2) << size_mib
+		<< " MiB as a tree and as a tape" << endl << endl
+		<< setw(12) << "document"
+		<< setw(10) << "parse, s"
+		<< setw(10) << "walk, s"
+		<< setw(13) << "destroy, s"
+		<< setw(14) << "allocations"
+		<< setw(10) << "MiB" << endl;
+
+	set<size_t> walks;
+	bool success = true;
+	for (bool flat : {false, true}) {
+		const size_t allocations_before = allocations_counter();
+		const size_t bytes_before = allocated_bytes_counter();
+		Clock::time_point start = Clock::now();
+		optional<JsonValue> tree;
+		optional<JsonTape> tape;
+		if (flat) {
+			auto x = parse_json_tape(document);
+			success = success && holds_alternative<JsonTape>(x);
+			if (holds_alternative<JsonTape>(x)) tape = move(get<JsonTape>(x));
+		} else {
+			auto x = parse_json_structural(document);
+			success = success && holds_alternative<JsonValue>(x);
+			if (holds_alternative<JsonValue>(x)) tree = move(get<JsonValue>(x));
+		}
+		const double parse_seconds = seconds_since(start);
+		const size_t allocations = allocations_counter() - allocations_before;
+		const size_t bytes = allocated_bytes_counter() - bytes_before;
+
+		start = Clock::now();
+		if (tape.has_value()) walks.insert(walk_tape(*tape));
+		if (tree.has_value()) walks.insert(walk_tree(*tree));
+		const double walk_seconds = seconds_since(start);
+
+		start = Clock::now();
+		tape.reset();
+		tree.reset();
+		const double destroy_seconds = seconds_since(start);
+
+		cout
+			<< setw(12) << (flat ? "tape" : "tree")
+			<< setprecision(3)
+			<< setw(10) << parse_seconds
+			<< setw(10) << walk_seconds
+			<< setw(13) << destroy_seconds
+			<< setw(14) << allocations
+			<< setprecision(2)
+			<< setw(10) << double(bytes) / 1024 / 1024 << endl;
+	}
+
+	cout << defaultfloat << endl;
+
+	success = success && walks.size() == 1;
+	if (!success) cerr << "tape: the documents are different" << endl;
+	return success;
+}
+
+// Members of objects of the same keys in a “std::map” (what objects were
+// before) or in “JsonMembers”: looking up every key of them (not in the order
+// they were added) “rounds” times. Only the lookups are measured, building
+// the members is not faster (see “json/ordered-map.hpp”).
+template <typename M>
+inline void bench_object_members(
+	const string &name,
+	const vector<string> &keys,
+	size_t objects,
+	size_t rounds,
+	set<int64_t> &sums
+)
+{
+	vector<M> list(objects);
+	for (size_t i = 0; i < objects; ++i)
+		for (size_t j = 0; j < keys.size(); ++j)
+			list[i].emplace(keys[j], JsonValue{make_json_number(i + j)});
+
+	const Clock::time_point start = Clock::now();
+	int64_t sum = 0;
+	for (size_t round = 0; round < rounds; ++round)
+		for (const M &x : list)
+			for (size_t j = 0; j < keys.size(); ++j) {
+				const JsonValue &value = x.at(keys[(j * 7) % keys.size()]);
+				sum += get<int64_t>(from_json_number(get<JsonNumber>(value)));
+			}
+	const double lookup_seconds = seconds_since(start);
+	sums.insert(sum);
+
+	const double members = double(objects * rounds * keys.size());
+	cout
+		<< setw(6) << keys.size()
+		<< setw(9) << objects
+		<< setw(14) << name
+		<< setw(12) << lookup_seconds * 1e9 / members << endl;
+}
+
+bool bench_objects()
+{
+	const vector<string> names = {
+		"id", "type", "name", "firstName", "lastName", "email", "isAlive",
+		"age", "address", "city", "state", "postalCode", "phoneNumbers",
+		"created_at", "updated_at", "tags", "description", "enabled", "score",
+		"parent",
+	};
+
+	cout
+		<< "objects: lookups of members of objects that are in the cache "
+		<< "(1000 objects)" << endl
+		<< "and of the ones that are not (200000 objects)" << endl << endl
+		<< setw(6) << "keys"
+		<< setw(9) << "objects"
+		<< setw(14) << "container"
+		<< setw(12) << "lookup, ns" << endl;
+
+	bool success = true;
+	cout << fixed << setprecision(1);
+	for (size_t n : {5, 10, 20})
+		for (auto [ objects, rounds ] : {pair(1000, 200), pair(200000, 1)}) {
+			const vector<string> keys(names.begin(), names.begin() + n);
+			set<int64_t> sums;
+			bench_object_members<map<string, JsonValue>>(
+				"std::map", keys, objects, rounds, sums
+			);
+			bench_object_members<JsonMembers>(
+				"JsonMembers", keys, objects, rounds, sums
+			);
+			success = success && sums.size() == 1;
+		}
+
+	cout << defaultfloat << endl;
+
+	if (!success) cerr << "objects: the values found are different" << endl;
+	return success;
+}
+
+// Arrays of integer numbers, of short fractional numbers and of full
+// precision numbers with exponents are parsed with the engines. The conversion
+// alone is compared with “strtoll”/“strtod” on the same numbers.
+bool bench_numbers()
+{
+	const size_t count = 200000;
+	vector<string> integer_tokens, fraction_tokens, double_tokens;
+	for (size_t i = 0; i < count; ++i) {
+		const size_t x = (i * 2654435761) % 2000000000;
+		integer_tokens.push_back(
+			(i % 3 == 0 ? "-" : "") + to_string(x >> (i % 24))
+		);
+		fraction_tokens.push_back(
+			to_string(x % 100000) + "." + to_string(1000000 + x % 7919)
+		);
+		char buffer[32];
+		snprintf(
+			buffer,
+			sizeof(buffer),
+			"%.17g",
+			(i % 2 == 0 ? -1.0 : 1.0) * (x + 0.5) * pow(10.0, int(i % 61) - 40)
+		);
+		double_tokens.push_back(buffer);
+	}
+
+	// Name, tokens, whether they are integer numbers and the JSON array of them
+	struct Dataset
+	{
+		string name;
+		const vector<string> *tokens;
+		bool integer;
+		string json;
+	};
+	vector<Dataset> datasets = {
+		{"integers", &integer_tokens, true, ""},
+		{"fractions", &fraction_tokens, false, ""},
+		{"doubles", &double_tokens, false, ""},
+	};
+	for (auto &x : datasets) {
+		x.json = "[";
+		for (auto &token : *x.tokens)
+			x.json += (x.json.size() == 1 ? "" : ",") + token;
+		x.json += "]";
+	}
+
+	bool success = true;
+
+	// Runs for about a second, returns millions of numbers per second
+	const auto measure = [&success, count](auto fn) -> double {
+		size_t passes = 0;
+		const Clock::time_point start = Clock::now();
+		do {
+			if (!fn()) success = false;
+			++passes;
+		} while (seconds_since(start) < 1);
+		return passes * count / seconds_since(start) / 1e6;
+	};
+
+	const auto parse_with = [](auto engine) {
+		return [engine](const Dataset &x) -> function<bool()> {
+			return [engine, &x]() {
+				return !holds_alternative<ParsingError<I>>(engine(x.json));
+			};
+		};
+	};
+
+	const auto scan_tokens = [](bool lazy) {
+		return [lazy](const Dataset &x) -> function<bool()> {
+			return [&x, lazy]() {
+				JsonNumber y;
+				for (auto &token : *x.tokens) {
+					size_t pos = 0;
+					if (scan_json_number(token, pos, y, lazy) != nullptr)
+						return false;
+				}
+				return true;
+			};
+		};
+	};
+
+	const auto convert_tokens = [](const Dataset &x) -> function<bool()> {
+		return [&x]() {
+			double sum = 0;
+			for (auto &token : *x.tokens)
+				sum += x.integer
+					? double(strtoll(token.c_str(), nullptr, 10))
+					: strtod(token.c_str(), nullptr);
+			return sum == sum;
+		};
+	};
+
+	const auto combinators = [](I x) { return parse_json(x); };
+	const auto structural = [](I x) { return parse_json_structural(x); };
+	JsonParsingOptions lazy;
+	lazy.lazy_numbers = true;
+	const auto lazy_structural = [&lazy](I x) {
+		return parse_json_structural(x, lazy);
+	};
+
+	const vector<pair<string, function<function<bool()>(const Dataset&)>>> runs = {
+		{"combinators", parse_with(combinators)},
+		{"structural", parse_with(structural)},
+		{"lazy structural", parse_with(lazy_structural)},
+		{"scanner", scan_tokens(false)},
+		{"lazy scanner", scan_tokens(true)},
+		{"strtoll/strtod", convert_tokens},
+	};
+
+	cout << "numbers: arrays of " << count << " numbers (";
+	for (auto &x : datasets)
+		cout
+			<< (&x == &datasets.front() ? "" : ", ")
+			<< x.name << " " << x.json.size() / 1024 << " KiB";
+	cout << ")" << endl << endl << setw(16) << "";
+	for (auto &x : datasets) cout << setw(16) << x.name + ", M/s";
+	cout << endl;
+
+	for (auto &run : runs) {
+		cout << fixed << setprecision(2) << setw(16) << run.first;
+		for (auto &x : datasets) cout << setw(16) << measure(run.second(x));
+		cout << endl;
+	}
+
+	cout << defaultfloat << endl;
+
+	if (!success) cerr << "numbers: failed to parse the numbers" << endl;
+	return success;
+}
+
+// A string-heavy array is parsed with the strings copied out of the input and
+// with the strings shared with the input (see “shared_input” parsing option)
+bool bench_strings()
+{
+	const size_t count = 200000;
+	string array = "[";
+	for (size_t i = 0; i < count; ++i) {
+		string x = "value #" + to_string(i) + " " + string(10 + i * 7 % 60, 'x');
+		// Some of the strings have escapes (so they are still copied)
+		if (i % 10 == 0) x += "\\n";
+		array += (i == 0 ? "\"" : ",\"") + x + "\"";
+	}
+	array += "]";
+	const auto input = make_shared<const string>(move(array));
+
+	JsonParsingOptions shared;
+	shared.shared_input = input;
+
+	// Heap memory taken by the strings of the array
+	const auto strings_size = [](const JsonValue &x) {
+		size_t size = 0;
+		for (auto &y : get<0>(get<JsonArray>(x))) {
+			auto s = get_if<string>(&get<0>(get<JsonString>(y)));
+			if (s != nullptr && s->capacity() > string().capacity())
+				size += s->capacity() + 1;
+		}
+		return size;
+	};
+
+	using Engine = function<variant<ParsingError<I>, JsonValue>(I)>;
+	const vector<pair<string, Engine>> engines = {
+		{"combinators", [](I x) { return parse_json(x); }},
+		{"combinators/shared", [&shared](I x) { return parse_json(x, shared); }},
+		{"structural", [](I x) { return parse_json_structural(x); }},
+		{"structural/shared", [&shared](I x) {
+			return parse_json_structural(x, shared);
+		}},
+	};
+	bool success = true;
+
+	cout
+		<< "strings: parsing an array of " << count << " strings ("
+		<< input->size() / 1024 << " KiB), copied or shared with the input"
+		<< endl << endl
+		<< setw(20) << "engine"
+		<< setw(10) << "MiB/s"
+		<< setw(14) << "allocations"
+		<< setw(16) << "strings, KiB" << endl;
+
+	for (auto &[ name, engine ] : engines) {
+		size_t passes = 0;
+		size_t allocations = 0;
+		size_t size = 0;
+		const Clock::time_point start = Clock::now();
+		do {
+			const size_t allocations_before = allocations_counter();
+			auto x = engine(*input);
+			allocations = allocations_counter() - allocations_before;
+			if (holds_alternative<JsonValue>(x))
+				size = strings_size(get<JsonValue>(x));
+			else
+				success = false;
+			++passes;
+		} while (seconds_since(start) < 1);
+		const double seconds = seconds_since(start);
+
+		cout
+			<< fixed << setprecision(2)
+			<< setw(20) << name
+			<< setw(10) << passes * input->size() / seconds / 1024 / 1024
+			<< setw(14) << allocations
+			<< setw(16) << size / 1024 << endl;
+	}
+
+	cout << defaultfloat << endl;
+
+	if (!success) cerr << "strings: failed to parse the array" << endl;
+	return success;
+}
+
+// UTF-8 validation of 64 MiB of ASCII documents and of 64 MiB of text in
+// a mix of scripts (every input is validated for about a second)
+bool bench_utf8()
+{
+	string ascii;
+	for (size_t i = 0; ascii.size() < 64 * 1024 * 1024; ++i)
+		ascii += make_document(i);
+
+	const vector<string> words = {
+		"JSON ", "données ", "Größe ", "данные ", "δεδομένα ", "データ ",
+		"数据 ", "데이터 ", "بيانات ", "😀🎉 ",
+	};
+	string mixed;
+	for (size_t i = 0; mixed.size() < 64 * 1024 * 1024; ++i)
+		mixed += words[i * 7 % words.size()];
+
+	const vector<pair<string, const string*>> inputs = {
+		{"ascii", &ascii},
+		{"mixed", &mixed},
+	};
+	bool success = true;
+
+	cout
+		<< "utf8: validating 64 MiB inputs for about a second each" << endl
+		<< endl
+		<< setw(10) << "input"
+		<< setw(10) << "GiB/s" << endl;
+
+	for (auto &[ name, input ] : inputs) {
+		size_t passes = 0;
+		const Clock::time_point start = Clock::now();
+		do {
+			size_t pos = 0;
+			if (validate_utf8(*input, pos) != nullptr) success = false;
+			++passes;
+		} while (seconds_since(start) < 1);
+		const double seconds = seconds_since(start);
+
+		cout
+			<< fixed << setprecision(2)
+			<< setw(10) << name
+			<< setw(10) << passes * input->size() / seconds / 1024 / 1024 / 1024
+			<< endl;
+	}
+
+	cout << defaultfloat << endl;
+
+	if (!success) cerr << "utf8: valid input is rejected" << endl;
+	return success;
+}
+
+// }}}1
+
+
+struct Benchmark
+{
+	string name;
+	function<bool()> run;
+};
+
+int run_benchmarks(const vector<string> &names)
+{
+	const vector<Benchmark> benchmarks = {
+		{"threads", bench_threads},
+		{"engines", bench_engines},
+		{"depth", bench_depth},
+		{"huge", bench_huge},
+		{"cursor", bench_cursor},
+		{"lazy", bench_lazy},
+		{"transcode", bench_transcode},
+		{"ndjson", bench_ndjson},
+		{"incremental", bench_incremental},
+		{"index", bench_index},
+		{"select", bench_select},
+		{"tape", bench_tape},
+		{"objects", bench_objects},
+		{"numbers", bench_numbers},
+		{"strings", bench_strings},
+		{"utf8", bench_utf8},
+	};
+
+	for (auto &name : names)
+		if (none_of(
+			benchmarks.begin(),
+			benchmarks.end(),
+			[&name](const Benchmark &x) { return x.name == name; }
+		)) {
+			cerr << "Unknown benchmark: " << quoted(name) << endl;
+			cerr << "Available benchmarks:";
+			for (auto &x : benchmarks) cerr << " " << x.name;
+			cerr << endl;
+			return EXIT_FAILURE;
+		}
+
+	bool success = true;
+
+	for (auto &x : benchmarks)
+		if (names.empty() || find(names.begin(), names.end(), x.name) != names.end())
+			success = x.run() && success;
+
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
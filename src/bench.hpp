@@ -0,0 +1,10 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+// Run the benchmarks by their names (all of them if the list is empty)
+int run_benchmarks(const vector<string> &names);
@@ -54,6 +54,9 @@ inline string chars_to_string(T<char> list)
 
 // curry {{{1
 
+// The last argument is moved into the function (it is not needed after the
+// call), the others are kept by the partial applications, so they are copied.
+
 template <typename R, typename A>
 // Idempotency
 inline function<R(A)> curry(function<R(A)> fn)
@@ -64,14 +67,14 @@ inline function<R(A)> curry(function<R(A)> fn)
 template <typename R, typename A, typename B>
 inline function<function<R(B)>(A)> curry(function<R(A, B)> fn)
 {
-	return [=](A a) { return [=](B b) { return fn(a, b); }; };
+	return [=](A a) { return [=](B b) { return fn(a, move(b)); }; };
 }
 
 template <typename R, typename A, typename B, typename C>
 inline function<function<function<R(C)>(B)>(A)> curry(function<R(A, B, C)> fn)
 {
 	return [=](A a) { return [=](B b) { return [=](C c) {
-		return fn(a, b, c);
+		return fn(a, b, move(c));
 	}; }; };
 }
 
@@ -81,7 +84,7 @@ inline function<function<function<function<R(D)>(C)>(B)>(A)> curry(
 )
 {
 	return [=](A a) { return [=](B b) { return [=](C c) { return [=](D d) {
-		return fn(a, b, c, d);
+		return fn(a, b, c, move(d));
 	}; }; }; };
 }
 
@@ -91,7 +94,7 @@ inline function<function<function<function<function<R(E)>(D)>(C)>(B)>(A)> curry(
 )
 {
 	return [=](A a) { return [=](B b) { return [=](C c) { return [=](D d) {
-		return [=](E e) { return fn(a, b, c, d, e); };
+		return [=](E e) { return fn(a, b, c, d, move(e)); };
 	}; }; }; };
 }
 
@@ -111,7 +114,9 @@ inline function<function<function<function<function<function<
 )
 {
 	return [=](A a) { return [=](B b) { return [=](C c) { return [=](D d) {
-		return [=](E e) { return [=](F f) { return fn(a, b, c, d, e, f); }; };
+		return [=](E e) { return [=](F f) {
+			return fn(a, b, c, d, e, move(f));
+		}; };
 	}; }; }; };
 }
 
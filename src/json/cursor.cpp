@@ -0,0 +1,347 @@
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+
+#include "json/cursor.hpp"
+#include "json/scanners.hpp"
+#include "json/types.hpp"
+#include "parser/types.hpp"
+
+using namespace std;
+
+// Local shorthand
+using I = ParserInputType<Parser>;
+
+
+JsonCursor::JsonCursor(I input, JsonParsingOptions options):
+	input(input),
+	options(move(options))
+{
+	skip_spacer();
+	has_value = true;
+}
+
+// Helpers {{{1
+
+bool JsonCursor::fail(const char *message)
+{
+	// Only the first failure is kept
+	if (failure == nullptr) {
+		failure = message;
+		failure_pos = pos;
+	}
+	return false;
+}
+
+void JsonCursor::skip_spacer()
+{
+	while (pos < input.size() && is_json_spacer(input[pos])) ++pos;
+}
+
+bool JsonCursor::expect_value(char c, const char *message)
+{
+	if (failure != nullptr) return false;
+	if (!has_value) return fail("JsonCursor: there is no value at the cursor");
+	if (pos >= input.size()) return fail("JsonValue: value is expected");
+	// Any number start when “c” is a digit
+	if (c == '0' ? !is_json_number_start(input[pos]) : input[pos] != c)
+		return fail(message);
+	return true;
+}
+
+bool JsonCursor::done_value()
+{
+	has_value = false;
+	skip_spacer();
+	return true;
+}
+
+bool JsonCursor::enter(bool is_object)
+{
+	if (!expect_value(
+		is_object ? '{' : '[',
+		is_object
+			? "JsonCursor: object is expected"
+			: "JsonCursor: array is expected"
+	)) return false;
+
+	++pos;
+	has_value = false;
+	skip_spacer();
+	frames.push_back(Frame{is_object, true, pos});
+	return true;
+}
+
+JsonCursor::Step JsonCursor::step(bool is_object, string_view *key)
+{
+	if (failure != nullptr) return Step::Failure;
+	if (frames.empty() || frames.back().is_object != is_object) {
+		fail(
+			is_object
+				? "JsonCursor: the cursor is not in an object"
+				: "JsonCursor: the cursor is not in an array"
+		);
+		return Step::Failure;
+	}
+	if (has_value && !skip()) return Step::Failure;
+
+	Frame &frame = frames.back();
+	if (pos < input.size() && input[pos] == (is_object ? '}' : ']'))
+		return Step::End;
+
+	if (!frame.first) {
+		if (pos >= input.size() || input[pos] != ',') {
+			fail(
+				is_object
+					? "JsonObject: “}” is expected"
+					: "JsonArray: “]” is expected"
+			);
+			return Step::Failure;
+		}
+		++pos;
+		skip_spacer();
+	}
+
+	if (is_object) {
+		if (pos >= input.size() || input[pos] != '"') {
+			fail("JsonObject: key is expected");
+			return Step::Failure;
+		}
+		if (const char *err = scan_json_string(input, pos, *key, buffer)) {
+			fail(err);
+			return Step::Failure;
+		}
+		skip_spacer();
+		if (pos >= input.size() || input[pos] != ':') {
+			fail("JsonObject: “:” is expected");
+			return Step::Failure;
+		}
+		++pos;
+		skip_spacer();
+	}
+
+	frame.first = false;
+	has_value = true;
+	return Step::Value;
+}
+
+// }}}1
+
+// Values {{{1
+
+JsonValueKind JsonCursor::peek() const
+{
+	if (failure != nullptr || !has_value || pos >= input.size())
+		return JsonValueKind::None;
+
+	switch (input[pos]) {
+		case '{': return JsonValueKind::Object;
+		case '[': return JsonValueKind::Array;
+		case '"': return JsonValueKind::String;
+		case 't': case 'f': return JsonValueKind::Bool;
+		case 'n': return JsonValueKind::Null;
+		default:
+			return is_json_number_start(input[pos])
+				? JsonValueKind::Number
+				: JsonValueKind::None;
+	}
+}
+
+bool JsonCursor::get_string(string_view &out)
+{
+	if (!expect_value('"', "JsonCursor: string is expected")) return false;
+	if (const char *err = scan_json_string(input, pos, out, buffer))
+		return fail(err);
+	return done_value();
+}
+
+bool JsonCursor::get_number(JsonNumber &out)
+{
+	if (!expect_value('0', "JsonCursor: number is expected")) return false;
+	const char *err = scan_json_number(
+		input,
+		pos,
+		out,
+		options.lazy_numbers,
+		options.shared_input
+	);
+	if (err != nullptr) return fail(err);
+	return done_value();
+}
+
+bool JsonCursor::get_int64(int64_t &out)
+{
+	const size_t start = pos;
+	JsonNumber x;
+	if (!get_number(x)) return false;
+
+	const JsonNumberValue value = from_json_number(move(x));
+	if (const int64_t *y = get_if<int64_t>(&value)) {
+		out = *y;
+		return true;
+	}
+	pos = start;
+	return fail("JsonCursor: “int64_t” number is expected");
+}
+
+bool JsonCursor::get_double(double &out)
+{
+	JsonNumber x;
+	if (!get_number(x)) return false;
+	out = visit(
+		[](auto y) { return double(y); },
+		from_json_number(move(x))
+	);
+	return true;
+}
+
+bool JsonCursor::get_bool(bool &out)
+{
+	if (failure != nullptr) return false;
+	const bool x = pos < input.size() && input[pos] == 't';
+	const string_view literal = x ? "true" : "false";
+	if (!expect_value(literal[0], "JsonCursor: boolean is expected")) return false;
+	if (input.substr(pos, literal.size()) != literal)
+		return fail("JsonValue: unexpected literal");
+	pos += literal.size();
+	out = x;
+	return done_value();
+}
+
+bool JsonCursor::get_null()
+{
+	if (!expect_value('n', "JsonCursor: null is expected")) return false;
+	if (input.substr(pos, 4) != "null")
+		return fail("JsonValue: unexpected literal");
+	pos += 4;
+	return done_value();
+}
+
+bool JsonCursor::get_source(string_view &out)
+{
+	if (failure != nullptr) return false;
+	if (!has_value) return fail("JsonCursor: there is no value at the cursor");
+	if (pos >= input.size()) return fail("JsonValue: value is expected");
+	const size_t start = pos;
+	if (const char *err = skip_json_value(input, pos)) return fail(err);
+	out = input.substr(start, pos - start);
+	return done_value();
+}
+
+// }}}1
+
+// Moving around {{{1
+
+bool JsonCursor::enter_object()
+{
+	return enter(true);
+}
+
+bool JsonCursor::enter_array()
+{
+	return enter(false);
+}
+
+bool JsonCursor::next_key(string_view &key)
+{
+	switch (step(true, &key)) {
+		case Step::Value: return true;
+		case Step::Failure: return false;
+		case Step::End: break;
+	}
+	++pos; // Skipping “}”
+	frames.pop_back();
+	done_value();
+	return false;
+}
+
+bool JsonCursor::find_key(string_view key)
+{
+	if (failure != nullptr) return false;
+	if (frames.empty() || !frames.back().is_object)
+		return fail("JsonCursor: the cursor is not in an object");
+	if (has_value && !skip()) return false;
+
+	// Where to stop after wrapping around
+	const size_t start = pos;
+	const bool start_first = frames.back().first;
+
+	string_view x;
+	for (bool wrapped = false; !wrapped || pos != start;) {
+		switch (step(true, &x)) {
+			case Step::Failure:
+				return false;
+			case Step::End:
+				if (wrapped) return fail("JsonObject: “}” is expected");
+				wrapped = true;
+				pos = frames.back().begin;
+				frames.back().first = true;
+				break;
+			case Step::Value:
+				if (x == key) return true;
+				if (!skip()) return false;
+		}
+	}
+
+	// Not found, going back to where the search started
+	frames.back().first = start_first;
+	return false;
+}
+
+bool JsonCursor::next_element()
+{
+	switch (step(false, nullptr)) {
+		case Step::Value: return true;
+		case Step::Failure: return false;
+		case Step::End: break;
+	}
+	++pos; // Skipping “]”
+	frames.pop_back();
+	done_value();
+	return false;
+}
+
+bool JsonCursor::skip()
+{
+	string_view x;
+	return get_source(x);
+}
+
+bool JsonCursor::leave()
+{
+	if (failure != nullptr) return false;
+	if (frames.empty())
+		return fail("JsonCursor: the cursor is not in an object or an array");
+	// A value at the cursor is skipped along with the rest
+	if (const char *err = skip_json_nesting(input, pos, 1)) return fail(err);
+	frames.pop_back();
+	return done_value();
+}
+
+bool JsonCursor::finish()
+{
+	if (failure != nullptr) return false;
+
+	if (!frames.empty()) {
+		if (const char *err = skip_json_nesting(input, pos, frames.size()))
+			return fail(err);
+		frames.clear();
+		done_value();
+	} else if (has_value && !skip()) {
+		return false;
+	}
+
+	if (pos < input.size()) return fail("end_of_input: input is not empty");
+	return true;
+}
+
+optional<ParsingError<I>> JsonCursor::error() const
+{
+	if (failure == nullptr) return nullopt;
+	return make_parsing_error<I>(failure, input.substr(failure_pos));
+}
+
+// }}}1
@@ -0,0 +1,135 @@
+#pragma once
+
+// Pull-style (on-demand) parsing: the caller walks the document with a cursor
+// and only the values it asks for are parsed. Everything else (values of the
+// other keys, the rest of an array) is skipped by matching the brackets and
+// the quotes, without building anything.
+//
+// The cursor moves only forward. Every call returns whether it succeeded.
+// When the input is malformed or the cursor is misused, the first error is
+// kept (see “error”) and every call after it fails.
+//
+// Mind that the skipped values are not validated (only their brackets and
+// quotes are matched), so a document with a malformed value that is never
+// touched is accepted. Use “parse_json_events” from “json/sax.hpp” to
+// validate the whole document.
+//
+// A decoder of some data type looks like this (see “in_key” from
+// “json/data-modeling/parsers.hpp” for the same over a “JsonValue”):
+//
+//   JsonCursor cursor(input);
+//   string_view city;
+//   bool ok =
+//     cursor.enter_object() &&
+//     cursor.find_key("address") && cursor.enter_object() &&
+//     cursor.find_key("city") && cursor.get_string(city);
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "json/types.hpp"
+#include "parser/types.hpp"
+
+using namespace std;
+
+
+class JsonCursor
+{
+public:
+	// Only “lazy_numbers” option makes a difference here. The cursor starts
+	// at the root value.
+	explicit JsonCursor(
+		ParserInputType<Parser> input,
+		JsonParsingOptions options = {}
+	);
+
+	// Takes a look at the first character of the value at the cursor (“None”
+	// when there is no value at the cursor or after a failure)
+	JsonValueKind peek() const;
+
+	// Scalar values at the cursor. Strings are views either into the input or
+	// into a buffer of the cursor when there were escapes (so they are valid
+	// until the next call).
+	bool get_string(string_view &out);
+	bool get_number(JsonNumber &out);
+	// Fails when the number is not an integer that fits into “int64_t”
+	bool get_int64(int64_t &out);
+	// Any number
+	bool get_double(double &out);
+	bool get_bool(bool &out);
+	bool get_null();
+	// Source text of the value (to be parsed with one of the engines), the
+	// value is only skipped like with “skip”
+	bool get_source(string_view &out);
+
+	// Moves into the object or the array at the cursor. Then there is no value
+	// at the cursor until “next_key”/“find_key”/“next_element” is called.
+	bool enter_object();
+	bool enter_array();
+
+	// Moves to the value of the next key of the object the cursor is in (the
+	// value at the cursor that was not used is skipped). At the end of the
+	// object it returns “false” and leaves the object (that is not an error).
+	bool next_key(string_view &key);
+
+	// Moves to the value of the key. The search goes forward from the cursor
+	// and then wraps around to the beginning of the object once, so the
+	// order of the keys does not matter (but looking up the keys in the order
+	// they are in the document is faster). When the key is not found it
+	// returns “false” and the cursor stays in the object (that is not an
+	// error either).
+	bool find_key(string_view key);
+
+	// Moves to the next element of the array the cursor is in (the value at
+	// the cursor that was not used is skipped). At the end of the array it
+	// returns “false” and leaves the array (not an error).
+	bool next_element();
+
+	// Skips the value at the cursor
+	bool skip();
+	// Skips the rest of the object or the array the cursor is in and leaves it
+	bool leave();
+	// Leaves everything and checks that there is nothing after the root value
+	bool finish();
+
+	// The first failure (the tail of the error starts where the failure is)
+	optional<ParsingError<ParserInputType<Parser>>> error() const;
+
+private:
+	// An object or an array the cursor is in
+	struct Frame
+	{
+		bool is_object;
+		// Nothing was read in it yet
+		bool first;
+		// Where the first key or element is (for “find_key”)
+		size_t begin;
+	};
+
+	// Result of moving to the next key or element
+	enum class Step { Value, End, Failure };
+
+	ParserInputType<Parser> input;
+	JsonParsingOptions options;
+	size_t pos = 0;
+	// There is a value at “pos” that was not read yet
+	bool has_value = false;
+	vector<Frame> frames;
+	// For the strings with escapes
+	string buffer;
+	const char *failure = nullptr;
+	size_t failure_pos = 0;
+
+	bool fail(const char *message);
+	void skip_spacer();
+	// Checks that there is a value at the cursor and that it starts with “c”
+	bool expect_value(char c, const char *message);
+	// Every read value is followed by this
+	bool done_value();
+	bool enter(bool is_object);
+	Step step(bool is_object, string_view *key);
+};
@@ -1,4 +1,3 @@
-#include <map>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -75,7 +74,7 @@ FromJsonParser<ExampleType> from_json()
 template <>
 JsonValue to_json(ExampleTypeAddress x)
 {
-	map<string, JsonValue> obj = {
+	JsonMembers obj = {
 		{"streetAddress", to_json(x.street_address)},
 		{"city", to_json(x.city)},
 		{"state", to_json(x.state)},
@@ -87,7 +86,7 @@ JsonValue to_json(ExampleTypeAddress x)
 template <>
 JsonValue to_json(ExampleTypePhoneNumber x)
 {
-	map<string, JsonValue> obj = {
+	JsonMembers obj = {
 		{"type", to_json(x.type)},
 		{"number", to_json(x.number)},
 	};
@@ -97,7 +96,7 @@ JsonValue to_json(ExampleTypePhoneNumber x)
 template <>
 JsonValue to_json(ExampleType x)
 {
-	map<string, JsonValue> obj = {
+	JsonMembers obj = {
 		{"firstName", to_json(x.first_name)},
 		{"lastName", to_json(x.last_name)},
 		{"isAlive", to_json(x.is_alive)},
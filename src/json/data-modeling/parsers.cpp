@@ -1,4 +1,5 @@
-#include <map>
+#include <cstdint>
+#include <limits>
 #include <optional>
 #include <string>
 #include <type_traits>
@@ -7,6 +8,7 @@
 #include <vector>
 
 #include "abstractions/functor.hpp"
+#include "abstractions/monad.hpp"
 #include "json/data-modeling/parsers.hpp"
 
 using namespace std;
@@ -79,7 +81,7 @@ FromJsonParser<JsonNull> from_json()
 // Parsing raw types from JSON types {{{2
 
 template <>
-FromJsonParser<map<string, JsonValue>> from_json()
+FromJsonParser<JsonMembers> from_json()
 {
 	return function(from_json_object) ^ from_json<JsonObject>();
 }
@@ -97,45 +99,65 @@ FromJsonParser<string> from_json()
 }
 
 template <>
-FromJsonParser<variant<int, double>> from_json()
+FromJsonParser<JsonNumberValue> from_json()
 {
-	return function(from_json_number) ^ from_json<JsonNumber>();
+	return function<JsonNumberValue(JsonNumber)>(from_json_number)
+		^ from_json<JsonNumber>();
+}
+
+// Whether an integer value fits into “T” (signed and unsigned types are
+// compared safely)
+template <typename T, typename V>
+inline bool in_integer_bounds(V x)
+{
+	if constexpr (is_signed_v<V>)
+		if (x < 0)
+			return
+				is_signed_v<T> &&
+				intmax_t(x) >= intmax_t(numeric_limits<T>::min());
+	return uintmax_t(x) <= uintmax_t(numeric_limits<T>::max());
 }
 
 template <typename T>
 inline FromJsonParser<T> parse_number_helper(string type_name) {
 	return prefix_parsing_failure<T>(
 		type_name,
-		FromJsonParser<T>{[type_name](I input) {
-			return visit(overloaded {
-				[](ParsingError<I> err) -> ParsingResult<T, I> { return err; },
-				[type_name, input](
-					ParsingSuccess<variant<int, double>, I> x
+		from_json<JsonNumberValue>() >>= [type_name](JsonNumberValue number) {
+			return [&type_name, number](I input) -> ParsingResult<T, I> {
+				return visit([&type_name, &input](
+					auto&& value
 				) -> ParsingResult<T, I> {
-					return visit([type_name, input, x](
-						auto&& value
-					) -> ParsingResult<T, I> {
-						using ValueT = decay_t<decltype(value)>;
+					using ValueT = decay_t<decltype(value)>;
 
-						if constexpr (is_same_v<ValueT, T>)
-							return make_parsing_success<T, I>(value, x.second);
+					if constexpr (is_same_v<ValueT, T>)
+						return make_parsing_success<T, I>(value, input);
 
-						// It’s okay to to cast “int” to “double”
-						else if constexpr (
-							is_same_v<T, int> && is_same_v<ValueT, double>
-						)
-							return make_parsing_success<T, I>(value, x.second);
+					// It’s okay to convert any integer number to “double”
+					else if constexpr (
+						is_same_v<T, double> && is_integral_v<ValueT>
+					)
+						return make_parsing_success<T, I>(value, input);
 
+					// Integer numbers are okay if they are in bounds
+					else if constexpr (is_integral_v<T> && is_integral_v<ValueT>)
+						if (in_integer_bounds<T>(value))
+							return make_parsing_success<T, I>(T(value), input);
 						else
 							return make_parsing_error<I>(
-								"JsonNumber: Failed to extract " + type_name +
-								" from variant<int, double>",
+								"JsonNumber: " + to_string(value) +
+								" is out of " + type_name + " bounds",
 								input
 							);
-					}, x.first);
-				}
-			}, from_json<variant<int, double>>()(input));
-		}}
+
+					else
+						return make_parsing_error<I>(
+							"JsonNumber: Failed to extract " + type_name +
+							" from a fractional number",
+							input
+						);
+				}, number);
+			};
+		}
 	);
 }
 
@@ -156,25 +178,20 @@ FromJsonParser<uint8_t> from_json()
 {
 	return prefix_parsing_failure<uint8_t>(
 		"uint8_t",
-		FromJsonParser<uint8_t>{[](I input) {
-			return visit(overloaded {
-				[](ParsingError<I> err) -> ParsingResult<uint8_t, I> {
-					return err;
-				},
-				[input](ParsingSuccess<int, I> x) -> ParsingResult<uint8_t, I> {
-					uint8_t y = x.first;
-					if (x.first == y)
-						return make_parsing_success<uint8_t, I>(y, x.second);
-					else
-						return make_parsing_error<I>(
-							"Failed to get uint8_t from int (the number " +
-							to_string(x.first) +
-							" either overflows or underflows uint8_t)",
-							input
-						);
-				}
-			}, from_json<int>()(input));
-		}}
+		from_json<int>() >>= [](int x) {
+			return [x](I input) -> ParsingResult<uint8_t, I> {
+				uint8_t y = x;
+				if (x == y)
+					return make_parsing_success<uint8_t, I>(y, input);
+				else
+					return make_parsing_error<I>(
+						"Failed to get uint8_t from int (the number " +
+						to_string(x) +
+						" either overflows or underflows uint8_t)",
+						input
+					);
+			};
+		}
 	);
 }
 
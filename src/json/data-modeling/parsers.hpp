@@ -3,7 +3,6 @@
 #include <functional>
 #include <iomanip>
 #include <list>
-#include <map>
 #include <optional>
 #include <string>
 #include <type_traits>
@@ -12,6 +11,7 @@
 #include <vector>
 
 #include "../../helpers.hpp"
+#include "abstractions/monad.hpp"
 #include "json/data-modeling/types.hpp"
 
 using namespace std;
@@ -36,48 +36,46 @@ FromJsonParser<F<A>> from_json(FromJsonParser<A> item_parser)
 {
 	using T = F<A>;
 	using I = ParserInputType<FromJsonParser>;
-	return FromJsonParser<T>{[item_parser](I input) {
-		using R = ParsingResult<T, I>;
-		return visit(overloaded {
-			[](ParsingError<I> err) -> R { return err; },
-			[input, item_parser](ParsingSuccess<vector<JsonValue>, I> x) -> R {
-				T mapped_list;
-
-				for (size_t i = 0; i < x.first.size(); ++i) {
-					optional<ParsingError<I>> failure = nullopt;
+	return from_json<vector<JsonValue>>() >>= [item_parser](
+		vector<JsonValue> items
+	) {
+		return [&item_parser, items = move(items)](I input) -> ParsingResult<T, I> {
+			T mapped_list;
 
-					list<string> json_path = x.second.second;
-					json_path.push_back("[" + to_string(i) + "]");
-					I item_input = make_pair(x.first[i], json_path);
+			for (size_t i = 0; i < items.size(); ++i) {
+				optional<ParsingError<I>> failure = nullopt;
 
-					visit(overloaded {
-						[&failure](ParsingError<I> err) {
-							failure = make_parsing_error<I>(
-								// TODO print type that was targered to be parsed
-								"Failed to parse JsonArray item: " + err.first,
-								err.second
-							);
-						},
-						[&mapped_list](ParsingSuccess<A, I> y) {
-							mapped_list.push_back(y.first);
-						}
-					}, item_parser(item_input));
+				list<string> json_path = input.second;
+				json_path.push_back("[" + to_string(i) + "]");
+				I item_input = make_pair(items[i], json_path);
 
-					if (failure != nullopt)
-						return failure.value();
-				}
+				visit(overloaded {
+					[&failure](ParsingError<I> err) {
+						failure = make_parsing_error<I>(
+							// TODO print type that was targered to be parsed
+							"Failed to parse JsonArray item: " + err.first,
+							err.second
+						);
+					},
+					[&mapped_list](ParsingSuccess<A, I> y) {
+						mapped_list.push_back(y.first);
+					}
+				}, item_parser(item_input));
 
-				return make_parsing_success<T, I>(mapped_list, input);
+				if (failure != nullopt)
+					return failure.value();
 			}
-		}, from_json<vector<JsonValue>>()(input));
-	}};
+
+			return make_parsing_success<T, I>(mapped_list, input);
+		};
+	};
 }
 
 template <typename T>
 FromJsonParser<T> in_key(string k, FromJsonParser<T> parser)
 {
 	using I = ParserInputType<FromJsonParser>;
-	using M = map<string, JsonValue>;
+	using M = JsonMembers;
 	using R = ParsingResult<T, I>;
 
 	ostringstream prefix;
@@ -94,25 +92,22 @@ FromJsonParser<T> in_key(string k, FromJsonParser<T> parser)
 
 	return prefix_parsing_failure<T>(
 		prefix.str(),
-		FromJsonParser<T>{[k, parser, override_input](I input) {
-			return visit(overloaded {
-				[](ParsingError<I> err) -> R { return err; },
-				[k, parser, input, override_input](ParsingSuccess<M, I> x) -> R {
-					M::iterator it = x.first.find(k);
-					if (it == x.first.end()) {
-						ostringstream err_msg;
-						err_msg << "Key " << quoted(k) << " is not found";
-						return make_parsing_error<I>(err_msg.str(), x.second);
-					} else {
-						JsonPath new_path = x.second.second;
-						new_path.push_back(k);
-						return override_input(
-							input,
-							parser(make_pair(it->second, new_path))
-						);
-					}
+		from_json<M>() >>= [k, parser, override_input](M x) {
+			return [&k, &parser, &override_input, x = move(x)](I input) -> R {
+				M::const_iterator it = x.find(k);
+				if (it == x.end()) {
+					ostringstream err_msg;
+					err_msg << "Key " << quoted(k) << " is not found";
+					return make_parsing_error<I>(err_msg.str(), input);
+				} else {
+					JsonPath new_path = input.second;
+					new_path.push_back(k);
+					return override_input(
+						input,
+						parser(make_pair(it->second, new_path))
+					);
 				}
-			}, from_json<M>()(input));
-		}}
+			};
+		}
 	);
 }
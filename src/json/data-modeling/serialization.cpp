@@ -1,4 +1,3 @@
-#include <map>
 #include <variant>
 #include <vector>
 
@@ -59,7 +58,7 @@ JsonValue to_json(bool x)
 }
 
 template <>
-JsonValue to_json(variant<int, double> x)
+JsonValue to_json(JsonNumberValue x)
 {
 	return to_json<JsonNumber>(make_json_number(x));
 }
@@ -67,13 +66,13 @@ JsonValue to_json(variant<int, double> x)
 template <>
 JsonValue to_json(int x)
 {
-	return to_json<variant<int, double>>(x);
+	return to_json<JsonNumberValue>(x);
 }
 
 template <>
 JsonValue to_json(double x)
 {
-	return to_json<variant<int, double>>(x);
+	return to_json<JsonNumberValue>(x);
 }
 
 template <>
@@ -95,7 +94,7 @@ JsonValue to_json(vector<JsonValue> x)
 }
 
 template <>
-JsonValue to_json(map<string, JsonValue> x)
+JsonValue to_json(JsonMembers x)
 {
 	return to_json<JsonObject>(make_json_object(x));
 }
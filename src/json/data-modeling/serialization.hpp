@@ -20,8 +20,9 @@ template <
 >
 JsonValue to_json(F<A> list)
 {
+	// Calling “to_json” with the list of values would pick this overload again
 	if constexpr (is_same_v<F<A>, vector<JsonValue>>) {
-		return to_json(list);
+		return make_json_value(make_json_array(move(list)));
 	} else {
 		vector<JsonValue> arr;
 		for (auto x : list) arr.push_back(to_json(x));
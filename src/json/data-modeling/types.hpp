@@ -72,6 +72,19 @@ inline FromJsonParser<B> apply(
 	return apply<A, B, FromJsonParser>(fn_parser, parser);
 }
 
+// Monad
+template <>
+struct IsMonad<FromJsonParser>: true_type {};
+
+template <typename A, typename K>
+inline FromJsonParser<BoundValueType<FromJsonParser, A, K>> monad_bind(
+	FromJsonParser<A> parser,
+	K continuation
+)
+{
+	return monad_bind<A, FromJsonParser, K>(parser, continuation);
+}
+
 // Alternative
 template <typename A>
 inline FromJsonParser<A> alt(
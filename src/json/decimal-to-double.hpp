@@ -0,0 +1,29 @@
+#pragma once
+
+// Correctly rounded conversion of a decimal number (“mantissa × 10^exponent”)
+// into “double” without arbitrary-precision arithmetic.
+//
+// 1. When both the mantissa and the power of 10 are exactly representable
+//    a single multiplication or division is correctly rounded (Clinger’s fast
+//    path).
+// 2. Otherwise the mantissa is multiplied by a 128-bit approximation of the
+//    power of 10 (the Eisel-Lemire algorithm). The approximation is precise
+//    enough to round correctly unless the product is too close to a halfway
+//    point between two “double” values.
+//
+// It covers nearly all of the numbers met in practice. The rest (including
+// the subnormal numbers and out of range values) is left for an exact
+// conversion like “from_chars”.
+
+#include <cstdint>
+
+using namespace std;
+
+
+// Returns “false” when the number can not be converted this way
+bool decimal_to_double(
+	uint64_t mantissa,
+	int64_t exponent,
+	bool negative,
+	double &out
+);
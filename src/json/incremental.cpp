@@ -0,0 +1,411 @@
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "json/incremental.hpp"
+#include "json/scanners.hpp"
+#include "json/types.hpp"
+
+using namespace std;
+
+// Local shorthand
+using Node = IncrementalJsonNode;
+
+
+// Helpers {{{1
+
+inline void skip_spacer(string_view input, size_t &pos)
+{
+	while (pos < input.size() && is_json_spacer(input[pos])) ++pos;
+}
+
+inline bool is_container(const Node &x)
+{
+	return x.kind == JsonValueKind::Array || x.kind == JsonValueKind::Object;
+}
+
+inline const char* closing_expected(bool is_object)
+{
+	return is_object
+		? "JsonObject: “}” is expected"
+		: "JsonArray: “]” is expected";
+}
+
+inline const char* parse_node(
+	string_view input,
+	size_t &pos,
+	size_t parent_begin,
+	Node &node
+);
+
+// A member of an array or an object (with its key)
+inline const char* parse_member(
+	string_view input,
+	size_t &pos,
+	bool is_object,
+	size_t parent_begin,
+	Node &node
+)
+{
+	node.key_offset = pos - parent_begin;
+
+	if (is_object) {
+		if (pos >= input.size() || input[pos] != '"')
+			return "JsonObject: key is expected";
+		if (const char *err = scan_json_string(input, pos, node.key)) return err;
+
+		skip_spacer(input, pos);
+		if (pos >= input.size() || input[pos] != ':')
+			return "JsonObject: “:” is expected";
+		++pos;
+		skip_spacer(input, pos);
+	}
+
+	return parse_node(input, pos, parent_begin, node);
+}
+
+// The value at “pos” with all its members, its offset is from “parent_begin”.
+// Nothing past “input” is looked at.
+inline const char* parse_node(
+	string_view input,
+	size_t &pos,
+	size_t parent_begin,
+	Node &node
+)
+{
+	if (pos >= input.size()) return "JsonValue: input is empty";
+	const size_t begin = pos;
+	const char c = input[pos];
+	node.offset = begin - parent_begin;
+
+	if (c == '[' || c == '{') {
+		const bool is_object = c == '{';
+		node.kind = is_object ? JsonValueKind::Object : JsonValueKind::Array;
+		++pos;
+		skip_spacer(input, pos);
+
+		if (pos < input.size() && input[pos] != (is_object ? '}' : ']'))
+			for (;;) {
+				node.children.emplace_back();
+				const char *err = parse_member(
+					input,
+					pos,
+					is_object,
+					begin,
+					node.children.back()
+				);
+				if (err != nullptr) return err;
+
+				skip_spacer(input, pos);
+				if (pos >= input.size() || input[pos] != ',') break;
+				++pos;
+				skip_spacer(input, pos);
+			}
+
+		if (pos >= input.size() || input[pos] != (is_object ? '}' : ']'))
+			return closing_expected(is_object);
+		++pos;
+	} else if (c == '"') {
+		node.kind = JsonValueKind::String;
+		if (const char *err = validate_json_string(input, pos)) return err;
+	} else if (is_json_number_start(c)) {
+		node.kind = JsonValueKind::Number;
+		JsonNumber x;
+		if (const char *err = scan_json_number(input, pos, x)) return err;
+	} else {
+		const string_view literal =
+			c == 't' ? "true" : c == 'f' ? "false" : c == 'n' ? "null" : "";
+		if (literal.empty()) return "JsonValue: unexpected character";
+		if (input.substr(pos, literal.size()) != literal)
+			return "JsonValue: unexpected literal";
+		node.kind = c == 'n' ? JsonValueKind::Null : JsonValueKind::Bool;
+		pos += literal.size();
+	}
+
+	node.length = pos - begin;
+	return nullptr;
+}
+
+// Members of an array or an object from “pos” up to the end of “input” (the
+// offsets are from “begin” of the array or the object). “after_member” means
+// a member goes right before them (so they start with “,”) and
+// “before_member” means a member goes right after them (so they end with
+// “,”).
+inline const char* parse_members(
+	string_view input,
+	size_t &pos,
+	bool is_object,
+	size_t begin,
+	bool after_member,
+	bool before_member,
+	vector<Node> &out
+)
+{
+	bool comma_expected = after_member;
+	bool after_comma = false;
+
+	for (;;) {
+		skip_spacer(input, pos);
+		if (pos >= input.size()) break;
+
+		if (comma_expected) {
+			if (input[pos] != ',') return closing_expected(is_object);
+			++pos;
+			comma_expected = false;
+			after_comma = true;
+			continue;
+		}
+
+		out.emplace_back();
+		const char *err = parse_member(input, pos, is_object, begin, out.back());
+		if (err != nullptr) return err;
+		comma_expected = true;
+		after_comma = false;
+	}
+
+	if (before_member && comma_expected) return closing_expected(is_object);
+	if (!before_member && after_comma) return "JsonValue: input is empty";
+	return nullptr;
+}
+
+// }}}1
+
+
+IncrementalJsonDocument::IncrementalJsonDocument(
+	string text,
+	JsonParsingOptions options
+):
+	input(move(text)),
+	options(move(options))
+{
+	this->options.shared_input = nullptr;
+	parse_all();
+}
+
+bool IncrementalJsonDocument::parse_all()
+{
+	Node root;
+	size_t pos = 0;
+	skip_spacer(input, pos);
+	const char *err = parse_node(input, pos, 0, root);
+	if (err == nullptr) {
+		skip_spacer(input, pos);
+		if (pos < input.size()) err = "end_of_input: input is not empty";
+	}
+
+	if (err != nullptr) {
+		failure = err;
+		failure_offset = pos;
+		return false;
+	}
+
+	tree = move(root);
+	reparsed = input.size();
+	failure = nullptr;
+	return true;
+}
+
+bool IncrementalJsonDocument::edit(
+	size_t offset,
+	size_t deleted,
+	string_view inserted
+)
+{
+	if (offset > input.size() || deleted > input.size() - offset) {
+		failure = "IncrementalJsonDocument: edit is out of the text";
+		failure_offset = min(offset, input.size());
+		return false;
+	}
+	const size_t edit_end = offset + deleted;
+
+	// The arrays and the objects that have the edit between their brackets
+	// (from the root to the deepest one) with their positions in the text
+	vector<pair<Node*, size_t>> path;
+	Node *node = &tree;
+	size_t begin = tree.offset;
+	while (
+		is_container(*node) &&
+		begin < offset &&
+		edit_end < begin + node->length
+	) {
+		path.emplace_back(node, begin);
+		const auto next = upper_bound(
+			node->children.begin(),
+			node->children.end(),
+			offset - begin,
+			[](size_t x, const Node &y) { return x < y.key_offset; }
+		);
+		if (next == node->children.begin()) break;
+		node = &*prev(next);
+		begin += node->offset;
+	}
+
+	const string removed = input.substr(offset, deleted);
+	input.replace(offset, deleted, inserted);
+	// The failure is reported the same way as by a full parsing
+	const auto reparse_all = [&]() -> bool {
+		if (parse_all()) return true;
+		input.replace(offset, inserted.size(), removed);
+		return false;
+	};
+	if (path.empty()) return reparse_all();
+
+	Node &container = *path.back().first;
+	const size_t container_begin = path.back().second;
+	vector<Node> &children = container.children;
+	const bool is_object = container.kind == JsonValueKind::Object;
+
+	// The members touched by the edit are “[first, last)”, the members around
+	// them and the text between them stay as they are
+	const size_t relative_offset = offset - container_begin;
+	const size_t relative_end = edit_end - container_begin;
+	const auto first = partition_point(
+		children.begin(),
+		children.end(),
+		[relative_offset](const Node &x) {
+			return x.offset + x.length < relative_offset;
+		}
+	);
+	const auto last = partition_point(
+		first,
+		children.end(),
+		[relative_end](const Node &x) { return x.key_offset <= relative_end; }
+	);
+	const bool after_member = first != children.begin();
+	const bool before_member = last != children.end();
+
+	const size_t region_begin = container_begin + (
+		after_member ? prev(first)->offset + prev(first)->length : 1
+	);
+	const size_t region_end =
+		container_begin +
+		(before_member ? last->key_offset : container.length - 1) -
+		deleted + inserted.size();
+
+	vector<Node> members;
+	size_t pos = region_begin;
+	const char *err = parse_members(
+		string_view(input).substr(0, region_end),
+		pos,
+		is_object,
+		container_begin,
+		after_member,
+		before_member,
+		members
+	);
+	if (err != nullptr) return reparse_all();
+
+	// Splicing the new members in
+	const size_t index = first - children.begin();
+	if (size_t(last - first) == members.size()) {
+		move(members.begin(), members.end(), first);
+	} else {
+		const auto rest = children.erase(first, last);
+		children.insert(
+			rest,
+			make_move_iterator(members.begin()),
+			make_move_iterator(members.end())
+		);
+	}
+
+	// It wraps around when the text is shorter, the sums are still right
+	const size_t delta = inserted.size() - deleted;
+	const auto shift = [delta](Node &x) {
+		x.offset += delta;
+		x.key_offset += delta;
+	};
+	for (size_t i = index + members.size(); i < children.size(); ++i)
+		shift(children[i]);
+	container.length += delta;
+
+	// Only the members after the edit move on every level above
+	for (size_t i = path.size() - 1; i > 0; --i) {
+		Node &parent = *path[i - 1].first;
+		const size_t child = path[i].first - parent.children.data();
+		for (size_t j = child + 1; j < parent.children.size(); ++j)
+			shift(parent.children[j]);
+		parent.length += delta;
+	}
+
+	reparsed = region_end - region_begin;
+	failure = nullptr;
+	return true;
+}
+
+string_view IncrementalJsonDocument::text() const
+{
+	return input;
+}
+
+const IncrementalJsonNode& IncrementalJsonDocument::root() const
+{
+	return tree;
+}
+
+size_t IncrementalJsonDocument::reparsed_size() const
+{
+	return reparsed;
+}
+
+JsonValue IncrementalJsonDocument::to_json_value() const
+{
+	return to_json_value(tree, tree.offset);
+}
+
+JsonValue IncrementalJsonDocument::to_json_value(
+	const IncrementalJsonNode &node,
+	size_t begin
+) const
+{
+	size_t pos = begin;
+
+	switch (node.kind) {
+		case JsonValueKind::Object: {
+			// First key wins (like with the other engines)
+			JsonMembers entries;
+			entries.reserve(node.children.size());
+			for (auto &x : node.children)
+				if (entries.find(x.key) == entries.end())
+					entries.emplace(x.key, to_json_value(x, begin + x.offset));
+			return JsonValue{make_json_object(move(entries))};
+		}
+		case JsonValueKind::Array: {
+			vector<JsonValue> items;
+			items.reserve(node.children.size());
+			for (auto &x : node.children)
+				items.push_back(to_json_value(x, begin + x.offset));
+			return JsonValue{make_json_array(move(items))};
+		}
+		case JsonValueKind::String: {
+			JsonString x;
+			scan_json_string_value(input, pos, options, string(), x);
+			return JsonValue{move(x)};
+		}
+		case JsonValueKind::Number: {
+			JsonNumber x;
+			scan_json_number(input, pos, x, options.lazy_numbers);
+			return JsonValue{move(x)};
+		}
+		case JsonValueKind::Bool:
+			return JsonValue{make_json_bool(input[begin] == 't')};
+		case JsonValueKind::Null:
+		case JsonValueKind::None:
+			break;
+	}
+
+	return JsonValue{JsonNull{unit()}};
+}
+
+const char* IncrementalJsonDocument::error() const
+{
+	return failure;
+}
+
+size_t IncrementalJsonDocument::error_offset() const
+{
+	return failure_offset;
+}
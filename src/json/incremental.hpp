@@ -0,0 +1,95 @@
+#pragma once
+
+// Incremental document: the text of a document with a tree of the positions
+// of all its values, for small textual edits of a big document. An edit
+// (bytes deleted at an offset and bytes inserted there) re-parses only the
+// smallest array or object that contains the edit with its brackets intact.
+// And only the members of it that the edit touches are re-parsed (with the
+// “,” around them), so changing a number of a huge array re-parses just that
+// number. The new members are spliced into the tree.
+//
+// The offsets in the tree are relative to the parent value, so the values
+// after the edit are not touched: only the lengths of the enclosing values
+// and the offsets of the members that follow the edit on every level are
+// adjusted. So an edit costs its own size plus the depth and the width of
+// the tree around it, not the size of the document. Mind that the text is a
+// single “string”, so an edit still moves the tail of it in memory (that is
+// much cheaper than parsing it again).
+//
+// An edit that makes the text malformed is rejected and nothing is changed.
+// Then the whole text is parsed to report the failure exactly like a full
+// parsing would.
+//
+// Mind that nesting is parsed recursively (see “max_depth” option in
+// “json/types.hpp”).
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "json/types.hpp"
+
+using namespace std;
+
+
+// A value of the document
+struct IncrementalJsonNode
+{
+	// From the beginning of the parent value (from the beginning of the text
+	// for the root value)
+	size_t offset = 0;
+	size_t length = 0;
+	// Same as “offset” but for the key of a member of an object (the same as
+	// “offset” for anything else)
+	size_t key_offset = 0;
+	JsonValueKind kind = JsonValueKind::None;
+	// Decoded key of a member of an object
+	string key;
+	// Members of an array or an object in the order of the text (duplicate
+	// keys included)
+	vector<IncrementalJsonNode> children;
+};
+
+class IncrementalJsonDocument
+{
+public:
+	// Parses the whole text (see “error”, the root kind is “None” after
+	// a failure). “shared_input” option is ignored because the text changes.
+	explicit IncrementalJsonDocument(
+		string text,
+		JsonParsingOptions options = {}
+	);
+
+	// Replaces “deleted” bytes at “offset” with “inserted”. Returns “false”
+	// when the edit is out of the text or the edited text is malformed (see
+	// “error”), then the document stays as it was.
+	bool edit(size_t offset, size_t deleted, string_view inserted);
+
+	string_view text() const;
+	const IncrementalJsonNode& root() const;
+	// Bytes parsed by the construction or by the last successful edit
+	size_t reparsed_size() const;
+
+	// The whole document and a value of it by its position in the text (that
+	// is the sum of its offset and of the offsets of all its parents). The
+	// root is “null” when the text is malformed.
+	JsonValue to_json_value() const;
+	JsonValue to_json_value(const IncrementalJsonNode &node, size_t begin) const;
+
+	// The last failure (“nullptr” when there is none) and its byte offset in
+	// the text (in the edited text when an edit is rejected)
+	const char* error() const;
+	size_t error_offset() const;
+
+private:
+	string input;
+	JsonParsingOptions options;
+	IncrementalJsonNode tree;
+	size_t reparsed = 0;
+	const char *failure = nullptr;
+	size_t failure_offset = 0;
+
+	// Parses the whole text into “tree” (keeps it on failure)
+	bool parse_all();
+};
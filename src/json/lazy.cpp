@@ -0,0 +1,289 @@
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "json/lazy.hpp"
+#include "json/scanners.hpp"
+#include "json/structural-index.hpp"
+#include "json/types.hpp"
+#include "parser/types.hpp"
+
+using namespace std;
+
+// Local shorthand
+using I = ParserInputType<Parser>;
+
+
+struct LazyJsonIndex
+{
+	bool built = false;
+	// Every access reports the same failure
+	optional<ParsingError<I>> failure;
+	// Only for an object (in the order of the document)
+	vector<string> keys;
+	vector<LazyJsonValue> values;
+};
+
+
+// Helpers {{{1
+
+inline void skip_spacer(string_view input, size_t &pos)
+{
+	while (pos < input.size() && is_json_spacer(input[pos])) ++pos;
+}
+
+inline LazyJsonValue make_lazy_json_value(
+	I input,
+	size_t begin,
+	size_t end,
+	const JsonParsingOptions &options
+)
+{
+	LazyJsonValue x{input, begin, end, options, nullptr};
+	if (input[begin] == '[' || input[begin] == '{')
+		x.index = make_shared<LazyJsonIndex>();
+	return x;
+}
+
+// One level of an array or an object, the nested values are only skipped
+inline const char* scan_children(
+	const LazyJsonValue &x,
+	LazyJsonIndex &index,
+	size_t &pos
+)
+{
+	const bool is_object = x.input[x.begin] == '{';
+	// Nothing is scanned past the value
+	const string_view input = x.input.substr(0, x.end);
+	string_view key;
+	string buffer;
+
+	pos = x.begin + 1;
+	skip_spacer(input, pos);
+
+	if (pos < input.size() && input[pos] != (is_object ? '}' : ']')) {
+		for (;;) {
+			if (is_object) {
+				if (pos >= input.size() || input[pos] != '"')
+					return "JsonObject: key is expected";
+				if (const char *err = scan_json_string(input, pos, key, buffer))
+					return err;
+				index.keys.emplace_back(key);
+
+				skip_spacer(input, pos);
+				if (pos >= input.size() || input[pos] != ':')
+					return "JsonObject: “:” is expected";
+				++pos;
+				skip_spacer(input, pos);
+			}
+
+			if (pos >= input.size()) return "JsonValue: value is expected";
+			const size_t begin = pos;
+			if (const char *err = skip_json_value(input, pos)) return err;
+			index.values.push_back(
+				make_lazy_json_value(x.input, begin, pos, x.options)
+			);
+
+			skip_spacer(input, pos);
+			if (pos < input.size() && input[pos] == ',') ++pos; else break;
+			skip_spacer(input, pos);
+		}
+	}
+
+	if (pos >= input.size() || input[pos] != (is_object ? '}' : ']'))
+		return is_object
+			? "JsonObject: “}” is expected"
+			: "JsonArray: “]” is expected";
+
+	// Only the root value can be followed by something
+	++pos;
+	skip_spacer(input, pos);
+	if (pos < input.size()) return "end_of_input: input is not empty";
+	return nullptr;
+}
+
+// Builds the skip-index on the first access
+inline variant<ParsingError<I>, const LazyJsonIndex*> children(
+	const LazyJsonValue &x,
+	bool is_object
+)
+{
+	if (x.kind() != (is_object ? JsonValueKind::Object : JsonValueKind::Array))
+		return make_parsing_error<I>(
+			is_object
+				? "LazyJsonValue: object is expected"
+				: "LazyJsonValue: array is expected",
+			x.input.substr(x.begin)
+		);
+
+	LazyJsonIndex &index = *x.index;
+	if (!index.built) {
+		index.built = true;
+		size_t pos;
+		if (const char *err = scan_children(x, index, pos)) {
+			index.failure = make_parsing_error<I>(err, x.input.substr(pos));
+			index.keys.clear();
+			index.values.clear();
+		}
+	}
+
+	if (index.failure.has_value()) return *index.failure;
+	return &index;
+}
+
+// }}}1
+
+
+JsonValueKind LazyJsonValue::kind() const
+{
+	if (begin >= end) return JsonValueKind::None;
+
+	switch (input[begin]) {
+		case '{': return JsonValueKind::Object;
+		case '[': return JsonValueKind::Array;
+		case '"': return JsonValueKind::String;
+		case 't': case 'f': return JsonValueKind::Bool;
+		case 'n': return JsonValueKind::Null;
+		default:
+			return is_json_number_start(input[begin])
+				? JsonValueKind::Number
+				: JsonValueKind::None;
+	}
+}
+
+string_view LazyJsonValue::source() const
+{
+	return input.substr(begin, end - begin);
+}
+
+variant<ParsingError<I>, LazyJsonValue> parse_json_lazy(
+	I input,
+	JsonParsingOptions options
+)
+{
+	size_t pos = 0;
+	skip_spacer(input, pos);
+	if (pos >= input.size())
+		return make_parsing_error<I>(
+			"JsonValue: value is expected",
+			input.substr(pos)
+		);
+
+	// The rest is checked when it is accessed
+	size_t end = input.size();
+	while (is_json_spacer(input[end - 1])) --end;
+
+	return make_lazy_json_value(input, pos, end, options);
+}
+
+variant<ParsingError<I>, vector<LazyJsonValue>> from_json_array(
+	const LazyJsonValue &x
+)
+{
+	auto index = children(x, false);
+	if (auto err = get_if<ParsingError<I>>(&index)) return *err;
+	return get<const LazyJsonIndex*>(index)->values;
+}
+
+variant<ParsingError<I>, OrderedMap<LazyJsonValue>> from_json_object(
+	const LazyJsonValue &x
+)
+{
+	auto index = children(x, true);
+	if (auto err = get_if<ParsingError<I>>(&index)) return *err;
+
+	const LazyJsonIndex &y = *get<const LazyJsonIndex*>(index);
+	OrderedMap<LazyJsonValue> entries;
+	entries.reserve(y.keys.size());
+	for (size_t i = 0; i < y.keys.size(); ++i)
+		entries.try_emplace(y.keys[i], y.values[i]);
+	return entries;
+}
+
+variant<ParsingError<I>, LazyJsonValue> in_key(
+	string_view key,
+	const LazyJsonValue &x
+)
+{
+	auto index = children(x, true);
+	if (auto err = get_if<ParsingError<I>>(&index)) return *err;
+
+	const LazyJsonIndex &y = *get<const LazyJsonIndex*>(index);
+	for (size_t i = 0; i < y.keys.size(); ++i)
+		if (y.keys[i] == key) return y.values[i];
+
+	return make_parsing_error<I>(
+		"Key \"" + string(key) + "\" is not found",
+		x.input.substr(x.begin)
+	);
+}
+
+variant<ParsingError<I>, JsonValue> to_json_value(const LazyJsonValue &x)
+{
+	// Nothing is scanned past the value
+	const string_view input = x.input.substr(0, x.end);
+	size_t pos = x.begin;
+	const char *err = nullptr;
+	JsonValue out;
+
+	switch (x.kind()) {
+		case JsonValueKind::Object:
+		case JsonValueKind::Array: {
+			auto result = parse_json_structural(x.source(), x.options);
+			// The tail of the error goes up to the end of the input
+			if (auto y = get_if<ParsingError<I>>(&result))
+				return make_parsing_error<I>(
+					y->first,
+					x.input.substr(x.end - y->second.size())
+				);
+			return result;
+		}
+		case JsonValueKind::String: {
+			JsonString y;
+			err = scan_json_string_value(input, pos, x.options, string(), y);
+			out = JsonValue{move(y)};
+			break;
+		}
+		case JsonValueKind::Number: {
+			JsonNumber y;
+			err = scan_json_number(
+				input,
+				pos,
+				y,
+				x.options.lazy_numbers,
+				x.options.shared_input
+			);
+			out = JsonValue{move(y)};
+			break;
+		}
+		case JsonValueKind::Bool:
+		case JsonValueKind::Null:
+			for (string_view literal : {"true", "false", "null"})
+				if (input.substr(pos, literal.size()) == literal) {
+					pos += literal.size();
+					out = literal == "null"
+						? JsonValue{JsonNull{unit()}}
+						: JsonValue{make_json_bool(literal == "true")};
+					break;
+				}
+			if (pos == x.begin) err = "JsonValue: unexpected literal";
+			break;
+		case JsonValueKind::None:
+			err = "JsonValue: unexpected character";
+	}
+
+	// Only the root value can be followed by something
+	if (err == nullptr && pos != x.end) {
+		const size_t token_end = pos;
+		skip_spacer(input, pos);
+		err = pos != token_end
+			? "end_of_input: input is not empty"
+			: "JsonValue: unexpected character";
+	}
+	if (err != nullptr) return make_parsing_error<I>(err, x.input.substr(pos));
+	return out;
+}
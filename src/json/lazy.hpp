@@ -0,0 +1,80 @@
+#pragma once
+
+// Lazy document: arrays and objects are kept as their source text and their
+// children are found only when they are accessed. The first access to an
+// array or an object scans just that level. Its nested values are skipped by
+// matching the brackets (see “skip_json_value” in “json/scanners.hpp”). The
+// positions of the children are kept in the value (the “skip-index”), so the
+// next access does not scan anything. Scalars are not kept, they are parsed
+// again on every access (see “to_json_value” and the note on “lazy_numbers”
+// option in “json/types.hpp”).
+//
+// So a document of which only a few fields are read costs about one pass of
+// the skipper over it plus the parsing of those fields.
+//
+// Mind that malformed parts of the document (including anything after the
+// root value) are reported only when they are accessed. Also mind that the
+// input must outlive the values. A lazy value is not thread-safe: its copies
+// share the skip-index, and the first access builds it.
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "json/ordered-map.hpp"
+#include "json/types.hpp"
+#include "parser/types.hpp"
+
+using namespace std;
+
+
+// The children of an array or an object (see “json/lazy.cpp”)
+struct LazyJsonIndex;
+
+struct LazyJsonValue
+{
+	// The whole input, the value is “input[begin, end)” (so that a parsing
+	// error has the whole tail of the input)
+	ParserInputType<Parser> input;
+	size_t begin = 0;
+	size_t end = 0;
+	JsonParsingOptions options;
+	// Only for an array or an object, built on the first access
+	shared_ptr<LazyJsonIndex> index;
+
+	// What kind of value it is (without any parsing)
+	JsonValueKind kind() const;
+	// The source text of the value
+	string_view source() const;
+};
+
+// Does not parse anything, it only finds where the root value starts
+variant<ParsingError<ParserInputType<Parser>>, LazyJsonValue> parse_json_lazy(
+	ParserInputType<Parser> input,
+	JsonParsingOptions options = {}
+);
+
+// Same as the unwrappers of “JsonValue” (see “json/types.hpp”). They fail
+// when the value is of another kind or it is malformed.
+variant<ParsingError<ParserInputType<Parser>>, vector<LazyJsonValue>>
+from_json_array(const LazyJsonValue &x);
+
+// In the order of the keys and the first key wins (like with the other
+// engines)
+variant<ParsingError<ParserInputType<Parser>>, OrderedMap<LazyJsonValue>>
+from_json_object(const LazyJsonValue &x);
+
+// Value of a key of an object (the key is looked up in the skip-index
+// without building a map)
+variant<ParsingError<ParserInputType<Parser>>, LazyJsonValue> in_key(
+	string_view key,
+	const LazyJsonValue &x
+);
+
+// Parses the value completely
+variant<ParsingError<ParserInputType<Parser>>, JsonValue> to_json_value(
+	const LazyJsonValue &x
+);
@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "json/ndjson.hpp"
+#include "json/scanners.hpp"
+#include "parser/position.hpp"
+#include "thread-pool.hpp"
+
+using namespace std;
+
+
+NdjsonProcessor::NdjsonProcessor(
+	ThreadPool &pool,
+	Transform transform,
+	ostream &out,
+	ostream &failures,
+	size_t batch_size
+):
+	pool(pool),
+	transform(move(transform)),
+	out(out),
+	failures(failures),
+	batch_size(batch_size),
+	// Enough for every thread to have the next batch ready
+	max_in_flight(2 * pool.size()),
+	current(make_unique<Batch>())
+{}
+
+NdjsonProcessor::~NdjsonProcessor()
+{
+	unique_lock<mutex> guard(lock);
+	batch_done.wait(guard, [this]() {
+		return all_of(
+			in_flight.begin(),
+			in_flight.end(),
+			[](const unique_ptr<Batch> &x) { return x->done; }
+		);
+	});
+}
+
+// Helpers {{{1
+
+void NdjsonProcessor::submit()
+{
+	Batch *batch = current.get();
+	batch->first_line = next_line;
+	next_line += count_newlines(batch->input);
+	{
+		lock_guard<mutex> guard(lock);
+		in_flight.push_back(move(current));
+	}
+	current = make_unique<Batch>();
+
+	pool.submit([this, batch]() {
+		process(*batch);
+		lock_guard<mutex> guard(lock);
+		batch->done = true;
+		batch_done.notify_all();
+	});
+}
+
+void NdjsonProcessor::process(Batch &batch) const
+{
+	const string_view input = batch.input;
+	size_t line = batch.first_line;
+
+	for (size_t start = 0; start < input.size(); ++line) {
+		const size_t end = min(input.find('\n', start), input.size());
+		string_view record = input.substr(start, end - start);
+		start = end + 1;
+
+		if (!record.empty() && record.back() == '\r') record.remove_suffix(1);
+		if (all_of(record.begin(), record.end(), is_json_spacer)) continue;
+
+		++batch.records_count;
+		if (optional<string> err = transform(record, batch.output)) {
+			++batch.failures_count;
+			batch.failures += "Line " + to_string(line) + ": " + *err + "\n";
+		}
+	}
+
+	// It is not needed anymore
+	batch.input = string();
+}
+
+void NdjsonProcessor::write_done(size_t limit)
+{
+	unique_lock<mutex> guard(lock);
+	while (!in_flight.empty()) {
+		if (!in_flight.front()->done) {
+			if (in_flight.size() <= limit) break;
+			batch_done.wait(guard, [this]() { return in_flight.front()->done; });
+		}
+
+		const unique_ptr<Batch> batch = move(in_flight.front());
+		in_flight.pop_front();
+		guard.unlock();
+
+		out << batch->output;
+		failures << batch->failures;
+		records += batch->records_count;
+		failed_records += batch->failures_count;
+
+		guard.lock();
+	}
+}
+
+// }}}1
+
+void NdjsonProcessor::feed(string_view chunk)
+{
+	current->input.append(chunk);
+	if (current->input.size() < batch_size) return;
+
+	// Only whole lines go to a batch (the ones before this piece have no line
+	// breaks, so there is no need to look at them again)
+	const size_t last_break = chunk.rfind('\n');
+	if (last_break == string_view::npos) return;
+	const size_t end = current->input.size() - chunk.size() + last_break + 1;
+
+	string rest = current->input.substr(end);
+	current->input.resize(end);
+	submit();
+	current->input = move(rest);
+
+	write_done(max_in_flight);
+}
+
+void NdjsonProcessor::finish()
+{
+	if (!current->input.empty()) submit();
+	write_done(0);
+}
+
+size_t NdjsonProcessor::records_count() const
+{
+	return records;
+}
+
+size_t NdjsonProcessor::failures_count() const
+{
+	return failed_records;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+// Newline-delimited JSON (also known as JSON Lines): every line of the input
+// is a separate record. The lines are grouped into batches and the batches
+// are processed on a thread pool. The results are written in the order of the
+// input: a batch that is done before the ones in front of it waits in the
+// reorder buffer. A failure of a record is reported with its line number and
+// the rest of the records are processed as usual.
+//
+// The input comes in pieces of any size (like with “JsonTranscoder” from
+// “json/transcoder.hpp”), so the memory depends on the size of a batch and on
+// the number of threads, not on the size of the input.
+//
+// Blank lines are skipped and “\r” before “\n” is dropped.
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "thread-pool.hpp"
+
+using namespace std;
+
+
+class NdjsonProcessor
+{
+public:
+	// Appends the output of a record (with its line break, if there is any
+	// output at all) to “out” or returns the failure message. It is called on
+	// all the threads of the pool at the same time.
+	using Transform = function<optional<string>(string_view record, string &out)>;
+
+	// The outputs go to “out” and the failures go to “failures” (a line
+	// each, starting with “Line N: ”)
+	NdjsonProcessor(
+		ThreadPool &pool,
+		Transform transform,
+		ostream &out,
+		ostream &failures,
+		size_t batch_size = 1 << 20
+	);
+	// Waits for the batches that are still being processed
+	~NdjsonProcessor();
+
+	// Next piece of the input. The batches that are done are written (not
+	// flushed). Waits when too many batches are being processed.
+	void feed(string_view chunk);
+	// End of the input (the last line may have no line break). Waits for all
+	// the batches and writes them.
+	void finish();
+
+	// Numbers of the records and of the failures written so far
+	size_t records_count() const;
+	size_t failures_count() const;
+
+private:
+	struct Batch
+	{
+		// Of the first line (starting from 1)
+		size_t first_line = 1;
+		// Whole lines (except for the last batch)
+		string input;
+		string output;
+		string failures;
+		size_t records_count = 0;
+		size_t failures_count = 0;
+		bool done = false;
+	};
+
+	ThreadPool &pool;
+	Transform transform;
+	ostream &out;
+	ostream &failures;
+	size_t batch_size;
+	// No more batches are being processed at the same time
+	size_t max_in_flight;
+
+	// The batch being filled
+	unique_ptr<Batch> current;
+	size_t next_line = 1;
+	// The reorder buffer: in the order of the input, the first one is written
+	// as soon as it is done
+	deque<unique_ptr<Batch>> in_flight;
+	mutex lock;
+	condition_variable batch_done;
+
+	size_t records = 0;
+	size_t failed_records = 0;
+
+	void submit();
+	void process(Batch &batch) const;
+	// Writes the batches that are done from the front of the reorder buffer.
+	// Waits until there are no more than “limit” batches left in it.
+	void write_done(size_t limit);
+};
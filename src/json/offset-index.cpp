@@ -0,0 +1,370 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "json/offset-index.hpp"
+#include "json/pointer.hpp"
+#include "json/sax.hpp"
+#include "json/scanners.hpp"
+#include "parser/types.hpp"
+
+using namespace std;
+
+// Local shorthand
+using I = ParserInputType<Parser>;
+
+// “JSONIDX1” in the little-endian byte order
+constexpr uint64_t index_magic = 0x31584449'4e4f534a;
+// A value that has no record
+constexpr uint64_t no_record = UINT64_MAX;
+constexpr size_t footer_size = 4 * sizeof(uint64_t);
+
+
+// Helpers {{{1
+
+// A member of an array or an object that is kept in the index
+struct IndexEntry
+{
+	// Hash of the key (of a member of an object) or index of the member (of
+	// a member of an array)
+	uint64_t id;
+	uint64_t key_begin;
+	uint64_t value_begin;
+	uint64_t record;
+};
+
+inline void skip_spacer(string_view input, size_t &pos)
+{
+	while (pos < input.size() && is_json_spacer(input[pos])) ++pos;
+}
+
+// FNV-1a of the decoded key
+inline uint64_t hash_key(string_view key)
+{
+	uint64_t x = 14695981039346656037u;
+	for (char c : key) {
+		x ^= uint8_t(c);
+		x *= 1099511628211u;
+	}
+	return x;
+}
+
+// Moves from a member of an array to the next one (“false” at the end of the
+// array)
+inline bool next_member(string_view input, size_t &pos)
+{
+	if (skip_json_value(input, pos) != nullptr) return false;
+	skip_spacer(input, pos);
+	if (pos >= input.size() || input[pos] != ',') return false;
+	++pos;
+	skip_spacer(input, pos);
+	return true;
+}
+
+// }}}1
+
+
+optional<ParsingError<I>> write_json_offset_index(
+	I input,
+	ostream &out,
+	size_t min_container_size
+)
+{
+	// The rest relies on the document being well-formed
+	if (auto err = validate_json(input)) return err;
+
+	// An array or an object that is not closed yet
+	struct Frame
+	{
+		bool is_object;
+		size_t begin;
+		// Its members that are kept are “entries[first_entry…]”
+		size_t first_entry;
+		size_t count;
+		// The member that is being read
+		IndexEntry member;
+	};
+	vector<Frame> frames;
+	// Of all the open arrays and objects, the innermost ones at the end
+	vector<IndexEntry> entries;
+	vector<uint64_t> words;
+	uint64_t written = 0;
+	string buffer;
+
+	size_t pos = 0;
+	skip_spacer(input, pos);
+	const size_t root_begin = pos;
+	uint64_t root_record = no_record;
+
+	// “pos” is at the first character of a member (at the key of an object)
+	const auto begin_member = [&]() {
+		Frame &frame = frames.back();
+		frame.member = IndexEntry{frame.count, pos, pos, no_record};
+		if (frame.is_object) {
+			string_view key;
+			scan_json_string(input, pos, key, buffer);
+			frame.member.id = hash_key(key);
+			skip_spacer(input, pos);
+			++pos;
+			skip_spacer(input, pos);
+			frame.member.value_begin = pos;
+		}
+	};
+
+	const auto end_member = [&](uint64_t record) {
+		Frame &frame = frames.back();
+		frame.member.record = record;
+		if (
+			frame.is_object ||
+			record != no_record ||
+			entries.size() == frame.first_entry ||
+			frame.member.value_begin - entries.back().value_begin >=
+				min_container_size
+		) entries.push_back(frame.member);
+		++frame.count;
+	};
+
+	// “pos” is past the closing bracket. Writes the record when it is needed.
+	const auto close = [&]() -> uint64_t {
+		const Frame &frame = frames.back();
+		uint64_t record = no_record;
+
+		if (frames.size() == 1 || pos - frame.begin >= min_container_size) {
+			const auto first = entries.begin() + frame.first_entry;
+			// Same keys stay in the order of the document
+			if (frame.is_object)
+				stable_sort(
+					first,
+					entries.end(),
+					[](const IndexEntry &a, const IndexEntry &b) {
+						return a.id < b.id;
+					}
+				);
+
+			words.clear();
+			const uint64_t count = entries.end() - first;
+			words.push_back(count << 1 | frame.is_object);
+			for (auto x = first; x != entries.end(); ++x) {
+				words.push_back(x->id);
+				if (frame.is_object) words.push_back(x->key_begin);
+				words.push_back(x->value_begin);
+				words.push_back(x->record);
+			}
+
+			record = written;
+			out.write(
+				reinterpret_cast<const char*>(words.data()),
+				words.size() * sizeof(uint64_t)
+			);
+			written += words.size() * sizeof(uint64_t);
+		}
+
+		entries.resize(frame.first_entry);
+		frames.pop_back();
+		return record;
+	};
+
+	for (;;) {
+		const char c = input[pos];
+		if (c == '[' || c == '{') {
+			frames.push_back(Frame{c == '{', pos, entries.size(), 0, {}});
+			++pos;
+			skip_spacer(input, pos);
+			if (input[pos] != (c == '{' ? '}' : ']')) {
+				begin_member();
+				continue;
+			}
+		} else {
+			skip_json_value(input, pos);
+			skip_spacer(input, pos);
+			if (!frames.empty()) end_member(no_record);
+		}
+
+		// Either the next member or the end of the innermost array or object
+		// (that is the end of a member of the one around it)
+		while (!frames.empty()) {
+			if (input[pos] == ',') {
+				++pos;
+				skip_spacer(input, pos);
+				begin_member();
+				break;
+			}
+
+			++pos;
+			const uint64_t record = close();
+			skip_spacer(input, pos);
+			if (frames.empty())
+				root_record = record;
+			else
+				end_member(record);
+		}
+		if (frames.empty()) break;
+	}
+
+	const uint64_t footer[] = {
+		index_magic,
+		input.size(),
+		root_begin,
+		root_record,
+	};
+	out.write(reinterpret_cast<const char*>(footer), sizeof(footer));
+	return nullopt;
+}
+
+variant<ParsingError<I>, string_view> find_json_value(
+	I input,
+	string_view index,
+	string_view pointer
+)
+{
+	const auto word = [&index](size_t offset) -> uint64_t {
+		uint64_t x;
+		memcpy(&x, index.data() + offset, sizeof(x));
+		return x;
+	};
+	const auto mismatch = [&input]() -> ParsingError<I> {
+		return make_parsing_error<I>(
+			"JsonOffsetIndex: index does not match the input",
+			input
+		);
+	};
+
+	if (index.size() < footer_size || index.size() % sizeof(uint64_t) != 0)
+		return mismatch();
+	// The records are before it
+	const size_t footer = index.size() - footer_size;
+	if (word(footer) != index_magic || word(footer + 8) != input.size())
+		return mismatch();
+
+	size_t pos = word(footer + 16);
+	uint64_t record = word(footer + 24);
+	if (pos >= input.size()) return mismatch();
+
+	vector<string> tokens;
+	if (const char *err = split_json_pointer(pointer, tokens))
+		return make_parsing_error<I>(err, input.substr(pos));
+
+	// For the keys with escapes
+	string buffer;
+	for (const string &token : tokens) {
+		const char c = input[pos];
+		if (c != '[' && c != '{')
+			return make_parsing_error<I>(
+				"JsonOffsetIndex: array or object is expected",
+				input.substr(pos)
+			);
+		const bool is_object = c == '{';
+		const ParsingError<I> not_found = make_parsing_error<I>(
+			(is_object ? "Key \"" : "Element \"") + token + "\" is not found",
+			input.substr(pos)
+		);
+		uint64_t element = 0;
+		if (!is_object) {
+			const optional<size_t> x = json_pointer_array_index(token);
+			if (!x.has_value()) return not_found;
+			element = *x;
+		}
+
+		if (record != no_record) {
+			// Members of the record are “[first, first + count * size)”
+			if (record + 8 > footer) return mismatch();
+			const uint64_t header = word(record);
+			const uint64_t count = header >> 1;
+			const size_t size = (is_object ? 4 : 3) * sizeof(uint64_t);
+			const size_t first = record + 8;
+			if ((header & 1) != is_object || count > (footer - first) / size)
+				return mismatch();
+
+			if (is_object) {
+				// The first member with the same hash
+				const uint64_t hash = hash_key(token);
+				uint64_t low = 0, high = count;
+				while (low < high) {
+					const uint64_t middle = low + (high - low) / 2;
+					if (word(first + middle * size) < hash)
+						low = middle + 1;
+					else
+						high = middle;
+				}
+
+				bool found = false;
+				string_view key;
+				for (; low < count && word(first + low * size) == hash; ++low) {
+					size_t key_pos = word(first + low * size + 8);
+					if (
+						key_pos >= input.size() ||
+						scan_json_string(input, key_pos, key, buffer) != nullptr
+					) return mismatch();
+					if (key == token) {
+						found = true;
+						break;
+					}
+				}
+				if (!found) return not_found;
+
+				pos = word(first + low * size + 16);
+				record = word(first + low * size + 24);
+				if (pos >= input.size()) return mismatch();
+			} else {
+				// The last member kept before the element
+				uint64_t low = 0, high = count;
+				while (low < high) {
+					const uint64_t middle = low + (high - low) / 2;
+					if (word(first + middle * size) <= element)
+						low = middle + 1;
+					else
+						high = middle;
+				}
+				if (low == 0) return not_found;
+
+				const size_t entry = first + (low - 1) * size;
+				pos = word(entry + 8);
+				record = word(entry) == element ? word(entry + 16) : no_record;
+				if (pos >= input.size()) return mismatch();
+				// Only small values are skipped
+				for (uint64_t i = word(entry); i < element; ++i)
+					if (!next_member(input, pos)) return not_found;
+			}
+			continue;
+		}
+
+		// Not in the index, so the array or the object is small enough to
+		// be scanned
+		++pos;
+		skip_spacer(input, pos);
+		if (is_object) {
+			bool found = false;
+			string_view key;
+			while (pos < input.size() && input[pos] == '"') {
+				if (scan_json_string(input, pos, key, buffer) != nullptr)
+					return mismatch();
+				skip_spacer(input, pos);
+				if (pos >= input.size() || input[pos] != ':') return mismatch();
+				++pos;
+				skip_spacer(input, pos);
+				if (key == token) {
+					found = true;
+					break;
+				}
+				if (!next_member(input, pos)) break;
+			}
+			if (!found) return not_found;
+		} else {
+			if (pos >= input.size() || input[pos] == ']') return not_found;
+			for (uint64_t i = 0; i < element; ++i)
+				if (!next_member(input, pos)) return not_found;
+		}
+		if (pos >= input.size()) return mismatch();
+	}
+
+	size_t end = pos;
+	if (skip_json_value(input, end) != nullptr) return mismatch();
+	return input.substr(pos, end - pos);
+}
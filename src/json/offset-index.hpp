@@ -0,0 +1,66 @@
+#pragma once
+
+// Sidecar offset index: the positions of the values of a big document kept
+// next to it (in a file of its own), so that a value is found by its path
+// without parsing or even reading the rest of the document. Both the document
+// and the index are meant to be mapped into memory (see “mapped-file.hpp”),
+// then a lookup touches only a few pages of them.
+//
+// Only the arrays and the objects of at least “min_container_size” bytes (and
+// the root value) get into the index:
+//
+//   * For an object every member is kept, sorted by the hash of the key, so
+//     a key is found by a binary search (the key itself is then compared with
+//     the one in the document).
+//
+//   * For an array only a member every “min_container_size” bytes is kept
+//     (and every member that is in the index itself), so an element is found
+//     by a binary search and by skipping a few small values after it.
+//
+// The smaller arrays and objects are scanned, matching the brackets and the
+// quotes (like “JsonCursor” from “json/cursor.hpp” does), so a lookup costs
+// the length of the path times about “min_container_size” bytes.
+//
+// The index is a sequence of 64-bit words in the byte order of the machine:
+//
+//   * A record of an array or an object: the number of members shifted left
+//     by one with the lowest bit set for an object, then the members. A member
+//     of an array is its index, its position and its record (all ones when it
+//     has none). A member of an object is the hash of the key, the position of
+//     the key, the position of the value and its record.
+//
+//   * Then the footer: a magic number, the size of the document, the position
+//     of the root value and its record.
+//
+// A record goes after the records of its members, the positions are byte
+// offsets from the beginning of the document and from the beginning of the
+// index.
+
+#include <cstddef>
+#include <optional>
+#include <ostream>
+#include <string_view>
+#include <variant>
+
+#include "parser/types.hpp"
+
+using namespace std;
+
+
+// Checks the document (exactly like “validate_json” from “json/sax.hpp”) and
+// writes the index of it. Nothing is written when the document is malformed.
+optional<ParsingError<ParserInputType<Parser>>> write_json_offset_index(
+	ParserInputType<Parser> input,
+	ostream &out,
+	size_t min_container_size = 4096
+);
+
+// Finds a value by a JSON Pointer (RFC 6901, like “/a/3/b”, the empty one is
+// the root value) and returns its source text. First key wins (like with the
+// other engines). The index must be written for the same document (only its
+// size is checked).
+variant<ParsingError<ParserInputType<Parser>>, string_view> find_json_value(
+	ParserInputType<Parser> input,
+	string_view index,
+	string_view pointer
+);
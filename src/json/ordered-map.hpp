@@ -0,0 +1,229 @@
+#pragma once
+
+// Members of an object: a map from string keys which keeps them in the order
+// they were added (“std::map” sorts them).
+//
+// The members are a single contiguous list (“std::map” takes a node per
+// member and a lookup in it goes through a pointer per level of the tree). A
+// lookup in a small object (up to “small_size” members, which is most of the
+// objects in the wild) is a linear scan over that list, where the lengths of
+// the keys are compared before their contents. A bigger object has a hash
+// index on the side (open addressing with linear probing) that is built once
+// the object gets bigger than that.
+//
+// It is about the lookups in small objects and in the ones in the cache (a
+// lookup in a big object that is not in the cache goes through two
+// allocations, the index and the list, so it is slower than with “std::map”).
+// The list is allocated even for a small object (there is no room for the
+// members inline, a member holds a value which may hold members in turn) and
+// it is reallocated a few times while it grows, so building the members is
+// not faster than with “std::map” either.
+//
+// Like with the other maps a key that is already there is not added again, so
+// the first of the same keys wins. Mind that adding a member invalidates the
+// iterators and the references (like with “std::vector”), and that the keys
+// must not be changed in-place.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+
+template <typename V>
+class OrderedMap
+{
+public:
+	using value_type = pair<string, V>;
+	using iterator = typename vector<value_type>::iterator;
+	using const_iterator = typename vector<value_type>::const_iterator;
+
+	// The biggest object without a hash index. A scan over this many members
+	// goes through the memory forward, so it is about as fast as a lookup in
+	// the index (which is another allocation to go through) and it wins when
+	// the object is not in the cache (see “objects” benchmark).
+	static constexpr size_t small_size = 16;
+
+	OrderedMap() = default;
+	OrderedMap(initializer_list<value_type> list)
+	{
+		reserve(list.size());
+		for (const value_type &x : list) try_emplace(x.first, x.second);
+	}
+
+	iterator begin() { return members.begin(); }
+	iterator end() { return members.end(); }
+	const_iterator begin() const { return members.begin(); }
+	const_iterator end() const { return members.end(); }
+
+	size_t size() const { return members.size(); }
+	bool empty() const { return members.empty(); }
+	size_t capacity() const { return members.capacity(); }
+	void reserve(size_t n) { members.reserve(n); }
+	// The storage is kept (see “json/parse-context.hpp”)
+	void clear()
+	{
+		members.clear();
+		slots.clear();
+	}
+
+	iterator find(string_view key)
+	{
+		return members.begin() + find_index(key);
+	}
+	const_iterator find(string_view key) const
+	{
+		return members.begin() + find_index(key);
+	}
+	size_t count(string_view key) const
+	{
+		return find_index(key) < members.size() ? 1 : 0;
+	}
+	// Throws “out_of_range” when there is no such key (like “std::map”)
+	V &at(string_view key) { return members.at(find_index(key)).second; }
+	const V &at(string_view key) const
+	{
+		return members.at(find_index(key)).second;
+	}
+
+	// The arguments are used only when the key is added (so a value that was
+	// not added is still there for the caller)
+	template <typename K, typename ... Args>
+	pair<iterator, bool> try_emplace(K &&key, Args && ... args)
+	{
+		const string_view k(key);
+		size_t slot = 0;
+		uint64_t hash = 0;
+
+		if (slots.empty()) {
+			const size_t i = find_index(k);
+			if (i < members.size()) return {members.begin() + i, false};
+		} else {
+			hash = hash_key(k);
+			slot = probe(k, hash);
+			if (slots[slot] != 0)
+				return {members.begin() + (uint32_t(slots[slot]) - 1), false};
+		}
+
+		// Most of the objects have a few members, so they are not grown one by
+		// one
+		if (members.size() == members.capacity())
+			members.reserve(members.empty() ? 4 : members.size() * 2);
+		members.emplace_back(
+			piecewise_construct,
+			forward_as_tuple(forward<K>(key)),
+			forward_as_tuple(forward<Args>(args)...)
+		);
+		if (members.size() > small_size) {
+			if (slots.empty() || members.size() * 2 > slots.size())
+				build_index();
+			else
+				slots[slot] = make_slot(hash, members.size() - 1);
+		}
+		return {members.end() - 1, true};
+	}
+	template <typename K, typename W>
+	pair<iterator, bool> emplace(K &&key, W &&value)
+	{
+		return try_emplace(forward<K>(key), forward<W>(value));
+	}
+	pair<iterator, bool> insert(value_type &&x)
+	{
+		return try_emplace(move(x.first), move(x.second));
+	}
+
+private:
+	vector<value_type> members;
+	// The hash index of a big object (empty for a small one). A slot is the
+	// high half of the hash of a key and the position of its member plus one
+	// in the low half (0 is an empty slot). At most a half of the slots are
+	// used, so the probing is short.
+	vector<uint64_t> slots;
+
+	// The keys are mostly short, so a key up to 16 bytes is hashed as its first
+	// and its last 8 bytes (overlapping) without a loop (“std::hash” of a
+	// string is a more thorough and slower one)
+	static uint64_t hash_key(string_view key)
+	{
+		const uint64_t k = 0x9e3779b97f4a7c15;
+		const char *data = key.data();
+		const size_t size = key.size();
+		uint64_t a = 0, b = 0;
+
+		if (size >= 8) {
+			for (size_t i = 0; i + 16 < size; i += 8) {
+				memcpy(&b, data + i, 8);
+				a = (a ^ b) * k;
+			}
+			uint64_t c;
+			memcpy(&b, data + (size > 16 ? size - 16 : 0), 8);
+			memcpy(&c, data + size - 8, 8);
+			a ^= b;
+			b = c;
+		} else if (size >= 4) {
+			uint32_t c, d;
+			memcpy(&c, data, 4);
+			memcpy(&d, data + size - 4, 4);
+			a = c;
+			b = d;
+		} else if (size > 0) {
+			a = uint8_t(data[0]) | uint8_t(data[size / 2]) << 8;
+			b = uint8_t(data[size - 1]);
+		}
+
+		const uint64_t out = ((a ^ size) * k ^ b) * k;
+		// The low bits are the position in the index, mixing in the high ones
+		return out ^ out >> 32;
+	}
+
+	static uint64_t make_slot(uint64_t hash, size_t index)
+	{
+		return (hash & 0xffffffff00000000) | uint64_t(index + 1);
+	}
+
+	// The slot of the key in the index or the empty slot where it would go
+	size_t probe(string_view key, uint64_t hash) const
+	{
+		const size_t mask = slots.size() - 1;
+		for (size_t i = hash & mask;; i = (i + 1) & mask) {
+			const uint64_t slot = slots[i];
+			if (slot == 0) return i;
+			if (
+				(slot ^ hash) >> 32 == 0 &&
+				members[uint32_t(slot) - 1].first == key
+			) return i;
+		}
+	}
+
+	// The position of the member with the key (the size when there is none)
+	size_t find_index(string_view key) const
+	{
+		if (slots.empty()) {
+			// “==” of the keys compares the lengths first
+			for (size_t i = 0; i < members.size(); ++i)
+				if (members[i].first == key) return i;
+			return members.size();
+		}
+
+		const uint64_t slot = slots[probe(key, hash_key(key))];
+		return slot == 0 ? members.size() : uint32_t(slot) - 1;
+	}
+
+	void build_index()
+	{
+		size_t n = small_size * 2;
+		while (n < members.size() * 2) n *= 2;
+		slots.assign(n, 0);
+		for (size_t i = 0; i < members.size(); ++i) {
+			const uint64_t hash = hash_key(members[i].first);
+			slots[probe(members[i].first, hash)] = make_slot(hash, i);
+		}
+	}
+};
@@ -0,0 +1,242 @@
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "json/parallel.hpp"
+#include "json/structural-index.hpp"
+#include "json/types.hpp"
+#include "parser/types.hpp"
+#include "thread-pool.hpp"
+
+using namespace std;
+
+// Local shorthand
+using I = ParserInputType<Parser>;
+
+
+// A part of the input processed by one task
+struct Chunk
+{
+	size_t begin = 0;
+	size_t end = 0;
+	bool quotes_parity = false;
+	vector<size_t> index;
+	long depth_change = 0;
+	size_t index_offset = 0; // Of the first position in the whole index
+	vector<size_t> separators; // Positions in the whole index
+};
+
+// Stages 1 and 2 from “json/parallel.hpp”, the commas separating the top-level
+// elements are returned as positions in the index
+inline pair<vector<size_t>, vector<size_t>> parallel_structural_index(
+	ThreadPool &pool,
+	I input,
+	size_t chunk_size
+)
+{
+	vector<Chunk> chunks;
+	for (size_t begin = 0; begin < input.size(); begin += chunk_size) {
+		chunks.emplace_back();
+		chunks.back().begin = begin;
+		chunks.back().end = min(input.size(), begin + chunk_size);
+	}
+
+	for (auto &chunk : chunks)
+		pool.submit([input, &chunk]() {
+			chunk.quotes_parity =
+				unescaped_quotes_parity(input, chunk.begin, chunk.end);
+		});
+	pool.wait();
+
+	bool in_string = false;
+	for (auto &chunk : chunks) {
+		const StructuralState state =
+			structural_state_at(input, chunk.begin, in_string);
+		in_string ^= chunk.quotes_parity;
+
+		pool.submit([input, &chunk, state]() {
+			StructuralState chunk_state = state;
+			structural_index(
+				input,
+				chunk.begin,
+				chunk.end,
+				chunk_state,
+				chunk.index
+			);
+			for (size_t pos : chunk.index) {
+				const char c = input[pos];
+				if (c == '[' || c == '{') ++chunk.depth_change;
+				else if (c == ']' || c == '}') --chunk.depth_change;
+			}
+		});
+	}
+	pool.wait();
+
+	size_t index_size = 0;
+	long depth = 0;
+	vector<size_t> index;
+	vector<size_t> separators;
+
+	for (auto &chunk : chunks) {
+		chunk.index_offset = index_size;
+		index_size += chunk.index.size();
+
+		const long start_depth = depth;
+		depth += chunk.depth_change;
+
+		pool.submit([input, &chunk, start_depth]() {
+			long current_depth = start_depth;
+			for (size_t i = 0; i < chunk.index.size(); ++i) {
+				const char c = input[chunk.index[i]];
+				if (c == '[' || c == '{') ++current_depth;
+				else if (c == ']' || c == '}') --current_depth;
+				else if (c == ',' && current_depth == 1)
+					chunk.separators.push_back(chunk.index_offset + i);
+			}
+		});
+	}
+	pool.wait();
+
+	index.resize(index_size);
+	for (auto &chunk : chunks)
+		pool.submit([&index, &chunk]() {
+			copy(
+				chunk.index.begin(),
+				chunk.index.end(),
+				index.begin() + chunk.index_offset
+			);
+			chunk.index = vector<size_t>();
+		});
+	pool.wait();
+
+	for (auto &chunk : chunks)
+		separators.insert(
+			separators.end(),
+			chunk.separators.begin(),
+			chunk.separators.end()
+		);
+
+	return make_pair(move(index), move(separators));
+}
+
+// Parse groups of the top-level elements in parallel and stitch the results
+// together with “stitch” (in order)
+template <typename T, typename ParseGroup, typename Stitch>
+inline variant<ParsingError<I>, JsonValue> parse_groups(
+	ThreadPool &pool,
+	const vector<size_t> &index,
+	const vector<size_t> &separators,
+	ParseGroup parse_group,
+	Stitch stitch
+)
+{
+	const size_t elements_count = separators.size() + 1;
+	const size_t groups_count = min(elements_count, pool.size() * 8);
+	const size_t last = index.size() - 1; // Closing bracket
+
+	// Bounds of an element in the index (without the commas)
+	const auto element_begin = [&separators](size_t i) -> size_t {
+		return i == 0 ? 1 : separators[i - 1] + 1;
+	};
+	const auto element_end = [&separators, last](size_t i) -> size_t {
+		return i == separators.size() ? last : separators[i];
+	};
+
+	vector<variant<ParsingError<I>, T>> results(groups_count);
+	for (size_t group = 0; group < groups_count; ++group) {
+		const size_t first = group * elements_count / groups_count;
+		const size_t next = (group + 1) * elements_count / groups_count;
+		pool.submit([&, group, first, next]() {
+			results[group] =
+				parse_group(element_begin(first), element_end(next - 1));
+		});
+	}
+	pool.wait();
+
+	for (auto &x : results)
+		if (holds_alternative<ParsingError<I>>(x))
+			return get<ParsingError<I>>(x);
+
+	T stitched = move(get<T>(results[0]));
+	for (size_t group = 1; group < groups_count; ++group)
+		stitch(stitched, get<T>(results[group]));
+	return make_json_value(move(stitched));
+}
+
+variant<ParsingError<I>, JsonValue> parse_json_parallel(
+	ThreadPool &pool,
+	I input,
+	size_t min_chunk_size,
+	JsonParsingOptions options
+)
+{
+	// Chunks must be of a multiple of the stage 1 block size
+	const size_t block_size = 64;
+	const size_t min_size =
+		max(min_chunk_size, input.size() / (pool.size() * 4) + 1);
+	const size_t chunk_size =
+		(min_size + block_size - 1) / block_size * block_size;
+
+	if (chunk_size >= input.size()) return parse_json_structural(input, options);
+
+	const auto index_and_separators =
+		parallel_structural_index(pool, input, chunk_size);
+	const vector<size_t> &index = index_and_separators.first;
+	const vector<size_t> &separators = index_and_separators.second;
+
+	// Only a non-empty top-level array or object with nothing after it is
+	// split (everything else is not worth it)
+	if (index.size() <= 2) return parse_json_structural(input, options);
+	const char open = input[index.front()];
+	const char close = input[index.back()];
+
+	if (open == '[' && close == ']') {
+		return parse_groups<JsonArray>(
+			pool,
+			index,
+			separators,
+			[input, &index, options](size_t begin, size_t end)
+			-> variant<ParsingError<I>, JsonArray> {
+				auto x =
+					parse_indexed_elements(input, index, begin, end, options);
+				if (holds_alternative<ParsingError<I>>(x))
+					return get<ParsingError<I>>(x);
+				return make_json_array(move(get<vector<JsonValue>>(x)));
+			},
+			[](JsonArray &to, JsonArray &from) {
+				vector<JsonValue> &list = get<0>(to);
+				vector<JsonValue> &tail = get<0>(from);
+				list.insert(
+					list.end(),
+					make_move_iterator(tail.begin()),
+					make_move_iterator(tail.end())
+				);
+			}
+		);
+	} else if (open == '{' && close == '}') {
+		return parse_groups<JsonObject>(
+			pool,
+			index,
+			separators,
+			[input, &index, options](size_t begin, size_t end)
+			-> variant<ParsingError<I>, JsonObject> {
+				auto x =
+					parse_indexed_entries(input, index, begin, end, options);
+				if (holds_alternative<ParsingError<I>>(x))
+					return get<ParsingError<I>>(x);
+				return make_json_object(move(get<JsonMembers>(x)));
+			},
+			// First key wins, like in “make_map_from_vector”
+			[](JsonObject &to, JsonObject &from) {
+				for (auto &[ key, value ] : get<0>(from))
+					get<0>(to).try_emplace(move(key), move(value));
+			}
+		);
+	} else {
+		return parse_json_structural(input, options);
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+// Parsing of a single huge JSON document on multiple cores.
+//
+// It is built on top of the structural index engine
+// (see “json/structural-index.hpp”):
+//
+// 1. The input is split into chunks. Every chunk counts its quotes in parallel
+//    and a prefix scan of those counts tells which chunks start inside
+//    a string. Then every chunk builds its part of the structural index.
+// 2. A prefix scan of the nesting depth changes of the chunks gives the depth
+//    at the start of every chunk. Then the commas separating the elements of
+//    the top-level array (or the entries of the top-level object) are found in
+//    every chunk.
+// 3. The elements are split into groups which are parsed in parallel and the
+//    resulting lists (or maps) are stitched together.
+//
+// It gives the same results as “parse_json_structural” (only the error
+// messages may be different). A document which is not an array or an object
+// or which is too small to be split is parsed by “parse_json_structural”.
+
+#include <cstddef>
+#include <variant>
+
+#include "json/types.hpp"
+#include "parser/types.hpp"
+#include "thread-pool.hpp"
+
+using namespace std;
+
+
+// Mind that it waits for all the tasks of the pool
+// (see “ThreadPool::wait()”), so the pool should not be used by anything else
+// at the same time.
+variant<ParsingError<ParserInputType<Parser>>, JsonValue> parse_json_parallel(
+	ThreadPool &pool,
+	ParserInputType<Parser> input,
+	size_t min_chunk_size = 1 << 20,
+	JsonParsingOptions options = {}
+);
@@ -0,0 +1,184 @@
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "json/parse-context.hpp"
+#include "json/parsers.hpp"
+#include "json/sax.hpp"
+#include "json/types.hpp"
+#include "parser/types.hpp"
+
+using namespace std;
+
+// Local shorthand
+using I = ParserInputType<Parser>;
+
+
+// ParseContext {{{1
+
+// Helpers {{{2
+
+inline bool is_json_container(const JsonValue &x)
+{
+	return
+		holds_alternative<JsonArray>(x) ||
+		holds_alternative<JsonObject>(x);
+}
+
+// Takes the nested arrays and objects out of the value, so that it is
+// destroyed without any recursion. “nested” is where they go.
+inline void take_nested_values(JsonValue &json, vector<JsonValue> &nested)
+{
+	if (auto x = get_if<JsonArray>(&json)) {
+		for (JsonValue &item : get<0>(*x))
+			if (is_json_container(item)) nested.push_back(move(item));
+	} else if (auto x = get_if<JsonObject>(&json)) {
+		for (auto &entry : get<0>(*x))
+			if (is_json_container(entry.second))
+				nested.push_back(move(entry.second));
+	}
+}
+
+// }}}2
+
+void ParseContext::recycle(JsonValue &&json)
+{
+	// The nested arrays and objects wait here instead of the call stack (so
+	// that any depth is fine)
+	pending.push_back(move(json));
+
+	while (!pending.empty()) {
+		JsonValue x = move(pending.back());
+		pending.pop_back();
+		take_nested_values(x, pending);
+
+		if (auto y = get_if<JsonObject>(&x)) {
+			JsonMembers &members = get<0>(*y);
+			for (auto &[ key, value ] : members) {
+				recycle_string(key);
+				recycle_scalar(value);
+			}
+			members.clear();
+			if (members.capacity() > 0) objects.push_back(move(members));
+		} else if (auto y = get_if<JsonArray>(&x)) {
+			vector<JsonValue> &list = get<0>(*y);
+			for (JsonValue &item : list) recycle_scalar(item);
+			list.clear();
+			if (list.capacity() > 0) arrays.push_back(move(list));
+		} else {
+			recycle_scalar(x);
+		}
+	}
+}
+
+void ParseContext::recycle_scalar(JsonValue &x)
+{
+	if (auto y = get_if<JsonString>(&x))
+		// A view into the input has no storage of its own
+		if (auto s = get_if<string>(&get<0>(*y))) recycle_string(*s);
+}
+
+void ParseContext::recycle_string(string &x)
+{
+	// Short strings are stored in-place, there is nothing to keep
+	if (x.capacity() > string().capacity()) {
+		x.clear();
+		strings.push_back(move(x));
+	}
+}
+
+void ParseContext::recycle(vector<string> &&keys)
+{
+	for (string &key : keys) recycle_string(key);
+	keys.clear();
+	if (keys.capacity() > 0) key_lists.push_back(move(keys));
+}
+
+string ParseContext::take_string()
+{
+	if (strings.empty()) return string();
+	string s = move(strings.back());
+	strings.pop_back();
+	return s;
+}
+
+vector<JsonValue> ParseContext::take_array()
+{
+	if (arrays.empty()) return vector<JsonValue>();
+	vector<JsonValue> list = move(arrays.back());
+	arrays.pop_back();
+	return list;
+}
+
+JsonMembers ParseContext::take_object()
+{
+	if (objects.empty()) return JsonMembers();
+	JsonMembers members = move(objects.back());
+	objects.pop_back();
+	return members;
+}
+
+vector<string> ParseContext::take_key_list()
+{
+	if (key_lists.empty()) return vector<string>();
+	vector<string> keys = move(key_lists.back());
+	key_lists.pop_back();
+	return keys;
+}
+
+// }}}1
+
+
+// JsonValue {{{1
+
+// Takes the arrays and the objects that are not empty (the only ones that go
+// further down) out of the value, “nested” is where they go
+inline void take_nesting(JsonValue &json, vector<JsonValue> &nested)
+{
+	const auto is_nesting = [](const JsonValue &x) {
+		if (auto list = get_if<JsonArray>(&x)) return !get<0>(*list).empty();
+		if (auto entries = get_if<JsonObject>(&x))
+			return !get<0>(*entries).empty();
+		return false;
+	};
+
+	if (auto x = get_if<JsonArray>(&json)) {
+		for (JsonValue &item : get<0>(*x))
+			if (is_nesting(item)) nested.push_back(move(item));
+	} else if (auto x = get_if<JsonObject>(&json)) {
+		for (auto &entry : get<0>(*x))
+			if (is_nesting(entry.second)) nested.push_back(move(entry.second));
+	}
+}
+
+// The nested values wait here instead of the call stack, so what is left for
+// the destructors of the members is flat (nothing is allocated unless a
+// non-empty array or object is nested in this one)
+JsonValue::~JsonValue()
+{
+	vector<JsonValue> pending;
+	take_nesting(*this, pending);
+	while (!pending.empty()) {
+		JsonValue x = move(pending.back());
+		pending.pop_back();
+		take_nesting(x, pending);
+	}
+}
+
+// }}}1
+
+
+// The same grammar as “json_value() << end_of_input()” from
+// “json/parsers.cpp” (only the error messages are different), the document
+// is built by the event handler out of the context pools
+variant<ParsingError<I>, JsonValue> parse_json(
+	ParseContext &ctx,
+	I input,
+	JsonParsingOptions options
+)
+{
+	JsonValueBuilder builder(ctx, input, options);
+	if (auto err = parse_json_events(input, builder, options)) return *err;
+	return builder.take_result();
+}
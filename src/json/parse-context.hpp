@@ -0,0 +1,56 @@
+#pragma once
+
+// “ParseContext” keeps everything that is worth to keep between subsequent
+// “parse_json” calls when many documents are parsed one after another.
+//
+// The idea is that a parsed document which is not needed anymore is given back
+// to the context (see “recycle”). The context then tears it down into pools of
+// strings, arrays and objects keeping their capacity, and the next parsed
+// document is built out of those pools. So when the documents are kind of
+// similar (like in a request-per-document service) after some warm-up the
+// parsing is done without any memory allocation.
+//
+// Mind that a context is not thread-safe, use one context per thread.
+
+#include <string>
+#include <vector>
+
+#include "json/types.hpp"
+
+using namespace std;
+
+
+class ParseContext
+{
+public:
+	// Give a parsed document back to the context so that its storage would be
+	// reused for the next parsed documents (any depth is fine, there is no
+	// recursion)
+	void recycle(JsonValue &&x);
+	// A list of keys (for the keys that wait for their values while a
+	// document is built, see “json/sax.hpp”), the keys themselves are
+	// recycled too
+	void recycle(vector<string> &&keys);
+
+	// Empty string (with some capacity if there was a recycled one)
+	string take_string();
+	// Empty list (with some capacity if there was a recycled one)
+	vector<JsonValue> take_array();
+	// Empty members of an object (with some capacity if there were recycled
+	// ones)
+	JsonMembers take_object();
+	// Empty list of keys (with some capacity if there was a recycled one)
+	vector<string> take_key_list();
+
+private:
+	vector<string> strings;
+	vector<vector<JsonValue>> arrays;
+	vector<JsonMembers> objects;
+	vector<vector<string>> key_lists;
+	// Arrays and objects waiting to be recycled (see “recycle”)
+	vector<JsonValue> pending;
+
+	// Only the storage of the value itself, not of the nested values
+	void recycle_scalar(JsonValue &x);
+	void recycle_string(string &x);
+};
@@ -1,8 +1,11 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <tuple>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -11,6 +14,8 @@
 #include "abstractions/functor.hpp"
 #include "helpers.hpp"
 #include "json/parsers.hpp"
+#include "json/sax.hpp"
+#include "json/scanners.hpp"
 #include "json/types.hpp"
 #include "parser/parsers.hpp"
 #include "parser/resolvers.hpp"
@@ -18,6 +23,9 @@
 
 using namespace std;
 
+// Local shorthand
+using I = ParserInputType<Parser>;
+
 
 Parser<JsonNull> json_null()
 {
@@ -36,27 +44,92 @@ Parser<JsonBool> json_bool()
 	);
 }
 
-Parser<JsonNumber> json_number()
+// Single-pass hand-written scanner (see “json/scanners.hpp”) instead of
+// trying a fractional number first and then a decimal one
+inline ParsingResult<JsonNumber, I> scan_json_number(
+	I input,
+	const JsonParsingOptions &options
+)
 {
-	return prefix_parsing_failure(
-		"JsonNumber",
-		(function(make_json_number<double>) ^ signed_fractional()) ||
-		(function(make_json_number<int>) ^ signed_decimal())
+	if (input.empty() || !is_json_number_start(input[0]))
+		return make_parsing_error<I>("JsonNumber: digits are expected", input);
+
+	size_t pos = 0;
+	JsonNumber x;
+	const char *err = scan_json_number(
+		input,
+		pos,
+		x,
+		options.lazy_numbers,
+		options.shared_input
 	);
+
+	if (err != nullptr)
+		return make_parsing_error<I>(err, input.substr(pos));
+	else
+		return make_parsing_success<JsonNumber, I>(move(x), input.substr(pos));
 }
 
-// WARNING! This implementation is incomplete. For instance escaped unicode
-// characters are not supported (e.g. “\uD83D\uDE10”).
-// You can find more details here: https://www.ietf.org/rfc/rfc4627.txt
-Parser<JsonString> json_string()
+Parser<JsonNumber> json_number(JsonParsingOptions options)
 {
-	Parser<char> escaped_quote = '"' <= string_("\\\"");
-	Parser<char> non_quote_char = satisfy([](char x) { return x != '"'; });
-	return prefix_parsing_failure(
-		"JsonString",
-		(function(make_json_string) < function(chars_to_string<vector>))
-		^ char_('"') >> some(escaped_quote || non_quote_char) << char_('"')
-	);
+	return Parser<JsonNumber>{[options](I input) {
+		return scan_json_number(input, options);
+	}};
+}
+
+// Strings are most of the payload of a typical JSON document, so instead of
+// composing character parsers this one is a vectorized hand-written scanner
+// (see “json/scanners.hpp”). It supports all the escapes from RFC 8259.
+// You can find more details here: https://www.rfc-editor.org/rfc/rfc8259
+inline ParsingResult<JsonString, I> scan_json_string(
+	I input,
+	const JsonParsingOptions &options
+)
+{
+	if (input.empty() || input[0] != '"')
+		return make_parsing_error<I>(
+			"JsonString: opening quote is expected",
+			input
+		);
+
+	size_t pos = 0;
+	JsonString x;
+	const char *err = scan_json_string_value(input, pos, options, string(), x);
+
+	if (err != nullptr)
+		return make_parsing_error<I>(err, input.substr(pos));
+	else
+		return make_parsing_success<JsonString, I>(move(x), input.substr(pos));
+}
+
+Parser<JsonString> json_string(JsonParsingOptions options)
+{
+	return Parser<JsonString>{[options](I input) {
+		return scan_json_string(input, options);
+	}};
+}
+
+// Same as “json_string” and “json_number” with “lazy_numbers” option, but the
+// strings and the numbers are views into the input kept by “owner” (see
+// “shared_input” option). The owner is only referenced weakly, so that a cached grammar (see
+// “json_grammar” below) does not keep the input alive.
+inline Parser<JsonString> owned_json_string(weak_ptr<const void> owner)
+{
+	return Parser<JsonString>{[owner](I input) {
+		JsonParsingOptions options;
+		options.shared_input = owner.lock();
+		return scan_json_string(input, options);
+	}};
+}
+
+inline Parser<JsonNumber> owned_json_number(weak_ptr<const void> owner)
+{
+	return Parser<JsonNumber>{[owner](I input) {
+		JsonParsingOptions options;
+		options.lazy_numbers = true;
+		options.shared_input = owner.lock();
+		return scan_json_number(input, options);
+	}};
 }
 
 Parser<string> spacer()
@@ -67,17 +140,10 @@ Parser<string> spacer()
 	return function(chars_to_string<vector>) ^ many(spacer_char);
 }
 
-// Lazy evaluation (avoid infinite recursion)
-inline Parser<JsonValue> lazy_json_value()
-{
-	return Parser<JsonValue>{[](auto input) { return json_value()(input); }};
-}
-
-Parser<JsonArray> json_array()
+inline Parser<JsonArray> json_array_of(Parser<JsonValue> value)
 {
 	Parser<char> separator = spacer() >> char_(',') << spacer();
-	Parser<vector<JsonValue>> elements =
-		separated_some(lazy_json_value(), separator);
+	Parser<vector<JsonValue>> elements = separated_some(value, separator);
 	return prefix_parsing_failure(
 		"JsonArray",
 		char_('[') >> spacer()
@@ -86,7 +152,12 @@ Parser<JsonArray> json_array()
 	);
 }
 
-Parser<JsonObject> json_object()
+Parser<JsonArray> json_array(JsonParsingOptions options)
+{
+	return json_array_of(json_value(options));
+}
+
+inline Parser<JsonObject> json_object_of(Parser<JsonValue> value)
 {
 	Parser<char> separator = spacer() >> char_(',') << spacer();
 	using Entry = tuple<string, JsonValue>;
@@ -94,10 +165,10 @@ Parser<JsonObject> json_object()
 	Parser<Entry> entry =
 		function(curry<Entry, string, JsonValue>(make_tuple<string, JsonValue>))
 		^ (function(from_json_string) ^ json_string()) << spacer() << char_(':')
-		^ spacer() >> lazy_json_value();
+		^ spacer() >> value;
 
-	Parser<map<string, JsonValue>> entries =
-		function(make_map_from_vector<string, JsonValue>)
+	Parser<JsonMembers> entries =
+		function(make_map_from_vector<JsonValue>)
 		^ optional_list(separated_some(entry, separator));
 
 	return prefix_parsing_failure(
@@ -107,24 +178,191 @@ Parser<JsonObject> json_object()
 	);
 }
 
-Parser<JsonValue> json_value()
+Parser<JsonObject> json_object(JsonParsingOptions options)
+{
+	return json_object_of(json_value(options));
+}
+
+inline Parser<JsonValue> json_value_of(
+	Parser<JsonNumber> number,
+	Parser<JsonString> string,
+	Parser<JsonValue> nested
+)
 {
 	return prefix_parsing_failure(
 		"JsonValue",
 		spacer() >> (
 			(function(make_json_value<JsonNull>) ^ json_null())
 			|| (function(make_json_value<JsonBool>) ^ json_bool())
-			|| (function(make_json_value<JsonNumber>) ^ json_number())
-			|| (function(make_json_value<JsonString>) ^ json_string())
-			|| (function(make_json_value<JsonArray>) ^ json_array())
-			|| (function(make_json_value<JsonObject>) ^ json_object())
+			|| (function(make_json_value<JsonNumber>) ^ number)
+			|| (function(make_json_value<JsonString>) ^ string)
+			|| (function(make_json_value<JsonArray>) ^ json_array_of(nested))
+			|| (function(make_json_value<JsonObject>) ^ json_object_of(nested))
 		) << spacer()
 	);
 }
 
+struct JsonGrammar
+{
+	Parser<JsonValue> value;
+	// The value with nothing after it
+	Parser<JsonValue> document;
+};
+
+// The levels of nesting the grammars are in on this thread (the call stack
+// is per thread, so is its depth)
+static thread_local size_t grammar_depth = 0;
+
+// Counts the levels of nesting around “value”. An array or an object deeper
+// than “max_depth” fails (like any other failure inside an array or an object
+// it is reported by the one around it), and the one nested too deep to
+// recurse (see “recursive_json_max_depth”) is built on the heap instead.
+inline Parser<JsonValue> depth_limited_json_value(
+	Parser<JsonValue> value,
+	bool lazy_numbers,
+	weak_ptr<const void> owner,
+	size_t max_depth
+)
+{
+	return Parser<JsonValue>{[=](I input) -> ParsingResult<JsonValue, I> {
+		size_t pos = 0;
+		while (pos < input.size() && is_json_spacer(input[pos])) ++pos;
+		const bool is_nesting =
+			pos < input.size() && (input[pos] == '[' || input[pos] == '{');
+
+		if (is_nesting && grammar_depth >= max_depth)
+			return make_parsing_error<I>(
+				json_too_deep_failure,
+				input.substr(pos)
+			);
+
+		if (!is_nesting || grammar_depth < recursive_json_max_depth) {
+			++grammar_depth;
+			auto result = value(input);
+			--grammar_depth;
+			return result;
+		}
+
+		JsonParsingOptions options;
+		options.lazy_numbers = lazy_numbers;
+		options.shared_input = owner.lock();
+		if (max_depth != SIZE_MAX) options.max_depth = max_depth - grammar_depth;
+		JsonValue x;
+		if (const char *err = parse_json_value_at(input, pos, x, options))
+			return make_parsing_error<I>(err, input.substr(pos));
+		return make_parsing_success<JsonValue, I>(move(x), input.substr(pos));
+	}};
+}
+
+// The nested values of the grammar are parsed by the grammar itself. They
+// refer to it without owning it (it would never be released otherwise), the
+// grammar is kept alive by whoever runs it.
+inline shared_ptr<const JsonGrammar> make_grammar(
+	bool lazy_numbers,
+	const shared_ptr<const void> &owner,
+	size_t max_depth
+)
+{
+	auto grammar = make_shared<JsonGrammar>();
+	const Parser<JsonValue> *self = &grammar->value;
+
+	JsonParsingOptions options;
+	options.lazy_numbers = lazy_numbers;
+	grammar->value = depth_limited_json_value(
+		json_value_of(
+			owner != nullptr && lazy_numbers
+				? owned_json_number(owner)
+				: json_number(options),
+			owner != nullptr ? owned_json_string(owner) : json_string(),
+			Parser<JsonValue>{[self](I input) { return (*self)(input); }}
+		),
+		lazy_numbers,
+		owner,
+		max_depth
+	);
+	grammar->document = grammar->value << end_of_input();
+	return grammar;
+}
+
+// The grammar is built only once for every combination of “lazy_numbers” and
+// “max_depth” options and the owner of the input (see “shared_input” option)
+// and then it is shared by all the nested values and all the “parse_json”
+// calls (see the note on thread-safety in “parser/types.hpp”). The grammars
+// of the inputs that were released are dropped when another one is added.
+inline shared_ptr<const JsonGrammar> json_grammar(
+	const JsonParsingOptions &options
+)
+{
+	static const shared_ptr<const JsonGrammar> grammars[] = {
+		make_grammar(false, nullptr, SIZE_MAX),
+		make_grammar(true, nullptr, SIZE_MAX),
+	};
+	if (options.shared_input == nullptr && options.max_depth == SIZE_MAX)
+		return grammars[options.lazy_numbers];
+
+	struct Key
+	{
+		weak_ptr<const void> owner;
+		bool is_owned;
+		bool lazy_numbers;
+		size_t max_depth;
+	};
+	struct KeyLess
+	{
+		bool operator()(const Key &a, const Key &b) const
+		{
+			return owner_less<>()(a.owner, b.owner) || (
+				!owner_less<>()(b.owner, a.owner) &&
+				make_pair(a.lazy_numbers, a.max_depth) <
+					make_pair(b.lazy_numbers, b.max_depth)
+			);
+		}
+	};
+	static mutex cache_mutex;
+	static map<Key, shared_ptr<const JsonGrammar>, KeyLess> cache;
+
+	const lock_guard<mutex> lock(cache_mutex);
+	const Key key {
+		options.shared_input,
+		options.shared_input != nullptr,
+		options.lazy_numbers,
+		options.max_depth,
+	};
+	auto found = cache.find(key);
+	if (found != cache.end()) return found->second;
+
+	for (auto i = cache.begin(); i != cache.end();) {
+		const bool is_released = i->first.is_owned && i->first.owner.expired();
+		i = is_released ? cache.erase(i) : next(i);
+	}
+	return cache.emplace(
+		key,
+		make_grammar(
+			options.lazy_numbers,
+			options.shared_input,
+			options.max_depth
+		)
+	).first->second;
+}
+
+// “shared_input” is ignored, the grammar does not keep the owner of the input
+const Parser<JsonValue>& shared_json_value(JsonParsingOptions options)
+{
+	options.shared_input = nullptr;
+	return json_grammar(options)->value;
+}
+
+Parser<JsonValue> json_value(JsonParsingOptions options)
+{
+	return Parser<JsonValue>{[grammar = json_grammar(options)](I input) {
+		return grammar->value(input);
+	}};
+}
+
 variant<ParsingError<ParserInputType<Parser>>, JsonValue> parse_json(
-	ParserInputType<Parser> input
+	ParserInputType<Parser> input,
+	JsonParsingOptions options
 )
 {
-	return parse<JsonValue>(json_value() << end_of_input(), input);
+	return parse<JsonValue>(json_grammar(options)->document, input);
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "json/parse-context.hpp"
 #include "json/types.hpp"
 #include "parser/types.hpp"
 
@@ -7,13 +8,25 @@
 // Parsers
 Parser<JsonNull> json_null();
 Parser<JsonBool> json_bool();
-Parser<JsonNumber> json_number();
-Parser<JsonString> json_string();
-Parser<JsonArray> json_array();
-Parser<JsonObject> json_object();
-Parser<JsonValue> json_value();
+Parser<JsonNumber> json_number(JsonParsingOptions options = {});
+Parser<JsonString> json_string(JsonParsingOptions options = {});
+Parser<JsonArray> json_array(JsonParsingOptions options = {});
+Parser<JsonObject> json_object(JsonParsingOptions options = {});
+Parser<JsonValue> json_value(JsonParsingOptions options = {});
+
+// Same as “json_value()” but built only once, safe to call concurrently
+const Parser<JsonValue>& shared_json_value(JsonParsingOptions options = {});
 
 // Parsing
+// (mind that the tail in a parsing error is a view into the input)
+variant<ParsingError<ParserInputType<Parser>>, JsonValue> parse_json(
+	ParserInputType<Parser> input,
+	JsonParsingOptions options = {}
+);
+
+// Parsing reusing the storage kept in the context (see “json/parse-context.hpp”)
 variant<ParsingError<ParserInputType<Parser>>, JsonValue> parse_json(
-	ParserInputType<Parser> input
+	ParseContext &ctx,
+	ParserInputType<Parser> input,
+	JsonParsingOptions options = {}
 );
@@ -0,0 +1,51 @@
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "json/pointer.hpp"
+
+using namespace std;
+
+
+const char* split_json_pointer(string_view pointer, vector<string> &tokens)
+{
+	tokens.clear();
+	if (pointer.empty()) return nullptr;
+	if (pointer[0] != '/') return "JsonPointer: pointer must start with “/”";
+
+	tokens.emplace_back();
+	for (size_t i = 1; i < pointer.size(); ++i) {
+		const char c = pointer[i];
+		if (c == '/') {
+			tokens.emplace_back();
+		} else if (c != '~') {
+			tokens.back() += c;
+		} else if (
+			i + 1 < pointer.size() &&
+			(pointer[i + 1] == '0' || pointer[i + 1] == '1')
+		) {
+			tokens.back() += pointer[++i] == '0' ? '~' : '/';
+		} else {
+			return "JsonPointer: “~” must be followed by “0” or “1”";
+		}
+	}
+	return nullptr;
+}
+
+optional<size_t> json_pointer_array_index(string_view token)
+{
+	if (
+		token.empty() ||
+		token.size() > 18 ||
+		(token[0] == '0' && token.size() > 1)
+	) return nullopt;
+
+	size_t out = 0;
+	for (char c : token) {
+		if (c < '0' || c > '9') return nullopt;
+		out = out * 10 + (c - '0');
+	}
+	return out;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+// JSON Pointer (RFC 6901): “/a/3/b” is the value of the key “b” of the fourth
+// element of the value of the key “a”, the empty one is the root value. In
+// the reference tokens “~1” stands for “/” and “~0” stands for “~”.
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+
+// Decoded reference tokens of the pointer. Returns an error message or
+// “nullptr” on success.
+const char* split_json_pointer(string_view pointer, vector<string> &tokens);
+
+// Array index of a decoded reference token (no leading zeros, “-” is past the
+// end of the array, so it is never an index)
+optional<size_t> json_pointer_array_index(string_view token);
@@ -0,0 +1,466 @@
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "json/parse-context.hpp"
+#include "json/sax.hpp"
+#include "json/scanners.hpp"
+#include "json/tape.hpp"
+#include "json/types.hpp"
+#include "parser/types.hpp"
+
+using namespace std;
+
+// Local shorthand
+using I = ParserInputType<Parser>;
+
+
+// Events {{{1
+
+// No events at all, strings are only checked and not decoded
+struct JsonValidator
+{
+	bool on_null() { return true; }
+	bool on_bool(bool) { return true; }
+	bool on_number(JsonNumber &&) { return true; }
+	bool on_string(string_view) { return true; }
+	bool on_array_begin() { return true; }
+	bool on_array_end() { return true; }
+	bool on_object_begin() { return true; }
+	bool on_key(string_view) { return true; }
+	bool on_object_end() { return true; }
+};
+
+// Arrays and objects being parsed, a bit per level (“true” for an object).
+// The innermost 64 levels are kept in place, so that a usual document is
+// parsed without any allocation, the outer ones go to the heap.
+class NestingStack
+{
+public:
+	void push(bool is_object)
+	{
+		if (count == 64) {
+			outer.push_back(bits);
+			count = 0;
+		}
+		bits = (bits << 1) | uint64_t(is_object);
+		++count;
+	}
+
+	// Mind that it must not be empty
+	bool pop()
+	{
+		const bool x = bits & 1;
+		bits >>= 1;
+		if (--count == 0 && !outer.empty()) {
+			bits = outer.back();
+			outer.pop_back();
+			count = 64;
+		}
+		return x;
+	}
+
+private:
+	uint64_t bits = 0;
+	size_t count = 0;
+	vector<uint64_t> outer;
+};
+
+// Same grammar as the other engines but the nesting is kept in an explicit
+// stack on the heap instead of the call stack (so it is limited only by
+// “max_depth” option) and every token goes to the handler (the handler type
+// is known for the builders and “JsonValidator”, so that their events
+// can be inlined)
+template <typename Handler>
+struct EventParser
+{
+	static constexpr bool validating = is_same_v<Handler, JsonValidator>;
+
+	Handler &handler;
+	I input;
+	JsonParsingOptions options;
+	size_t pos = 0;
+	// For the strings with escapes
+	string buffer = string();
+	// Of the arrays and the objects being parsed
+	size_t depth = 0;
+	// The innermost one is an object (the outer ones are in “nesting”)
+	bool in_object = false;
+	NestingStack nesting = NestingStack();
+	const char *failure = "";
+	size_t failure_pos = 0;
+
+	bool fail(const char *message)
+	{
+		failure = message;
+		failure_pos = pos;
+		return false;
+	}
+
+	// The handler returned “false” for the token at “start”
+	bool stop(size_t start)
+	{
+		pos = start;
+		return fail("JsonHandler: parsing is stopped by the handler");
+	}
+
+	void skip_spacer()
+	{
+		while (pos < input.size() && is_json_spacer(input[pos])) ++pos;
+	}
+
+	bool parse_literal(const char *literal)
+	{
+		for (size_t i = 0; literal[i] != '\0'; ++i)
+			if (pos + i >= input.size() || input[pos + i] != literal[i])
+				return fail("JsonValue: unexpected literal");
+		pos += char_traits<char>::length(literal);
+		return true;
+	}
+
+	bool parse_string(string_view &out)
+	{
+		const char *err = validating
+			? validate_json_string(input, pos)
+			: scan_json_string(input, pos, out, buffer);
+		return err == nullptr || fail(err);
+	}
+
+	// Skips the whitespace after the value
+	bool parse_scalar()
+	{
+		const size_t start = pos;
+		bool ok;
+		switch (input[pos]) {
+			case 'n':
+				ok = parse_literal("null") && (handler.on_null() || stop(start));
+				break;
+			case 't':
+				ok = parse_literal("true") && (handler.on_bool(true) || stop(start));
+				break;
+			case 'f':
+				ok =
+					parse_literal("false") &&
+					(handler.on_bool(false) || stop(start));
+				break;
+			case '"': {
+				string_view x;
+				ok = parse_string(x) && (handler.on_string(x) || stop(start));
+				break;
+			}
+			default:
+				if (is_json_number_start(input[pos])) {
+					JsonNumber x;
+					// The text of a lazy number would be copied for nothing
+					const char *err = scan_json_number(
+						input,
+						pos,
+						x,
+						options.lazy_numbers && !validating,
+						options.shared_input
+					);
+					ok =
+						(err == nullptr || fail(err)) &&
+						(handler.on_number(move(x)) || stop(start));
+				} else {
+					ok = fail("JsonValue: unexpected character");
+				}
+		}
+
+		if (ok) skip_spacer();
+		return ok;
+	}
+
+	// At “[” or “{”, skips the whitespace after it
+	bool begin(bool is_object)
+	{
+		if (depth >= options.max_depth)
+			return fail(json_too_deep_failure);
+
+		const size_t start = pos++;
+		if (!(is_object ? handler.on_object_begin() : handler.on_array_begin()))
+			return stop(start);
+		if (depth++ > 0) nesting.push(in_object);
+		in_object = is_object;
+		skip_spacer();
+		return true;
+	}
+
+	// A key and “:” after it
+	bool parse_key()
+	{
+		skip_spacer();
+		if (pos >= input.size() || input[pos] != '"')
+			return fail("JsonObject: key is expected");
+
+		const size_t key_start = pos;
+		string_view key;
+		if (!parse_string(key)) return false;
+		if (!handler.on_key(key)) return stop(key_start);
+
+		skip_spacer();
+		if (pos >= input.size() || input[pos] != ':')
+			return fail("JsonObject: “:” is expected");
+		++pos;
+		return true;
+	}
+
+	// The closing bracket of the innermost array or object, skips the
+	// whitespace after it
+	bool end()
+	{
+		if (pos >= input.size() || input[pos] != (in_object ? '}' : ']'))
+			return fail(
+				in_object
+					? "JsonObject: “}” is expected"
+					: "JsonArray: “]” is expected"
+			);
+
+		if (!(in_object ? handler.on_object_end() : handler.on_array_end()))
+			return stop(pos);
+		++pos;
+		if (--depth > 0) in_object = nesting.pop();
+		skip_spacer();
+		return true;
+	}
+
+	// The whole value with everything nested in it, skips the whitespace
+	// around it
+	bool parse_value()
+	{
+		for (;;) {
+			skip_spacer();
+			if (pos >= input.size()) return fail("JsonValue: input is empty");
+
+			// An empty array or object is finished right away, otherwise its
+			// first element or the value of its first key goes next
+			switch (input[pos]) {
+				case '[':
+					if (!begin(false)) return false;
+					if (pos < input.size() && input[pos] != ']') continue;
+					if (!end()) return false;
+					break;
+				case '{':
+					if (!begin(true)) return false;
+					if (pos < input.size() && input[pos] != '}') {
+						if (!parse_key()) return false;
+						continue;
+					}
+					if (!end()) return false;
+					break;
+				default:
+					if (!parse_scalar()) return false;
+			}
+
+			// The value is done, so are the arrays and the objects that end
+			// after it
+			for (;;) {
+				if (depth == 0) return true;
+				if (pos < input.size() && input[pos] == ',') {
+					++pos;
+					if (in_object && !parse_key()) return false;
+					break;
+				}
+				if (!end()) return false;
+			}
+		}
+	}
+};
+
+template <typename Handler>
+inline optional<ParsingError<I>> run_event_parser(
+	I input,
+	Handler &handler,
+	const JsonParsingOptions &options
+)
+{
+	EventParser<Handler> parser {handler, input, options};
+
+	bool ok = parser.parse_value();
+	if (ok && parser.pos < input.size())
+		ok = parser.fail("end_of_input: input is not empty");
+
+	if (ok) return nullopt;
+
+	return make_parsing_error<I>(
+		parser.failure,
+		input.substr(parser.failure_pos)
+	);
+}
+
+optional<ParsingError<I>> parse_json_events(
+	I input,
+	JsonHandler &handler,
+	JsonParsingOptions options
+)
+{
+	return run_event_parser(input, handler, options);
+}
+
+optional<ParsingError<I>> parse_json_events(
+	I input,
+	JsonValueBuilder &builder,
+	JsonParsingOptions options
+)
+{
+	return run_event_parser(input, builder, options);
+}
+
+optional<ParsingError<I>> parse_json_events(
+	I input,
+	JsonTapeBuilder &builder,
+	JsonParsingOptions options
+)
+{
+	return run_event_parser(input, builder, options);
+}
+
+optional<ParsingError<I>> validate_json(I input, JsonParsingOptions options)
+{
+	JsonValidator validator;
+	return run_event_parser(input, validator, options);
+}
+
+const char *parse_json_value_at(
+	I input,
+	size_t &pos,
+	JsonValue &out,
+	JsonParsingOptions options
+)
+{
+	ParseContext ctx;
+	JsonValueBuilder builder(ctx, input, options);
+	EventParser<JsonValueBuilder> parser {builder, input, options, pos};
+
+	if (!parser.parse_value()) {
+		pos = parser.failure_pos;
+		return parser.failure;
+	}
+	pos = parser.pos;
+	out = builder.take_result();
+	return nullptr;
+}
+
+// }}}1
+
+
+// Document builder {{{1
+
+JsonValueBuilder::JsonValueBuilder(
+	ParseContext &ctx,
+	I input,
+	JsonParsingOptions options
+):
+	ctx(ctx),
+	input(input),
+	options(move(options)),
+	stack(ctx.take_array()),
+	keys(ctx.take_key_list())
+{}
+
+JsonValueBuilder::~JsonValueBuilder()
+{
+	for (JsonValue &x : stack) ctx.recycle(move(x));
+	stack.clear();
+	ctx.recycle(JsonValue{make_json_array(move(stack))});
+	ctx.recycle(move(keys));
+}
+
+// Puts a finished value into the array or the object it belongs to
+bool JsonValueBuilder::add(JsonValue &&x)
+{
+	if (stack.empty()) {
+		result = move(x);
+		return true;
+	}
+
+	if (auto list = get_if<JsonArray>(&stack.back())) {
+		get<0>(*list).push_back(move(x));
+		return true;
+	}
+
+	// First key wins, like in “make_map_from_vector” (the key and the value
+	// are left as they were when they are not added)
+	JsonMembers &members = get<0>(get<JsonObject>(stack.back()));
+	if (!members.try_emplace(move(keys.back()), move(x)).second) {
+		ctx.recycle(move(x));
+		ctx.recycle(JsonValue{make_json_string(move(keys.back()))});
+	}
+	keys.pop_back();
+	return true;
+}
+
+bool JsonValueBuilder::on_null()
+{
+	return add(JsonValue{JsonNull{unit()}});
+}
+
+bool JsonValueBuilder::on_bool(bool x)
+{
+	return add(JsonValue{make_json_bool(x)});
+}
+
+bool JsonValueBuilder::on_number(JsonNumber &&x)
+{
+	return add(JsonValue{move(x)});
+}
+
+bool JsonValueBuilder::on_string(string_view x)
+{
+	// A view into the input (see “shared_input” option), an empty string is
+	// not worth keeping the input alive
+	if (
+		options.shared_input != nullptr &&
+		!x.empty() &&
+		x.data() >= input.data() &&
+		x.data() + x.size() <= input.data() + input.size()
+	) return add(JsonValue{make_shared_json_string(options.shared_input, x)});
+
+	string s = ctx.take_string();
+	s.assign(x);
+	return add(JsonValue{make_json_string(move(s))});
+}
+
+bool JsonValueBuilder::on_array_begin()
+{
+	stack.push_back(JsonValue{make_json_array(ctx.take_array())});
+	return true;
+}
+
+bool JsonValueBuilder::on_array_end()
+{
+	JsonValue x = move(stack.back());
+	stack.pop_back();
+	return add(move(x));
+}
+
+bool JsonValueBuilder::on_object_begin()
+{
+	stack.push_back(JsonValue{make_json_object(ctx.take_object())});
+	return true;
+}
+
+bool JsonValueBuilder::on_key(string_view x)
+{
+	keys.push_back(ctx.take_string());
+	keys.back().assign(x);
+	return true;
+}
+
+bool JsonValueBuilder::on_object_end()
+{
+	return on_array_end();
+}
+
+JsonValue JsonValueBuilder::take_result()
+{
+	return move(result);
+}
+
+// }}}1
@@ -0,0 +1,134 @@
+#pragma once
+
+// Push-style (SAX) parsing: instead of building a “JsonValue” the parser calls
+// a handler for every token of the document. So a consumer that needs only
+// some aggregates of a document does not keep the document in memory (only
+// the nesting depth matters).
+//
+// It accepts exactly the same grammar as “parse_json” from “json/parsers.hpp”.
+// The nesting is kept on the heap, so unlike the recursive engines it takes
+// any depth (up to “max_depth” option).
+// “JsonValueBuilder” is the handler that builds the document (that is how
+// “parse_json” with a context is done, see “json/parse-context.hpp”).
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "json/parse-context.hpp"
+#include "json/types.hpp"
+#include "parser/types.hpp"
+
+using namespace std;
+
+
+// Every event returns whether to go on, so that a handler can stop as soon as
+// it got everything it needs. All the events are ignored by default.
+//
+// Strings and keys are views, either into the input or into a buffer of the
+// parser when there were escapes (so they are valid only during the call).
+class JsonHandler
+{
+public:
+	virtual ~JsonHandler() = default;
+
+	virtual bool on_null() { return true; }
+	virtual bool on_bool(bool) { return true; }
+	virtual bool on_number(JsonNumber &&) { return true; }
+	virtual bool on_string(string_view) { return true; }
+
+	virtual bool on_array_begin() { return true; }
+	virtual bool on_array_end() { return true; }
+
+	virtual bool on_object_begin() { return true; }
+	// Every value of an object is preceded by its key
+	virtual bool on_key(string_view) { return true; }
+	virtual bool on_object_end() { return true; }
+};
+
+// Returns the error if the document is malformed or if the handler stopped
+// the parsing (the tail of the error starts at the token of that event).
+// Only “lazy_numbers” and “max_depth” options make a difference here.
+optional<ParsingError<ParserInputType<Parser>>> parse_json_events(
+	ParserInputType<Parser> input,
+	JsonHandler &handler,
+	JsonParsingOptions options = {}
+);
+
+// Builds the document out of the storage kept in the context. Mind that the
+// context must outlive the builder.
+class JsonValueBuilder final: public JsonHandler
+{
+public:
+	// “input” and “options” are needed only for “shared_input” option
+	JsonValueBuilder(
+		ParseContext &ctx,
+		ParserInputType<Parser> input = {},
+		JsonParsingOptions options = {}
+	);
+	// The storage of an unfinished document goes back to the context
+	~JsonValueBuilder();
+
+	bool on_null() override;
+	bool on_bool(bool x) override;
+	bool on_number(JsonNumber &&x) override;
+	bool on_string(string_view x) override;
+	bool on_array_begin() override;
+	bool on_array_end() override;
+	bool on_object_begin() override;
+	bool on_key(string_view x) override;
+	bool on_object_end() override;
+
+	// The document after the last event
+	JsonValue take_result();
+
+private:
+	ParseContext &ctx;
+	ParserInputType<Parser> input;
+	JsonParsingOptions options;
+	// Unfinished arrays and objects
+	vector<JsonValue> stack;
+	// Keys of the values being built (one per unfinished object value)
+	vector<string> keys;
+	JsonValue result;
+
+	bool add(JsonValue &&x);
+};
+
+// Same as above but the events of the builder are not virtual calls
+optional<ParsingError<ParserInputType<Parser>>> parse_json_events(
+	ParserInputType<Parser> input,
+	JsonValueBuilder &builder,
+	JsonParsingOptions options = {}
+);
+
+// Writes a flat document (see “json/tape.hpp”)
+class JsonTapeBuilder;
+
+// Same as above for the builder of a flat document
+optional<ParsingError<ParserInputType<Parser>>> parse_json_events(
+	ParserInputType<Parser> input,
+	JsonTapeBuilder &builder,
+	JsonParsingOptions options = {}
+);
+
+// Only checks that the input is JSON, the same as “parse_json_events” with
+// a handler that ignores everything but with nothing decoded or built at all
+// (no strings, no containers, no allocations except for the stack of very
+// deep nesting). Only “max_depth” option makes a difference here.
+optional<ParsingError<ParserInputType<Parser>>> validate_json(
+	ParserInputType<Parser> input,
+	JsonParsingOptions options = {}
+);
+
+// Builds the value at “pos” of the input (skipping the whitespace around it)
+// and moves “pos” past it. Returns the failure (then “pos” is where it is) or
+// “nullptr”. That is how the engines that recurse build the values nested
+// deeper than “recursive_json_max_depth”.
+const char *parse_json_value_at(
+	ParserInputType<Parser> input,
+	size_t &pos,
+	JsonValue &out,
+	JsonParsingOptions options = {}
+);
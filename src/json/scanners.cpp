@@ -0,0 +1,598 @@
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <string_view>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "json/decimal-to-double.hpp"
+#include "json/scanners.hpp"
+#include "json/types.hpp"
+
+using namespace std;
+
+
+inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+// SWAR (SIMD within a register) {{{1
+
+// 8 characters as a little-endian integer (the first one is the lowest byte)
+inline uint64_t load_eight_chars(const char *p)
+{
+	uint64_t x;
+	memcpy(&x, p, sizeof(x));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	x = __builtin_bswap64(x);
+#endif
+	return x;
+}
+
+// Whether all 8 characters are digits
+inline bool is_eight_digits(uint64_t x)
+{
+	// High nibbles must be “3” and low nibbles must not overflow when 6 is
+	// added (so they are not greater than 9)
+	return
+		((x & 0xF0F0F0F0F0F0F0F0) |
+			(((x + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) ==
+		0x3333333333333333;
+}
+
+// Value of 8 digits, pairs of digits are combined, then pairs of pairs and so
+// on (3 multiplications instead of 8)
+inline uint32_t parse_eight_digits(uint64_t x)
+{
+	x -= 0x3030303030303030;
+	x = (x * 10) + (x >> 8);
+	x =
+		(((x & 0x000000FF000000FF) * (100 + (1000000ULL << 32))) +
+			(((x >> 16) & 0x000000FF000000FF) * (1 + (10000ULL << 32)))) >> 32;
+	return uint32_t(x);
+}
+
+// Moves “pos” past the digits accumulating them into “value” (it wraps around
+// when there are more than 19 digits, the caller must count them)
+inline void scan_digits(string_view input, size_t &pos, uint64_t &value)
+{
+	while (input.size() - pos >= 8) {
+		const uint64_t chunk = load_eight_chars(input.data() + pos);
+		if (!is_eight_digits(chunk)) break;
+		value = value * 100000000 + parse_eight_digits(chunk);
+		pos += 8;
+	}
+	for (; pos < input.size() && is_digit(input[pos]); ++pos)
+		value = value * 10 + (input[pos] - '0');
+}
+
+// }}}1
+
+// Exact conversion of “input[begin, end)” for the rare numbers that can not
+// be converted by “decimal_to_double”. A number too close to 0 becomes 0
+// (like with “strtod”), “tiny” tells it from a number that is too big.
+inline const char* exact_decimal_to_double(
+	string_view input,
+	size_t begin,
+	size_t end,
+	bool negative,
+	bool tiny,
+	double &out
+)
+{
+	const from_chars_result result = from_chars(
+		input.data() + begin,
+		input.data() + end,
+		out,
+		chars_format::general
+	);
+	if (result.ec == errc::result_out_of_range && tiny)
+		out = 0;
+	else if (result.ec != errc() || result.ptr != input.data() + end)
+		return "JsonNumber: value is out of “double” bounds";
+	if (negative) out = -out;
+	return nullptr;
+}
+
+const char* scan_json_number(
+	string_view input,
+	size_t &pos,
+	JsonNumber &out,
+	bool lazy,
+	const shared_ptr<const void> &shared_input
+)
+{
+	const size_t start = pos;
+	const bool negative = input[pos] == '-';
+	if (negative) ++pos;
+
+	const size_t int_start = pos;
+	uint64_t mantissa = 0;
+	scan_digits(input, pos, mantissa);
+	const size_t int_end = pos;
+
+	if (int_end == int_start) {
+		pos = start;
+		return "JsonNumber: digits are expected";
+	}
+	if (input[int_start] == '0' && int_end - int_start > 1) {
+		pos = int_start;
+		return "JsonNumber: leading zeros are not allowed";
+	}
+
+	// The zero of “0.…” does not count
+	size_t significant_start = int_start;
+	while (significant_start < int_end && input[significant_start] == '0')
+		++significant_start;
+	size_t significant_digits = int_end - significant_start;
+	// Leading zeros of the fraction when the integer part is 0
+	size_t fraction_zeros = 0;
+
+	// Fraction
+	const bool has_fraction =
+		pos + 1 < input.size() &&
+		input[pos] == '.' &&
+		is_digit(input[pos + 1]);
+	size_t fraction_digits = 0;
+
+	if (has_fraction) {
+		const size_t fraction_start = ++pos;
+		scan_digits(input, pos, mantissa);
+		fraction_digits = pos - fraction_start;
+
+		if (significant_digits > 0) {
+			significant_digits += fraction_digits;
+		} else {
+			while (
+				fraction_zeros < fraction_digits &&
+				input[fraction_start + fraction_zeros] == '0'
+			) ++fraction_zeros;
+			significant_digits = fraction_digits - fraction_zeros;
+		}
+	}
+
+	// Exponent (it is not a part of the number without digits after “e”)
+	int64_t exponent = 0;
+	bool has_exponent = false;
+
+	if (pos < input.size() && (input[pos] | 0x20) == 'e') {
+		size_t i = pos + 1;
+		const bool negative_exponent = i < input.size() && input[i] == '-';
+		if (i < input.size() && (input[i] == '-' || input[i] == '+')) ++i;
+
+		if (i < input.size() && is_digit(input[i])) {
+			has_exponent = true;
+			for (; i < input.size() && is_digit(input[i]); ++i)
+				// Anything bigger is out of bounds anyway
+				if (exponent < 100000) exponent = exponent * 10 + (input[i] - '0');
+			if (negative_exponent) exponent = -exponent;
+			pos = i;
+		}
+	}
+
+	// The position of the first significant digit relative to the point
+	const int64_t magnitude =
+		exponent + int64_t(int_end - significant_start) - int64_t(fraction_zeros);
+
+	// Only a number that is too big can fail to convert (a number that is too
+	// close to 0 just becomes 0), an integer one too (it becomes “double”
+	// when it does not fit into 64 bits)
+	if (lazy && magnitude < 308) {
+		const string_view text = input.substr(start, pos - start);
+		out = shared_input == nullptr
+			? make_raw_json_number(string(text))
+			: make_shared_raw_json_number(shared_input, text);
+		return nullptr;
+	}
+
+	// Integer number
+	if (!has_fraction && !has_exponent) {
+		bool fits = significant_digits <= 19;
+
+		// Might fit or not
+		if (significant_digits == 20) {
+			mantissa = 0;
+			fits = true;
+			for (size_t i = significant_start; i < int_end && fits; ++i)
+				fits =
+					!__builtin_mul_overflow(mantissa, 10, &mantissa) &&
+					!__builtin_add_overflow(mantissa, input[i] - '0', &mantissa);
+		}
+
+		const uint64_t int64_max = uint64_t(INT64_MAX);
+		if (fits && !negative) {
+			out = mantissa <= int64_max
+				? make_json_number<int64_t>(int64_t(mantissa))
+				: make_json_number<uint64_t>(mantissa);
+			return nullptr;
+		} else if (fits && mantissa <= int64_max + 1) {
+			out = make_json_number<int64_t>(
+				mantissa == int64_max + 1 ? INT64_MIN : -int64_t(mantissa)
+			);
+			return nullptr;
+		}
+		// Otherwise it is converted to “double”
+	}
+
+	double x;
+	if (
+		significant_digits > 19 ||
+		!decimal_to_double(
+			mantissa,
+			exponent - int64_t(fraction_digits),
+			negative,
+			x
+		)
+	) {
+		const char *err = exact_decimal_to_double(
+			input, int_start, pos, negative, magnitude < 0, x
+		);
+		if (err != nullptr) {
+			pos = int_start;
+			return err;
+		}
+	}
+
+	out = make_json_number<double>(x);
+	return nullptr;
+}
+
+JsonNumberValue convert_raw_json_number(string_view x)
+{
+	size_t pos = 0;
+	JsonNumber y;
+	// Only a number that was not validated by the scanner can fail
+	if (
+		x.empty() ||
+		!is_json_number_start(x[0]) ||
+		scan_json_number(x, pos, y) != nullptr ||
+		pos != x.size()
+	) return numeric_limits<double>::quiet_NaN();
+	return get<JsonNumberValue>(get<0>(y));
+}
+
+// Position of the first quote, backslash or control character starting from
+// “pos” (the size of the input if there is none)
+inline size_t find_string_special_char(string_view input, size_t pos)
+{
+	const char *const data = input.data();
+
+#if defined(__AVX2__)
+	const __m256i quote = _mm256_set1_epi8('"');
+	const __m256i backslash = _mm256_set1_epi8('\\');
+	const __m256i control_max = _mm256_set1_epi8(0x1F);
+	for (; input.size() - pos >= 32; pos += 32) {
+		const __m256i c = _mm256_loadu_si256((const __m256i*) (data + pos));
+		const __m256i special = _mm256_or_si256(
+			_mm256_or_si256(
+				_mm256_cmpeq_epi8(c, quote),
+				_mm256_cmpeq_epi8(c, backslash)
+			),
+			// Unsigned “c <= 0x1F”
+			_mm256_cmpeq_epi8(_mm256_max_epu8(c, control_max), control_max)
+		);
+		const uint32_t mask = _mm256_movemask_epi8(special);
+		if (mask != 0) return pos + __builtin_ctz(mask);
+	}
+#elif defined(__SSE2__)
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	const __m128i control_max = _mm_set1_epi8(0x1F);
+	for (; input.size() - pos >= 16; pos += 16) {
+		const __m128i c = _mm_loadu_si128((const __m128i*) (data + pos));
+		const __m128i special = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(c, quote), _mm_cmpeq_epi8(c, backslash)),
+			// Unsigned “c <= 0x1F”
+			_mm_cmpeq_epi8(_mm_max_epu8(c, control_max), control_max)
+		);
+		const uint32_t mask = _mm_movemask_epi8(special);
+		if (mask != 0) return pos + __builtin_ctz(mask);
+	}
+#endif
+
+	for (; pos < input.size(); ++pos) {
+		const unsigned char c = data[pos];
+		if (c == '"' || c == '\\' || c <= 0x1F) return pos;
+	}
+	return pos;
+}
+
+inline bool parse_hex4(string_view input, size_t pos, uint32_t &out)
+{
+	if (pos + 4 > input.size()) return false;
+	out = 0;
+	for (size_t i = pos; i < pos + 4; ++i) {
+		const char c = input[i];
+		uint32_t digit;
+		if (c >= '0' && c <= '9') digit = c - '0';
+		else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+		else return false;
+		out = out * 16 + digit;
+	}
+	return true;
+}
+
+// Takes anything instead of the decoded string (for the validation)
+struct DiscardedString
+{
+	void push_back(char) {}
+};
+
+template <typename Out>
+inline void append_utf8(uint32_t code_point, Out &out)
+{
+	if (code_point < 0x80) {
+		out.push_back(char(code_point));
+	} else if (code_point < 0x800) {
+		out.push_back(char(0xC0 | (code_point >> 6)));
+		out.push_back(char(0x80 | (code_point & 0x3F)));
+	} else if (code_point < 0x10000) {
+		out.push_back(char(0xE0 | (code_point >> 12)));
+		out.push_back(char(0x80 | ((code_point >> 6) & 0x3F)));
+		out.push_back(char(0x80 | (code_point & 0x3F)));
+	} else {
+		out.push_back(char(0xF0 | (code_point >> 18)));
+		out.push_back(char(0x80 | ((code_point >> 12) & 0x3F)));
+		out.push_back(char(0x80 | ((code_point >> 6) & 0x3F)));
+		out.push_back(char(0x80 | (code_point & 0x3F)));
+	}
+}
+
+// “pos” points at a backslash, on success it is moved past the escape
+template <typename Out>
+inline const char* decode_escape(string_view input, size_t &pos, Out &out)
+{
+	if (pos + 1 >= input.size()) return "JsonString: closing quote is expected";
+
+	switch (input[pos + 1]) {
+		case '"': out.push_back('"'); break;
+		case '\\': out.push_back('\\'); break;
+		case '/': out.push_back('/'); break;
+		case 'b': out.push_back('\b'); break;
+		case 'f': out.push_back('\f'); break;
+		case 'n': out.push_back('\n'); break;
+		case 'r': out.push_back('\r'); break;
+		case 't': out.push_back('\t'); break;
+		case 'u': {
+			uint32_t code_point;
+			if (!parse_hex4(input, pos + 2, code_point))
+				return "JsonString: “\\u” must be followed by 4 hex digits";
+
+			if (code_point >= 0xDC00 && code_point <= 0xDFFF)
+				return "JsonString: unpaired UTF-16 low surrogate";
+
+			if (code_point >= 0xD800 && code_point <= 0xDBFF) {
+				uint32_t low;
+				if (
+					pos + 8 > input.size() ||
+					input[pos + 6] != '\\' ||
+					input[pos + 7] != 'u' ||
+					!parse_hex4(input, pos + 8, low) ||
+					low < 0xDC00 || low > 0xDFFF
+				)
+					return "JsonString: unpaired UTF-16 high surrogate";
+
+				code_point =
+					0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+				pos += 6;
+			}
+
+			append_utf8(code_point, out);
+			pos += 6;
+			return nullptr;
+		}
+		default:
+			return "JsonString: unknown escape sequence";
+	}
+
+	pos += 2;
+	return nullptr;
+}
+
+const char* scan_json_string(
+	string_view input,
+	size_t &pos,
+	string_view &out,
+	string &buffer
+)
+{
+	const size_t start = ++pos; // Skipping opening quote
+	bool decoding = false; // Whether anything was put into the buffer
+
+	for (;;) {
+		const size_t special = find_string_special_char(input, pos);
+
+		if (special >= input.size()) {
+			pos = input.size();
+			return "JsonString: closing quote is expected";
+		} else if (input[special] == '"') {
+			if (decoding) {
+				buffer.append(input, pos, special - pos);
+				out = buffer;
+			} else {
+				out = input.substr(start, special - start);
+			}
+			pos = special + 1; // Skipping closing quote
+			return nullptr;
+		} else if (input[special] != '\\') {
+			pos = special;
+			return "JsonString: control characters must be escaped";
+		}
+
+		if (!decoding) {
+			buffer.clear();
+			decoding = true;
+		}
+
+		// Copying the whole run before the escape at once
+		buffer.append(input, pos, special - pos);
+		pos = special;
+		const char *err = decode_escape(input, pos, buffer);
+		if (err != nullptr) return err;
+	}
+}
+
+const char* validate_json_string(string_view input, size_t &pos)
+{
+	DiscardedString discarded;
+	for (++pos;;) { // Skipping opening quote
+		pos = find_string_special_char(input, pos);
+
+		if (pos >= input.size()) {
+			return "JsonString: closing quote is expected";
+		} else if (input[pos] == '"') {
+			++pos; // Skipping closing quote
+			return nullptr;
+		} else if (input[pos] != '\\') {
+			return "JsonString: control characters must be escaped";
+		}
+
+		const char *err = decode_escape(input, pos, discarded);
+		if (err != nullptr) return err;
+	}
+}
+
+const char* scan_json_string(string_view input, size_t &pos, string &out)
+{
+	string_view view;
+	const char *err = scan_json_string(input, pos, view, out);
+	// When it is not a view into “out” already
+	if (err == nullptr && view.data() != out.data()) out.assign(view);
+	return err;
+}
+
+const char* scan_json_string_value(
+	string_view input,
+	size_t &pos,
+	const JsonParsingOptions &options,
+	string &&buffer,
+	JsonString &out
+)
+{
+	if (options.shared_input == nullptr) {
+		const char *err = scan_json_string(input, pos, buffer);
+		if (err == nullptr) out = make_json_string(move(buffer));
+		return err;
+	}
+
+	string_view view;
+	const char *err = scan_json_string(input, pos, view, buffer);
+	if (err != nullptr) return err;
+
+	if (view.data() == buffer.data()) {
+		out = make_json_string(move(buffer));
+	} else if (view.empty()) {
+		// Not worth keeping the input alive
+		buffer.clear();
+		out = make_json_string(move(buffer));
+	} else {
+		out = make_shared_json_string(options.shared_input, view);
+	}
+	return nullptr;
+}
+
+// Position of the first quote or bracket starting from “pos” (the size of the
+// input if there is none)
+inline size_t find_nesting_char(string_view input, size_t pos)
+{
+	const char *const data = input.data();
+
+	// “[” and “{”, “]” and “}” differ only in 0x20 bit
+#if defined(__AVX2__)
+	const __m256i quote = _mm256_set1_epi8('"');
+	const __m256i bit = _mm256_set1_epi8(0x20);
+	const __m256i open = _mm256_set1_epi8('{');
+	const __m256i close = _mm256_set1_epi8('}');
+	for (; input.size() - pos >= 32; pos += 32) {
+		const __m256i c = _mm256_loadu_si256((const __m256i*) (data + pos));
+		const __m256i lower = _mm256_or_si256(c, bit);
+		const __m256i special = _mm256_or_si256(
+			_mm256_cmpeq_epi8(c, quote),
+			_mm256_or_si256(
+				_mm256_cmpeq_epi8(lower, open),
+				_mm256_cmpeq_epi8(lower, close)
+			)
+		);
+		const uint32_t mask = _mm256_movemask_epi8(special);
+		if (mask != 0) return pos + __builtin_ctz(mask);
+	}
+#elif defined(__SSE2__)
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i bit = _mm_set1_epi8(0x20);
+	const __m128i open = _mm_set1_epi8('{');
+	const __m128i close = _mm_set1_epi8('}');
+	for (; input.size() - pos >= 16; pos += 16) {
+		const __m128i c = _mm_loadu_si128((const __m128i*) (data + pos));
+		const __m128i lower = _mm_or_si128(c, bit);
+		const __m128i special = _mm_or_si128(
+			_mm_cmpeq_epi8(c, quote),
+			_mm_or_si128(_mm_cmpeq_epi8(lower, open), _mm_cmpeq_epi8(lower, close))
+		);
+		const uint32_t mask = _mm_movemask_epi8(special);
+		if (mask != 0) return pos + __builtin_ctz(mask);
+	}
+#endif
+
+	for (; pos < input.size(); ++pos) {
+		const char c = data[pos] | 0x20;
+		if (data[pos] == '"' || c == '{' || c == '}') return pos;
+	}
+	return pos;
+}
+
+// “pos” points at the opening quote, nothing is decoded or checked
+inline const char* skip_json_string(string_view input, size_t &pos)
+{
+	for (++pos;;) {
+		pos = find_string_special_char(input, pos);
+		if (pos < input.size() && input[pos] == '"') break;
+		if (pos + 1 >= input.size()) {
+			pos = input.size();
+			return "JsonString: closing quote is expected";
+		}
+		// A backslash skips the next character, control characters are ignored
+		pos += input[pos] == '\\' ? 2 : 1;
+	}
+	++pos;
+	return nullptr;
+}
+
+const char* skip_json_nesting(string_view input, size_t &pos, size_t depth)
+{
+	for (;;) {
+		pos = find_nesting_char(input, pos);
+		if (pos >= input.size()) return "JsonValue: closing bracket is expected";
+
+		const char c = input[pos];
+		if (c == '"') {
+			if (const char *err = skip_json_string(input, pos)) return err;
+			continue;
+		}
+
+		++pos;
+		if (c == '[' || c == '{') ++depth;
+		else if (--depth == 0) return nullptr;
+	}
+}
+
+const char* skip_json_value(string_view input, size_t &pos)
+{
+	const char c = input[pos];
+	if (c == '"') return skip_json_string(input, pos);
+	if (c == '[' || c == '{') return skip_json_nesting(input, ++pos, 1);
+
+	if (!is_json_number_start(c) && c != 't' && c != 'f' && c != 'n')
+		return "JsonValue: unexpected character";
+	// Up to the next token
+	while (
+		pos < input.size() &&
+		!is_json_spacer(input[pos]) &&
+		input[pos] != ',' && input[pos] != ']' && input[pos] != '}'
+	) ++pos;
+	return nullptr;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+// Low-level scanners shared by the hand-written JSON engines (the ones that do
+// not compose parsers, like the one in “json/parse-context.cpp”). They accept
+// exactly the same grammar as the parsers from “json/parsers.cpp”.
+//
+// A scanner starts at “pos” and moves it past the scanned token. On success
+// it returns “nullptr”, on failure it returns an error message and “pos”
+// points at the failure.
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "json/types.hpp"
+
+using namespace std;
+
+
+// Whitespace between the tokens
+inline bool is_json_spacer(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Minus or digit
+inline bool is_json_number_start(char c)
+{
+	return c == '-' || (c >= '0' && c <= '9');
+}
+
+// Optional minus, digits (no leading zeros), optionally “.” with more digits
+// and optionally an exponent (“e” or “E”, optional sign and digits), in a
+// single pass (the grammar of RFC 8259).
+//
+// An integer number is “int64_t” (“uint64_t” when it is bigger than that).
+// A number with a fraction or an exponent and an integer number that does not
+// fit into 64 bits are “double”. Digits are converted 8 at a time (SWAR),
+// “double” is correctly rounded (see “json/decimal-to-double.hpp”, the rare
+// cases left are converted with “from_chars”). There are no allocations, no
+// locale and no exceptions.
+//
+// When “lazy” is set the number is only validated and its source text is
+// kept as “RawJsonNumber” (see “JsonParsingOptions” in “json/types.hpp”), a
+// view into the input when “shared_input” keeps it. A number that might be out
+// of “double” bounds is still converted to report the overflow.
+const char* scan_json_number(
+	string_view input,
+	size_t &pos,
+	JsonNumber &out,
+	bool lazy = false,
+	const shared_ptr<const void> &shared_input = nullptr
+);
+
+// “pos” points at the opening quote. All the escapes from RFC 8259 are
+// resolved (“\uXXXX” is encoded as UTF-8, UTF-16 surrogate pairs are combined
+// and unpaired surrogates are rejected). Control characters must be escaped.
+//
+// When there are no escapes the result is a view into the input (zero-copy),
+// otherwise the string is decoded into “buffer” and the result is a view into
+// the buffer.
+const char* scan_json_string(
+	string_view input,
+	size_t &pos,
+	string_view &out,
+	string &buffer
+);
+
+// Same as above but the result is always put into “out”
+const char* scan_json_string(string_view input, size_t &pos, string &out);
+
+// Same checks as above but nothing is decoded
+const char* validate_json_string(string_view input, size_t &pos);
+
+// String value (see “shared_input” in “JsonParsingOptions”). “buffer” is
+// used for a decoded string and is moved into the value (it can come from
+// a pool of strings).
+const char* scan_json_string_value(
+	string_view input,
+	size_t &pos,
+	const JsonParsingOptions &options,
+	string &&buffer,
+	JsonString &out
+);
+
+// Skippers move “pos” past a value only matching the brackets and the quotes
+// (with the escapes), the contents are not validated. They are for the values
+// nobody is going to look at (see “json/cursor.hpp”).
+//
+// “pos” points at the first character of the value
+const char* skip_json_value(string_view input, size_t &pos);
+// “pos” is inside of “depth” arrays/objects, it is moved past the closing
+// bracket of the outermost one
+const char* skip_json_nesting(string_view input, size_t &pos, size_t depth);
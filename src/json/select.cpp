@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "json/cursor.hpp"
+#include "json/pointer.hpp"
+#include "json/select.hpp"
+#include "json/types.hpp"
+#include "parser/types.hpp"
+
+using namespace std;
+
+// Local shorthand
+using I = ParserInputType<Parser>;
+
+
+// Helpers {{{1
+
+struct Selection
+{
+	I input;
+	const vector<vector<string>> &paths;
+	vector<vector<string_view>> values;
+	optional<ParsingError<I>> failure;
+};
+
+inline bool fail(Selection &x, const JsonCursor &cursor)
+{
+	const ParsingError<I> err = *cursor.error();
+	// A cursor over a selected value has only that value, but it is a part of
+	// the input anyway
+	x.failure = make_parsing_error<I>(
+		err.first,
+		x.input.substr(err.second.data() - x.input.data())
+	);
+	return false;
+}
+
+// The value at the cursor for the “active” paths (all of them have at least
+// “depth” tokens). “rest_needed” means that something is read after the value,
+// so the cursor has to get past it. Otherwise the cursor is just left where
+// the last value was found.
+inline bool select_value(
+	Selection &x,
+	JsonCursor &cursor,
+	const vector<size_t> &active,
+	size_t depth,
+	bool rest_needed
+)
+{
+	vector<size_t> deeper;
+	for (size_t i : active)
+		if (x.paths[i].size() > depth) deeper.push_back(i);
+
+	if (deeper.size() < active.size()) {
+		string_view source;
+		if (!cursor.get_source(source)) return fail(x, cursor);
+		for (size_t i : active)
+			if (x.paths[i].size() == depth) x.values[i].push_back(source);
+		if (deeper.empty()) return true;
+
+		// The longer paths go into the same value once again
+		JsonCursor inner(source);
+		return select_value(x, inner, deeper, depth, false);
+	}
+
+	const JsonValueKind kind = cursor.peek();
+	if (kind == JsonValueKind::None) {
+		cursor.skip();
+		return fail(x, cursor);
+	}
+	if (kind != JsonValueKind::Object && kind != JsonValueKind::Array)
+		return !rest_needed || cursor.skip() || fail(x, cursor);
+
+	const bool is_object = kind == JsonValueKind::Object;
+	if (!(is_object ? cursor.enter_object() : cursor.enter_array()))
+		return fail(x, cursor);
+
+	// The paths that go into every member and the ones that go into a single
+	// member that is not found yet (with its array index)
+	vector<size_t> wildcards;
+	vector<pair<size_t, size_t>> waiting;
+	for (size_t i : active) {
+		const string &token = x.paths[i][depth];
+		if (token == "*") {
+			wildcards.push_back(i);
+		} else if (is_object) {
+			waiting.emplace_back(i, 0);
+		} else if (auto index = json_pointer_array_index(token)) {
+			waiting.emplace_back(i, *index);
+		}
+	}
+
+	string_view key;
+	vector<size_t> matching;
+	for (size_t index = 0;; ++index) {
+		// Nothing more to find here
+		if (wildcards.empty() && waiting.empty())
+			return !rest_needed || cursor.leave() || fail(x, cursor);
+
+		// At the end the array or the object is left
+		if (!(is_object ? cursor.next_key(key) : cursor.next_element()))
+			return !cursor.error().has_value() || fail(x, cursor);
+
+		matching = wildcards;
+		for (size_t j = 0; j < waiting.size();)
+			if (
+				is_object
+					? x.paths[waiting[j].first][depth] == key
+					: waiting[j].second == index
+			) {
+				matching.push_back(waiting[j].first);
+				waiting.erase(waiting.begin() + j);
+			} else {
+				++j;
+			}
+		// The member that is not used is skipped by the next step
+		if (matching.empty()) continue;
+
+		const bool more = !wildcards.empty() || !waiting.empty();
+		if (!select_value(x, cursor, matching, depth + 1, more || rest_needed))
+			return false;
+	}
+}
+
+// }}}1
+
+
+variant<ParsingError<I>, vector<vector<string_view>>> select_json(
+	I input,
+	const vector<vector<string>> &paths
+)
+{
+	Selection x{input, paths, vector<vector<string_view>>(paths.size()), {}};
+	if (paths.empty()) return x.values;
+
+	vector<size_t> all;
+	for (size_t i = 0; i < paths.size(); ++i) all.push_back(i);
+
+	JsonCursor cursor(input);
+	if (!select_value(x, cursor, all, 0, false)) return *x.failure;
+
+	// The whole document is selected, so the input must end with it (what is
+	// inside of it is checked by the engine that parses it)
+	const bool whole = any_of(
+		paths.begin(),
+		paths.end(),
+		[](const vector<string> &path) { return path.empty(); }
+	);
+	if (whole && !cursor.finish()) {
+		fail(x, cursor);
+		return *x.failure;
+	}
+	return x.values;
+}
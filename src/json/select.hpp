@@ -0,0 +1,37 @@
+#pragma once
+
+// Projection of a document: only the values at the given paths are taken out
+// of it. A path is a JSON Pointer (see “json/pointer.hpp”) where a “*” token
+// matches every key of an object and every element of an array, like
+// “/phoneNumbers/*/number”.
+//
+// The matching is done while the document is walked with a cursor (see
+// “json/cursor.hpp”), so the values that no path goes into are skipped by
+// matching the brackets and the quotes and nothing is built for them. The walk
+// stops as soon as there is nothing more to find (with no “*” in the paths it
+// is right after the last value is found). The selected values are given as
+// their source text, so that they are parsed by any of the engines.
+//
+// Mind that the skipped values and everything after the walk stops are not
+// validated (like with the cursor). Except for the empty path (the whole
+// document), then nothing but whitespace is allowed after the root value.
+
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "parser/types.hpp"
+
+using namespace std;
+
+
+// Source texts of the values for every path (see “split_json_pointer” for the
+// tokens of the paths) in the order of the document. A path can select
+// nothing. The first of the same keys wins (like with the other engines) but
+// “*” matches all of them.
+variant<ParsingError<ParserInputType<Parser>>, vector<vector<string_view>>>
+select_json(
+	ParserInputType<Parser> input,
+	const vector<vector<string>> &paths
+);
@@ -1,6 +1,8 @@
-#include <map>
-#include <sstream>
+#include <charconv>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -11,125 +13,153 @@
 using namespace std;
 
 
-string serialize_json(JsonString);
-string serialize_json(JsonValue, string, string, string);
-
-string serialize_json(
-	JsonObject x,
-	string line_break,
-	string block_indent,
-	string cur_indent
-)
-{
-	map<string, JsonValue> map = from_json_object(x);
-	if (map.empty()) return "{}";
-
-	ostringstream out;
-	out << "{" << line_break;
-	bool first (true);
-
-	for (pair<string, JsonValue> x : map) {
-		if (first) first = false; else out << "," << line_break;
-		out
-			<< block_indent << cur_indent
-			<< serialize_json(make_json_string(x.first))
-			<< ":"
-			<< (block_indent.empty() && line_break.empty() ? "" : " ")
-			<< serialize_json(
-				x.second,
-				line_break,
-				block_indent,
-				cur_indent + block_indent
-			);
-	}
-
-	out << line_break << cur_indent << "}";
-	return out.str();
-}
-
-string serialize_json(
-	JsonArray x,
-	string line_break,
-	string block_indent,
-	string cur_indent
-)
-{
-	vector<JsonValue> array = from_json_array(x);
-	if (array.empty()) return "[]";
-
-	ostringstream out;
-	out << "[" << line_break;
-	bool first (true);
-
-	for (JsonValue x : array) {
-		if (first) first = false; else out << "," << line_break;
-		out
-			<< block_indent << cur_indent
-			<< serialize_json(
-				x,
-				line_break,
-				block_indent,
-				cur_indent + block_indent
-			);
-	}
-
-	out << line_break << cur_indent << "]";
-	return out.str();
-}
-
-string serialize_json(JsonString x)
+void serialize_json_string(string_view x, string &out)
 {
-	ostringstream out;
-	out << "\"";
-	for (auto &ch : from_json_string(x))
-		if (ch == '"')
-			out << "\\\"";
-		else
-			out << ch;
-	out << "\"";
-	return out.str();
+	out += '"';
+	for (char ch : x)
+		switch (ch) {
+			case '"': out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\b': out += "\\b"; break;
+			case '\f': out += "\\f"; break;
+			case '\n': out += "\\n"; break;
+			case '\r': out += "\\r"; break;
+			case '\t': out += "\\t"; break;
+			default:
+				// The rest of the control characters
+				if (static_cast<unsigned char>(ch) < 0x20) {
+					out += "\\u00";
+					out += "0123456789abcdef"[ch >> 4];
+					out += "0123456789abcdef"[ch & 0xf];
+				} else {
+					out += ch;
+				}
+		}
+	out += '"';
 }
 
 string serialize_json(JsonNumber x)
 {
+	// The source text as is (see “lazy_numbers” parsing option)
+	if (auto raw = get_if<RawJsonNumber>(&get<0>(x)))
+		return string(raw_json_number_view(*raw));
+
 	return visit(overloaded {
-		[](int x) -> string { return to_string(x); },
-		[](double x) -> string { return to_string(x); }
+		[](int64_t x) -> string { return to_string(x); },
+		[](uint64_t x) -> string { return to_string(x); },
+		// The shortest representation that is parsed back to the same value.
+		// It always has a dot or an exponent so that it is parsed back as
+		// “double” and not as an integer number.
+		[](double x) -> string {
+			char buffer[32];
+			char *end = to_chars(buffer, buffer + sizeof(buffer), x).ptr;
+			string result(buffer, end);
+			if (result.find_first_of(".e") == string::npos) result += ".0";
+			return result;
+		}
 	}, from_json_number(x));
 }
 
-string serialize_json(JsonBool x)
+// Arrays and objects are written with a stack of the unfinished ones instead
+// of recursion, so a document of any depth is fine (like the ones parsed with
+// a context, see “json/sax.hpp”), and everything goes into a single string
+inline void write_json_value(
+	const JsonValue &json,
+	const string &line_break,
+	const string &block_indent,
+	string &out
+)
 {
-	return from_json_bool(x) ? "true" : "false";
+	// An unfinished array or object and how many of its values are written
+	struct Frame
+	{
+		const JsonValue *value;
+		size_t written;
+	};
+	vector<Frame> stack;
+
+	// Nothing to repeat for the compact output (so that it is not a loop over
+	// the depth for every value)
+	const auto indent = [&block_indent, &out](size_t depth) {
+		if (block_indent.empty()) return;
+		for (size_t i = 0; i < depth; ++i) out += block_indent;
+	};
+	const char *key_separator =
+		block_indent.empty() && line_break.empty() ? ":" : ": ";
+
+	// The next value to write (“nullptr” when a value was just finished)
+	const JsonValue *x = &json;
+	for (;;) {
+		if (x != nullptr) {
+			if (auto object = get_if<JsonObject>(x)) {
+				if (get<0>(*object).empty()) {
+					out += "{}";
+				} else {
+					out += '{';
+					stack.push_back(Frame{x, 0});
+				}
+			} else if (auto array = get_if<JsonArray>(x)) {
+				if (get<0>(*array).empty()) {
+					out += "[]";
+				} else {
+					out += '[';
+					stack.push_back(Frame{x, 0});
+				}
+			} else if (auto str = get_if<JsonString>(x)) {
+				serialize_json_string(json_string_view(*str), out);
+			} else if (auto number = get_if<JsonNumber>(x)) {
+				out += serialize_json(*number);
+			} else if (auto boolean = get_if<JsonBool>(x)) {
+				out += get<0>(*boolean) ? "true" : "false";
+			} else {
+				out += "null";
+			}
+		}
+
+		if (stack.empty()) return;
+		Frame &frame = stack.back();
+		auto object = get_if<JsonObject>(frame.value);
+		const size_t size = object != nullptr
+			? get<0>(*object).size()
+			: get<0>(get<JsonArray>(*frame.value)).size();
+
+		if (frame.written == size) {
+			out += line_break;
+			indent(stack.size() - 1);
+			out += object != nullptr ? '}' : ']';
+			stack.pop_back();
+			x = nullptr;
+			continue;
+		}
+
+		if (frame.written > 0) out += ',';
+		out += line_break;
+		indent(stack.size());
+		// In the order of the members
+		if (object != nullptr) {
+			auto &[ key, value ] = *(get<0>(*object).begin() + frame.written);
+			serialize_json_string(key, out);
+			out += key_separator;
+			x = &value;
+		} else {
+			x = &get<0>(get<JsonArray>(*frame.value))[frame.written];
+		}
+		++frame.written;
+	}
 }
 
 string serialize_json(
-	JsonValue json,
-	string line_break,
-	string block_indent,
-	string cur_indent
+	const JsonValue &json,
+	const string &line_break,
+	const string &block_indent
 )
 {
-	return visit(overloaded {
-		[line_break, block_indent, cur_indent](JsonObject x) -> string {
-			return serialize_json(x, line_break, block_indent, cur_indent);
-		},
-		[line_break, block_indent, cur_indent](JsonArray x) -> string {
-			return serialize_json(x, line_break, block_indent, cur_indent);
-		},
-		[](JsonString x) -> string { return serialize_json(x); },
-		[](JsonNumber x) -> string { return serialize_json(x); },
-		[](JsonBool x) -> string { return serialize_json(x); },
-		[](JsonNull) -> string { return "null"; }
-	}, from_json_value(json));
-}
-
-string serialize_json(JsonValue json, string line_break, string block_indent)
-{
-	return serialize_json(json, line_break, block_indent, "");
+	string out;
+	write_json_value(json, line_break, block_indent, out);
+	return out;
 }
 
-string serialize_json(JsonValue json)
+string serialize_json(const JsonValue &json)
 {
 	return serialize_json(json, "", "");
 }
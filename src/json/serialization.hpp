@@ -1,11 +1,24 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 
 #include "json/types.hpp"
 
 using namespace std;
 
 
-string serialize_json(JsonValue, string line_separator, string block_indent);
-string serialize_json(JsonValue);
+// Any depth is fine (there is no recursion)
+string serialize_json(
+	const JsonValue &,
+	const string &line_separator,
+	const string &block_indent
+);
+string serialize_json(const JsonValue &);
+
+// Pieces of the above, also used by the streaming transcoder (see
+// “json/transcoder.hpp”)
+
+// Appends the quoted and escaped string to “out”
+void serialize_json_string(string_view x, string &out);
+string serialize_json(JsonNumber);
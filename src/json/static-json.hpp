@@ -0,0 +1,604 @@
+#pragma once
+
+// Compile-time parsing of embedded JSON literals (requires C++20).
+//
+// The literal is parsed during compilation into read-only tables of nodes and
+// characters, so it costs nothing at start-up and malformed JSON becomes a
+// compile error. It accepts the same grammar as “parse_json” does.
+//
+//   static constexpr auto config = static_json<R"({ "port": 8080 })">();
+//   static_assert(config.root()["port"].as_int() == 8080);
+//
+//   // If a “JsonValue” is needed at run-time
+//   JsonValue x = to_json_value(config.root());
+//
+// Numbers with a fraction or an exponent are converted only when it can be
+// done exactly with a single floating-point multiplication or division (up to
+// 2^53 without the trailing zeros and a power of 10 up to 22), otherwise it is
+// a compile error too.
+
+#if __cplusplus >= 202002L
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "json/types.hpp"
+
+using namespace std;
+
+
+// Types {{{1
+
+enum class StaticJsonType { Object, Array, String, Int, UInt, Double, Bool, Null };
+
+struct StaticJsonNode {
+	StaticJsonType type = StaticJsonType::Null;
+	// Index of the node following this value (children are in between)
+	size_t end = 0;
+	// Number of elements for an object or an array
+	size_t size = 0;
+	// Key of an object entry (offset in the characters table)
+	size_t key_offset = 0;
+	size_t key_size = 0;
+	// String value (offset in the characters table)
+	size_t string_offset = 0;
+	size_t string_size = 0;
+	int64_t int_value = 0;
+	uint64_t uint_value = 0;
+	double double_value = 0;
+	bool bool_value = false;
+};
+
+// It is not “constexpr”, so reaching it during constant evaluation makes a
+// compile error (the diagnostic points at the call with the message)
+inline void static_json_error(const char *message)
+{
+	throw message;
+}
+
+// Read-only view of a value of a parsed document
+struct StaticJsonValue {
+	const StaticJsonNode *nodes;
+	const char *chars;
+	size_t index;
+
+	constexpr const StaticJsonNode& node() const { return nodes[index]; }
+	constexpr StaticJsonType type() const { return node().type; }
+
+	constexpr string_view key() const
+	{
+		return string_view(chars + node().key_offset, node().key_size);
+	}
+
+	constexpr string_view as_string() const
+	{
+		if (type() != StaticJsonType::String)
+			static_json_error("StaticJsonValue: it’s not a string");
+		return string_view(chars + node().string_offset, node().string_size);
+	}
+
+	constexpr int64_t as_int() const
+	{
+		if (type() != StaticJsonType::Int)
+			static_json_error("StaticJsonValue: it’s not an integer number");
+		return node().int_value;
+	}
+
+	// Only for the integer numbers which do not fit into “as_int()”
+	constexpr uint64_t as_uint() const
+	{
+		if (type() != StaticJsonType::UInt)
+			static_json_error("StaticJsonValue: it’s not a big integer number");
+		return node().uint_value;
+	}
+
+	constexpr double as_double() const
+	{
+		if (type() == StaticJsonType::Int) return node().int_value;
+		if (type() == StaticJsonType::UInt) return node().uint_value;
+		if (type() != StaticJsonType::Double)
+			static_json_error("StaticJsonValue: it’s not a number");
+		return node().double_value;
+	}
+
+	constexpr bool as_bool() const
+	{
+		if (type() != StaticJsonType::Bool)
+			static_json_error("StaticJsonValue: it’s not a boolean");
+		return node().bool_value;
+	}
+
+	constexpr bool is_null() const { return type() == StaticJsonType::Null; }
+
+	// Number of elements of an array or an object
+	constexpr size_t size() const { return node().size; }
+
+	// Element of an array or an object (an entry, see “key”) by its position
+	constexpr StaticJsonValue operator[](size_t i) const
+	{
+		if (type() != StaticJsonType::Array && type() != StaticJsonType::Object)
+			static_json_error("StaticJsonValue: it’s not a container");
+		if (i >= size())
+			static_json_error("StaticJsonValue: index is out of bounds");
+
+		size_t child = index + 1;
+		for (; i > 0; --i) child = nodes[child].end;
+		return StaticJsonValue{nodes, chars, child};
+	}
+
+	constexpr bool contains(string_view k) const
+	{
+		if (type() != StaticJsonType::Object) return false;
+		for (size_t i = 0, child = index + 1; i < size(); ++i) {
+			if (StaticJsonValue{nodes, chars, child}.key() == k) return true;
+			child = nodes[child].end;
+		}
+		return false;
+	}
+
+	// Value of an object by its key (the first one if the key is duplicated)
+	constexpr StaticJsonValue operator[](string_view k) const
+	{
+		if (type() != StaticJsonType::Object)
+			static_json_error("StaticJsonValue: it’s not an object");
+		for (size_t i = 0, child = index + 1; i < size(); ++i) {
+			StaticJsonValue entry {nodes, chars, child};
+			if (entry.key() == k) return entry;
+			child = nodes[child].end;
+		}
+		static_json_error("StaticJsonValue: key is not found");
+		return *this;
+	}
+};
+
+template <size_t NodesCount, size_t CharsCount>
+struct StaticJson {
+	array<StaticJsonNode, NodesCount> nodes {};
+	array<char, CharsCount> chars {};
+
+	constexpr StaticJsonValue root() const
+	{
+		return StaticJsonValue{nodes.data(), chars.data(), 0};
+	}
+};
+
+// JSON literal as a template argument
+template <size_t N>
+struct JsonLiteral {
+	char chars[N] {};
+
+	constexpr JsonLiteral(const char (&s)[N])
+	{
+		for (size_t i = 0; i < N; ++i) chars[i] = s[i];
+	}
+
+	constexpr string_view view() const { return string_view(chars, N - 1); }
+};
+
+// }}}1
+
+
+// Parser {{{1
+
+// The same parser is run twice. First time only to count the nodes and the
+// characters (so that the tables can be allocated statically) and then to fill
+// the tables.
+struct StaticJsonParser {
+	string_view input;
+	// Both are “nullptr” when only counting
+	StaticJsonNode *nodes = nullptr;
+	char *chars = nullptr;
+
+	size_t pos = 0;
+	size_t nodes_count = 0;
+	size_t chars_count = 0;
+
+	static constexpr bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+	constexpr void skip_spacer()
+	{
+		while (
+			pos < input.size() && (
+				input[pos] == ' ' ||
+				input[pos] == '\t' ||
+				input[pos] == '\n' ||
+				input[pos] == '\r'
+			)
+		) ++pos;
+	}
+
+	constexpr size_t add_node(StaticJsonType type)
+	{
+		if (nodes) {
+			nodes[nodes_count].type = type;
+			nodes[nodes_count].end = nodes_count + 1;
+		}
+		return nodes_count++;
+	}
+
+	constexpr void add_char(char c)
+	{
+		if (chars) chars[chars_count] = c;
+		++chars_count;
+	}
+
+	constexpr void parse_literal(string_view literal)
+	{
+		if (input.substr(pos, literal.size()) != literal)
+			static_json_error("JsonValue: unexpected literal");
+		pos += literal.size();
+	}
+
+	constexpr unsigned parse_hex4()
+	{
+		if (pos + 4 > input.size())
+			static_json_error("JsonString: “\\u” must be followed by 4 hex digits");
+		unsigned x = 0;
+		for (const size_t end = pos + 4; pos < end; ++pos) {
+			const char c = input[pos];
+			if (is_digit(c)) x = x * 16 + (c - '0');
+			else if (c >= 'a' && c <= 'f') x = x * 16 + (c - 'a' + 10);
+			else if (c >= 'A' && c <= 'F') x = x * 16 + (c - 'A' + 10);
+			else static_json_error(
+				"JsonString: “\\u” must be followed by 4 hex digits"
+			);
+		}
+		return x;
+	}
+
+	constexpr void add_utf8(unsigned code_point)
+	{
+		if (code_point < 0x80) {
+			add_char(char(code_point));
+		} else if (code_point < 0x800) {
+			add_char(char(0xC0 | (code_point >> 6)));
+			add_char(char(0x80 | (code_point & 0x3F)));
+		} else if (code_point < 0x10000) {
+			add_char(char(0xE0 | (code_point >> 12)));
+			add_char(char(0x80 | ((code_point >> 6) & 0x3F)));
+			add_char(char(0x80 | (code_point & 0x3F)));
+		} else {
+			add_char(char(0xF0 | (code_point >> 18)));
+			add_char(char(0x80 | ((code_point >> 12) & 0x3F)));
+			add_char(char(0x80 | ((code_point >> 6) & 0x3F)));
+			add_char(char(0x80 | (code_point & 0x3F)));
+		}
+	}
+
+	// Mirrors “json_string()” (escapes are decoded, “\u” ones into UTF-8)
+	constexpr void parse_string(size_t &offset, size_t &size)
+	{
+		++pos; // Skipping opening quote
+		offset = chars_count;
+
+		while (pos < input.size() && input[pos] != '"') {
+			const char c = input[pos];
+
+			if (static_cast<unsigned char>(c) <= 0x1F)
+				static_json_error("JsonString: control characters must be escaped");
+
+			if (c != '\\') {
+				add_char(c);
+				++pos;
+				continue;
+			}
+
+			if (pos + 1 >= input.size()) break;
+			const char escaped = input[pos + 1];
+			pos += 2;
+
+			switch (escaped) {
+				case '"': add_char('"'); break;
+				case '\\': add_char('\\'); break;
+				case '/': add_char('/'); break;
+				case 'b': add_char('\b'); break;
+				case 'f': add_char('\f'); break;
+				case 'n': add_char('\n'); break;
+				case 'r': add_char('\r'); break;
+				case 't': add_char('\t'); break;
+				case 'u': {
+					unsigned code_point = parse_hex4();
+
+					if (code_point >= 0xDC00 && code_point <= 0xDFFF)
+						static_json_error("JsonString: unpaired UTF-16 low surrogate");
+
+					if (code_point >= 0xD800 && code_point <= 0xDBFF) {
+						if (input.substr(pos, 2) != "\\u")
+							static_json_error(
+								"JsonString: unpaired UTF-16 high surrogate"
+							);
+						pos += 2;
+						const unsigned low = parse_hex4();
+						if (low < 0xDC00 || low > 0xDFFF)
+							static_json_error(
+								"JsonString: unpaired UTF-16 high surrogate"
+							);
+						code_point =
+							0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+					}
+
+					add_utf8(code_point);
+					break;
+				}
+				default:
+					static_json_error("JsonString: unknown escape sequence");
+			}
+		}
+
+		if (pos >= input.size())
+			static_json_error("JsonString: closing quote is expected");
+
+		++pos; // Skipping closing quote
+		size = chars_count - offset;
+	}
+
+	constexpr void parse_number()
+	{
+		const bool negative = input[pos] == '-';
+		if (negative) ++pos;
+
+		const size_t int_start = pos;
+		while (pos < input.size() && is_digit(input[pos])) ++pos;
+		const size_t int_end = pos;
+
+		if (int_end == int_start)
+			static_json_error("JsonNumber: digits are expected");
+		if (input[int_start] == '0' && int_end - int_start > 1)
+			static_json_error("JsonNumber: leading zeros are not allowed");
+
+		size_t fraction_start = int_end, fraction_end = int_end;
+		if (
+			pos + 1 < input.size() &&
+			input[pos] == '.' &&
+			is_digit(input[pos + 1])
+		) {
+			fraction_start = ++pos;
+			while (pos < input.size() && is_digit(input[pos])) ++pos;
+			fraction_end = pos;
+		}
+
+		int64_t exponent = 0;
+		bool has_exponent = false;
+		if (pos < input.size() && (input[pos] == 'e' || input[pos] == 'E')) {
+			size_t i = pos + 1;
+			const bool negative_exponent = i < input.size() && input[i] == '-';
+			if (i < input.size() && (input[i] == '-' || input[i] == '+')) ++i;
+			if (i < input.size() && is_digit(input[i])) {
+				has_exponent = true;
+				for (; i < input.size() && is_digit(input[i]); ++i)
+					if (exponent < 100000) exponent = exponent * 10 + (input[i] - '0');
+				if (negative_exponent) exponent = -exponent;
+				pos = i;
+			}
+		}
+
+		// Integer number (“int64_t” or “uint64_t”, like “scan_json_number”)
+		if (fraction_end == int_end && !has_exponent) {
+			uint64_t x = 0;
+			bool fits = true;
+			for (size_t i = int_start; i < int_end && fits; ++i) {
+				const uint64_t digit = input[i] - '0';
+				fits = x <= (UINT64_MAX - digit) / 10;
+				if (fits) x = x * 10 + digit;
+			}
+
+			const uint64_t int64_max = INT64_MAX;
+			if (fits && !negative) {
+				const size_t i = add_node(
+					x <= int64_max ? StaticJsonType::Int : StaticJsonType::UInt
+				);
+				if (nodes && x <= int64_max) nodes[i].int_value = (int64_t) x;
+				else if (nodes) nodes[i].uint_value = x;
+				return;
+			} else if (fits && x <= int64_max + 1) {
+				const size_t i = add_node(StaticJsonType::Int);
+				if (nodes)
+					nodes[i].int_value =
+						x == int64_max + 1 ? INT64_MIN : -(int64_t) x;
+				return;
+			}
+			// Otherwise it is converted to “double”
+		}
+
+		// All the digits as one integer “mantissa × 10^exponent”
+		uint64_t mantissa = 0;
+		size_t significant_digits = 0;
+		for (size_t i = int_start; i < fraction_end; ++i) {
+			if (i == int_end) continue; // Skipping the dot
+			if (mantissa > 0 || input[i] != '0') ++significant_digits;
+			if (significant_digits > 19)
+				static_json_error(
+					"JsonNumber: too many significant digits to convert "
+					"exactly at compile-time"
+				);
+			mantissa = mantissa * 10 + (input[i] - '0');
+		}
+		exponent -= (int64_t) (fraction_end - fraction_start);
+
+		// Trailing zeros do not change the value
+		while (mantissa > 0 && mantissa % 10 == 0) {
+			mantissa /= 10;
+			++exponent;
+		}
+		if (mantissa == 0) exponent = 0;
+
+		if (
+			mantissa > (uint64_t(1) << 53) ||
+			exponent < -22 ||
+			exponent > 22
+		)
+			static_json_error(
+				"JsonNumber: the number can not be converted exactly "
+				"at compile-time"
+			);
+
+		// Both numbers are exact so the operation is correctly rounded
+		double power = 1;
+		for (int64_t i = 0; i < (exponent < 0 ? -exponent : exponent); ++i)
+			power *= 10;
+		const double x = exponent < 0
+			? static_cast<double>(mantissa) / power
+			: static_cast<double>(mantissa) * power;
+
+		const size_t i = add_node(StaticJsonType::Double);
+		if (nodes) nodes[i].double_value = negative ? -x : x;
+	}
+
+	constexpr void parse_value()
+	{
+		skip_spacer();
+		if (pos >= input.size()) static_json_error("JsonValue: input is empty");
+
+		const char c = input[pos];
+		if (c == 'n') {
+			parse_literal("null");
+			add_node(StaticJsonType::Null);
+		} else if (c == 't' || c == 'f') {
+			parse_literal(c == 't' ? "true" : "false");
+			const size_t i = add_node(StaticJsonType::Bool);
+			if (nodes) nodes[i].bool_value = c == 't';
+		} else if (c == '"') {
+			size_t offset = 0, size = 0;
+			parse_string(offset, size);
+			const size_t i = add_node(StaticJsonType::String);
+			if (nodes) {
+				nodes[i].string_offset = offset;
+				nodes[i].string_size = size;
+			}
+		} else if (c == '[' || c == '{') {
+			parse_container(c == '{');
+		} else if (c == '-' || is_digit(c)) {
+			parse_number();
+		} else {
+			static_json_error("JsonValue: unexpected character");
+		}
+
+		skip_spacer();
+	}
+
+	constexpr void parse_container(bool is_object)
+	{
+		const char closing = is_object ? '}' : ']';
+		const size_t i = add_node(
+			is_object ? StaticJsonType::Object : StaticJsonType::Array
+		);
+		size_t size = 0;
+
+		++pos; // Skipping opening bracket
+		skip_spacer();
+
+		if (pos < input.size() && input[pos] != closing) {
+			for (;;) {
+				size_t key_offset = 0, key_size = 0;
+
+				if (is_object) {
+					skip_spacer();
+					if (pos >= input.size() || input[pos] != '"')
+						static_json_error("JsonObject: key is expected");
+					parse_string(key_offset, key_size);
+					skip_spacer();
+					if (pos >= input.size() || input[pos] != ':')
+						static_json_error("JsonObject: “:” is expected");
+					++pos;
+				}
+
+				const size_t child = nodes_count;
+				parse_value();
+				++size;
+
+				if (nodes) {
+					nodes[child].key_offset = key_offset;
+					nodes[child].key_size = key_size;
+				}
+
+				skip_spacer();
+				if (pos < input.size() && input[pos] == ',') ++pos; else break;
+			}
+		}
+
+		skip_spacer();
+		if (pos >= input.size() || input[pos] != closing)
+			static_json_error(
+				is_object
+					? "JsonObject: “}” is expected"
+					: "JsonArray: “]” is expected"
+			);
+		++pos;
+
+		if (nodes) {
+			nodes[i].size = size;
+			nodes[i].end = nodes_count;
+		}
+	}
+
+	constexpr void parse_document()
+	{
+		parse_value();
+		if (pos != input.size())
+			static_json_error("end_of_input: input is not empty");
+	}
+};
+
+template <JsonLiteral literal>
+constexpr auto static_json()
+{
+	constexpr StaticJsonParser counted = [] {
+		StaticJsonParser parser {literal.view()};
+		parser.parse_document();
+		return parser;
+	}();
+
+	StaticJson<counted.nodes_count, counted.chars_count> result;
+	StaticJsonParser parser {literal.view(), result.nodes.data()};
+	if constexpr (counted.chars_count > 0) parser.chars = result.chars.data();
+	parser.parse_document();
+	return result;
+}
+
+// }}}1
+
+
+// Conversion to “JsonValue” {{{1
+
+inline JsonValue to_json_value(StaticJsonValue x)
+{
+	switch (x.type()) {
+		case StaticJsonType::Object: {
+			JsonMembers entries;
+			entries.reserve(x.size());
+			for (size_t i = 0; i < x.size(); ++i) {
+				StaticJsonValue entry = x[i];
+				// First key wins, like in “make_map_from_vector”
+				entries.emplace(string(entry.key()), to_json_value(entry));
+			}
+			return make_json_value(make_json_object(move(entries)));
+		}
+		case StaticJsonType::Array: {
+			vector<JsonValue> list;
+			list.reserve(x.size());
+			for (size_t i = 0; i < x.size(); ++i)
+				list.push_back(to_json_value(x[i]));
+			return make_json_value(make_json_array(move(list)));
+		}
+		case StaticJsonType::String:
+			return make_json_value(make_json_string(string(x.as_string())));
+		case StaticJsonType::Int:
+			return make_json_value(make_json_number<int64_t>(x.as_int()));
+		case StaticJsonType::UInt:
+			return make_json_value(make_json_number<uint64_t>(x.as_uint()));
+		case StaticJsonType::Double:
+			return make_json_value(make_json_number<double>(x.as_double()));
+		case StaticJsonType::Bool:
+			return make_json_value(make_json_bool(x.as_bool()));
+		default:
+			return make_json_value(JsonNull{unit()});
+	}
+}
+
+// }}}1
+
+#endif
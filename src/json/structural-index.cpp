@@ -0,0 +1,525 @@
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "json/sax.hpp"
+#include "json/scanners.hpp"
+#include "json/structural-index.hpp"
+#include "json/types.hpp"
+#include "parser/types.hpp"
+
+using namespace std;
+
+// Local shorthand
+using I = ParserInputType<Parser>;
+
+
+// Stage 1 {{{1
+
+// The input is processed in blocks of 64 bytes, one bit per byte
+constexpr size_t block_size = 64;
+
+struct BlockMasks
+{
+	uint64_t backslash = 0;
+	uint64_t quote = 0;
+	uint64_t spacer = 0;
+	uint64_t op = 0; // “{}[]:,”
+};
+
+// Classification of a part of a block starting at “offset” bit.
+// Mind that “c | 0x20” turns “[” into “{” and “]” into “}”.
+#if defined(__AVX2__)
+constexpr size_t chunk_size = 32;
+
+inline void classify_chunk(const char *p, size_t offset, BlockMasks &masks)
+{
+	const __m256i c = _mm256_loadu_si256((const __m256i*) p);
+	const __m256i lower = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+	const auto eq = [](__m256i x, char y) {
+		return _mm256_cmpeq_epi8(x, _mm256_set1_epi8(y));
+	};
+	const auto bits = [offset](__m256i x) {
+		return uint64_t(uint32_t(_mm256_movemask_epi8(x))) << offset;
+	};
+
+	masks.backslash |= bits(eq(c, '\\'));
+	masks.quote |= bits(eq(c, '"'));
+	masks.spacer |= bits(_mm256_or_si256(
+		_mm256_or_si256(eq(c, ' '), eq(c, '\t')),
+		_mm256_or_si256(eq(c, '\n'), eq(c, '\r'))
+	));
+	masks.op |= bits(_mm256_or_si256(
+		_mm256_or_si256(eq(lower, '{'), eq(lower, '}')),
+		_mm256_or_si256(eq(c, ':'), eq(c, ','))
+	));
+}
+#elif defined(__SSE2__)
+constexpr size_t chunk_size = 16;
+
+inline void classify_chunk(const char *p, size_t offset, BlockMasks &masks)
+{
+	const __m128i c = _mm_loadu_si128((const __m128i*) p);
+	const __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+	const auto eq = [](__m128i x, char y) {
+		return _mm_cmpeq_epi8(x, _mm_set1_epi8(y));
+	};
+	const auto bits = [offset](__m128i x) {
+		return uint64_t(uint16_t(_mm_movemask_epi8(x))) << offset;
+	};
+
+	masks.backslash |= bits(eq(c, '\\'));
+	masks.quote |= bits(eq(c, '"'));
+	masks.spacer |= bits(_mm_or_si128(
+		_mm_or_si128(eq(c, ' '), eq(c, '\t')),
+		_mm_or_si128(eq(c, '\n'), eq(c, '\r'))
+	));
+	masks.op |= bits(_mm_or_si128(
+		_mm_or_si128(eq(lower, '{'), eq(lower, '}')),
+		_mm_or_si128(eq(c, ':'), eq(c, ','))
+	));
+}
+#else
+constexpr size_t chunk_size = 8;
+
+inline void classify_chunk(const char *p, size_t offset, BlockMasks &masks)
+{
+	for (size_t i = 0; i < chunk_size; ++i) {
+		const uint64_t bit = uint64_t(1) << (offset + i);
+		const char lower = p[i] | 0x20;
+		if (p[i] == '\\') masks.backslash |= bit;
+		if (p[i] == '"') masks.quote |= bit;
+		if (is_json_spacer(p[i])) masks.spacer |= bit;
+		if (lower == '{' || lower == '}' || p[i] == ':' || p[i] == ',')
+			masks.op |= bit;
+	}
+}
+#endif
+
+inline BlockMasks classify_block(const char *p)
+{
+	BlockMasks masks;
+	for (size_t offset = 0; offset < block_size; offset += chunk_size)
+		classify_chunk(p + offset, offset, masks);
+	return masks;
+}
+
+// Every bit becomes XOR of itself and all the lower bits, so the bits between
+// an opening quote (inclusive) and a closing quote (exclusive) are set
+inline uint64_t prefix_xor(uint64_t x)
+{
+	x ^= x << 1;
+	x ^= x << 2;
+	x ^= x << 4;
+	x ^= x << 8;
+	x ^= x << 16;
+	x ^= x << 32;
+	return x;
+}
+
+// Classify the block starting at “base” (the last block of the part is padded
+// with whitespace)
+inline BlockMasks classify_block(string_view input, size_t base, size_t end)
+{
+	if (end - base >= block_size) return classify_block(input.data() + base);
+
+	char padded[block_size];
+	memset(padded, ' ', block_size);
+	memcpy(padded, input.data() + base, end - base);
+	return classify_block(padded);
+}
+
+// Characters escaped by a backslash, those are the ones that follow an odd
+// sequence of backslashes. Every sequence starting at an even bit gets an odd
+// end bit when it is odd (and vice versa), so the trick is to find the ends
+// of the sequences by adding the starts to the sequences.
+// “prev_escaped” tells whether the first character of the block is escaped
+// (it is updated for the next block).
+inline uint64_t escaped_chars(uint64_t backslash, uint64_t &prev_escaped)
+{
+	const uint64_t even_bits = 0x5555555555555555;
+
+	backslash &= ~prev_escaped;
+	const uint64_t follows_escape = (backslash << 1) | prev_escaped;
+	const uint64_t odd_sequence_starts =
+		backslash & ~even_bits & ~follows_escape;
+
+	uint64_t sequences_starting_on_even_bits;
+	prev_escaped = __builtin_add_overflow(
+		odd_sequence_starts,
+		backslash,
+		&sequences_starting_on_even_bits
+	);
+
+	const uint64_t invert_mask = sequences_starting_on_even_bits << 1;
+	return (even_bits ^ invert_mask) & follows_escape;
+}
+
+// Quotes that open or close a string
+inline uint64_t unescaped_quotes(const BlockMasks &masks, uint64_t &prev_escaped)
+{
+	return masks.quote & ~escaped_chars(masks.backslash, prev_escaped);
+}
+
+// Whether the character at “pos” follows an odd sequence of backslashes
+inline bool is_escaped(string_view input, size_t pos)
+{
+	size_t backslashes = 0;
+	while (pos > backslashes && input[pos - backslashes - 1] == '\\')
+		++backslashes;
+	return backslashes % 2 == 1;
+}
+
+void structural_index(
+	string_view input,
+	size_t begin,
+	size_t end,
+	StructuralState &state,
+	vector<size_t> &index
+)
+{
+	for (size_t base = begin; base < end; base += block_size) {
+		const BlockMasks masks = classify_block(input, base, end);
+
+		const uint64_t quote = unescaped_quotes(masks, state.prev_escaped);
+
+		const uint64_t in_string = prefix_xor(quote) ^ state.prev_in_string;
+		state.prev_in_string = uint64_t(int64_t(in_string) >> 63);
+
+		// Anything else outside of the strings is a part of a number or
+		// a literal, only the first character of those gets into the index
+		const uint64_t scalar =
+			~(masks.op | masks.spacer | quote) & ~in_string;
+		const uint64_t scalar_start =
+			scalar & ~((scalar << 1) | state.prev_scalar);
+		state.prev_scalar = scalar >> 63;
+
+		uint64_t bits = (masks.op & ~in_string) | quote | scalar_start;
+		for (; bits != 0; bits &= bits - 1)
+			index.push_back(base + __builtin_ctzll(bits));
+	}
+}
+
+vector<size_t> structural_index(string_view input)
+{
+	vector<size_t> index;
+	index.reserve(input.size() / 8 + 1);
+	StructuralState state;
+	structural_index(input, 0, input.size(), state, index);
+	return index;
+}
+
+bool unescaped_quotes_parity(string_view input, size_t begin, size_t end)
+{
+	uint64_t prev_escaped = is_escaped(input, begin) ? 1 : 0;
+	uint64_t parity = 0;
+
+	for (size_t base = begin; base < end; base += block_size) {
+		const BlockMasks masks = classify_block(input, base, end);
+		parity ^= __builtin_popcountll(unescaped_quotes(masks, prev_escaped));
+	}
+
+	return parity & 1;
+}
+
+StructuralState structural_state_at(string_view input, size_t pos, bool in_string)
+{
+	StructuralState state;
+	if (pos == 0) return state;
+
+	const char c = input[pos - 1];
+	const bool quote = c == '"' && !is_escaped(input, pos - 1);
+	const char lower = c | 0x20;
+
+	state.prev_escaped = is_escaped(input, pos) ? 1 : 0;
+	state.prev_in_string = in_string ? ~uint64_t(0) : 0;
+	state.prev_scalar =
+		!in_string && !quote && !is_json_spacer(c) &&
+		c != ':' && c != ',' && lower != '{' && lower != '}'
+		? 1 : 0;
+	return state;
+}
+
+// }}}1
+
+
+// Stage 2 {{{1
+
+struct IndexedParser
+{
+	I input;
+	const vector<size_t> &index;
+	size_t i; // Current position in the index
+	size_t end; // Only a part of the index before “end” is parsed
+	JsonParsingOptions options;
+	// Levels of the arrays and objects around the current position (the
+	// parsing recurses for every level, see “recursive_json_max_depth”)
+	size_t depth = 0;
+	const char *failure = "";
+	size_t failure_pos = 0;
+
+	bool fail(const char *message, size_t pos)
+	{
+		failure = message;
+		failure_pos = pos;
+		return false;
+	}
+
+	bool fail(const char *message)
+	{
+		return fail(message, i < index.size() ? index[i] : input.size());
+	}
+
+	ParsingError<I> error() const
+	{
+		return make_parsing_error<I>(failure, input.substr(failure_pos));
+	}
+
+	// Whether current structural character is “c”
+	bool at(char c) const
+	{
+		return i < end && input[index[i]] == c;
+	}
+
+	// A number or a literal must not be followed by anything else but
+	// whitespace, a structural character or a quote
+	bool is_scalar_end(size_t pos) const
+	{
+		if (pos >= input.size()) return true;
+		const char c = input[pos];
+		const char lower = c | 0x20;
+		return
+			is_json_spacer(c) || c == '"' || c == ':' || c == ',' ||
+			lower == '{' || lower == '}';
+	}
+
+	bool parse_scalar(JsonValue &out)
+	{
+		size_t pos = index[i];
+
+		const auto literal = [this, &pos](const char *x) {
+			if (input.compare(pos, char_traits<char>::length(x), x) != 0)
+				return false;
+			pos += char_traits<char>::length(x);
+			return true;
+		};
+
+		if (literal("null")) {
+			out = JsonValue{JsonNull{unit()}};
+		} else if (literal("true")) {
+			out = JsonValue{make_json_bool(true)};
+		} else if (literal("false")) {
+			out = JsonValue{make_json_bool(false)};
+		} else if (is_json_number_start(input[pos])) {
+			JsonNumber x;
+			const char *err = scan_json_number(
+				input,
+				pos,
+				x,
+				options.lazy_numbers,
+				options.shared_input
+			);
+			if (err != nullptr) return fail(err, pos);
+			out = JsonValue{move(x)};
+		} else {
+			return fail("JsonValue: unexpected character");
+		}
+
+		if (!is_scalar_end(pos))
+			return fail("JsonValue: unexpected character", pos);
+
+		++i;
+		return true;
+	}
+
+	// The closing quote is always the next one in the index
+	bool parse_string(string &out)
+	{
+		if (i + 1 >= end)
+			return fail("JsonString: closing quote is expected", input.size());
+
+		size_t pos = index[i];
+		const char *err = scan_json_string(input, pos, out);
+		if (err != nullptr) return fail(err, pos);
+
+		i += 2;
+		return true;
+	}
+
+	bool parse_string_value(JsonValue &out)
+	{
+		if (i + 1 >= end)
+			return fail("JsonString: closing quote is expected", input.size());
+
+		size_t pos = index[i];
+		JsonString x;
+		const char *err = scan_json_string_value(input, pos, options, string(), x);
+		if (err != nullptr) return fail(err, pos);
+
+		out = JsonValue{move(x)};
+		i += 2;
+		return true;
+	}
+
+	// Comma-separated values (at least one)
+	bool parse_elements(vector<JsonValue> &list)
+	{
+		for (;;) {
+			list.emplace_back();
+			if (!parse_value(list.back())) return false;
+			if (at(',')) ++i; else return true;
+		}
+	}
+
+	// Comma-separated “key: value” entries (at least one)
+	bool parse_entries(JsonMembers &entries)
+	{
+		for (;;) {
+			if (!at('"')) return fail("JsonObject: key is expected");
+
+			string key;
+			if (!parse_string(key)) return false;
+
+			if (!at(':')) return fail("JsonObject: “:” is expected");
+			++i;
+
+			JsonValue value;
+			if (!parse_value(value)) return false;
+
+			// First key wins, like in “make_map_from_vector”
+			entries.emplace(move(key), move(value));
+
+			if (at(',')) ++i; else return true;
+		}
+	}
+
+	bool parse_array(JsonValue &out)
+	{
+		++i; // Skipping “[”
+		vector<JsonValue> list;
+
+		if (!at(']') && !parse_elements(list)) return false;
+		if (!at(']')) return fail("JsonArray: “]” is expected");
+
+		++i;
+		out = JsonValue{make_json_array(move(list))};
+		return true;
+	}
+
+	bool parse_object(JsonValue &out)
+	{
+		++i; // Skipping “{”
+		JsonMembers entries;
+
+		if (!at('}') && !parse_entries(entries)) return false;
+		if (!at('}')) return fail("JsonObject: “}” is expected");
+
+		++i;
+		out = JsonValue{make_json_object(move(entries))};
+		return true;
+	}
+
+	// The values nested too deep for the recursion are built on the heap
+	// (the index entries inside them are skipped)
+	bool parse_deep(JsonValue &out)
+	{
+		JsonParsingOptions deeper = options;
+		if (deeper.max_depth != SIZE_MAX) deeper.max_depth -= depth;
+
+		size_t pos = index[i];
+		const char *err = parse_json_value_at(input, pos, out, deeper);
+		if (err != nullptr) return fail(err, pos);
+		while (i < end && index[i] < pos) ++i;
+		return true;
+	}
+
+	bool parse_nested(JsonValue &out, bool is_object)
+	{
+		if (depth >= options.max_depth) return fail(json_too_deep_failure);
+		if (depth >= recursive_json_max_depth) return parse_deep(out);
+
+		++depth;
+		const bool ok = is_object ? parse_object(out) : parse_array(out);
+		--depth;
+		return ok;
+	}
+
+	bool parse_value(JsonValue &out)
+	{
+		if (i >= end) return fail("JsonValue: value is expected");
+
+		switch (input[index[i]]) {
+			case '"':
+				return parse_string_value(out);
+			case '[':
+				return parse_nested(out, false);
+			case '{':
+				return parse_nested(out, true);
+			default:
+				return parse_scalar(out);
+		}
+	}
+};
+
+// }}}1
+
+
+variant<ParsingError<I>, JsonValue> parse_json_structural(
+	I input,
+	JsonParsingOptions options
+)
+{
+	const vector<size_t> index = structural_index(input);
+	IndexedParser parser {input, index, 0, index.size(), options};
+	JsonValue result;
+
+	bool ok = parser.parse_value(result);
+	if (ok && parser.i < index.size())
+		ok = parser.fail("end_of_input: input is not empty");
+
+	if (ok) return result; else return parser.error();
+}
+
+variant<ParsingError<I>, vector<JsonValue>> parse_indexed_elements(
+	I input,
+	const vector<size_t> &index,
+	size_t begin,
+	size_t end,
+	JsonParsingOptions options
+)
+{
+	// The elements of the top-level array
+	IndexedParser parser {input, index, begin, end, options, 1};
+	vector<JsonValue> list;
+
+	bool ok = parser.parse_elements(list);
+	if (ok && parser.i < end) ok = parser.fail("JsonArray: “]” is expected");
+
+	if (ok) return list; else return parser.error();
+}
+
+variant<ParsingError<I>, JsonMembers> parse_indexed_entries(
+	I input,
+	const vector<size_t> &index,
+	size_t begin,
+	size_t end,
+	JsonParsingOptions options
+)
+{
+	// The entries of the top-level object
+	IndexedParser parser {input, index, begin, end, options, 1};
+	JsonMembers entries;
+
+	bool ok = parser.parse_entries(entries);
+	if (ok && parser.i < end) ok = parser.fail("JsonObject: “}” is expected");
+
+	if (ok) return entries; else return parser.error();
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+// JSON parsing engine built around a structural index (the approach of
+// “simdjson”).
+//
+// Stage 1 is a vectorized pass over the whole input which finds the positions
+// of all the structural characters (“{}[]:,”), of the quotes delimiting the
+// strings (escaped quotes are taken into account) and of the first characters
+// of all the other values (numbers and literals). The whitespace and the
+// contents of the strings never get into the index.
+//
+// Stage 2 builds “JsonValue” walking the index instead of probing the input
+// character by character.
+//
+// It accepts exactly the same grammar as “parse_json” from “json/parsers.hpp”
+// and gives the same values (only the error messages are different).
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "json/types.hpp"
+#include "parser/types.hpp"
+
+using namespace std;
+
+
+// Stage 1: positions of the structural characters in the input (in order)
+vector<size_t> structural_index(string_view input);
+
+// Both stages
+// (mind that the tail in a parsing error is a view into the input)
+variant<ParsingError<ParserInputType<Parser>>, JsonValue> parse_json_structural(
+	ParserInputType<Parser> input,
+	JsonParsingOptions options = {}
+);
+
+
+// Building blocks for running the stages on parts of the input in parallel
+// (see “json/parallel.hpp”) {{{1
+
+// Stage 1 state carried over from the previous part of the input
+// (as the lowest bit, “prev_in_string” has all the bits set when it is true)
+struct StructuralState
+{
+	uint64_t prev_escaped = 0;
+	uint64_t prev_scalar = 0;
+	uint64_t prev_in_string = 0;
+};
+
+// Stage 1 for “input[begin, end)” appending the positions to “index”.
+// Mind that “end - begin” must be a multiple of 64 unless “end” is the end of
+// the input.
+void structural_index(
+	string_view input,
+	size_t begin,
+	size_t end,
+	StructuralState &state,
+	vector<size_t> &index
+);
+
+// Whether “input[begin, end)” has an odd number of the quotes that open or
+// close a string (so that the string state is flipped at the end of it)
+bool unescaped_quotes_parity(string_view input, size_t begin, size_t end);
+
+// Stage 1 state at the given position knowing if it is inside a string
+StructuralState structural_state_at(string_view input, size_t pos, bool in_string);
+
+// Stage 2 for “index[begin, end)” which must be exactly comma-separated array
+// elements or object entries (without the brackets)
+variant<ParsingError<ParserInputType<Parser>>, vector<JsonValue>>
+parse_indexed_elements(
+	ParserInputType<Parser> input,
+	const vector<size_t> &index,
+	size_t begin,
+	size_t end,
+	JsonParsingOptions options = {}
+);
+variant<ParsingError<ParserInputType<Parser>>, JsonMembers>
+parse_indexed_entries(
+	ParserInputType<Parser> input,
+	const vector<size_t> &index,
+	size_t begin,
+	size_t end,
+	JsonParsingOptions options = {}
+);
+
+// }}}1
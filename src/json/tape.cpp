@@ -0,0 +1,405 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "json/ordered-map.hpp"
+#include "json/sax.hpp"
+#include "json/tape.hpp"
+#include "json/types.hpp"
+#include "parser/types.hpp"
+
+using namespace std;
+
+// Local shorthand
+using I = ParserInputType<Parser>;
+
+constexpr uint64_t payload_mask = (uint64_t(1) << 56) - 1;
+
+
+// Helpers {{{1
+
+inline uint64_t make_word(char kind, uint64_t payload)
+{
+	return uint64_t(uint8_t(kind)) << 56 | payload;
+}
+
+inline char word_kind(uint64_t x)
+{
+	return char(x >> 56);
+}
+
+inline uint64_t word_payload(uint64_t x)
+{
+	return x & payload_mask;
+}
+
+inline string_view tape_string(const JsonTape &tape, size_t index)
+{
+	return string_view(tape.strings).substr(
+		word_payload(tape.words[index]),
+		tape.words[index + 1]
+	);
+}
+
+template <typename T>
+inline T word_bits(uint64_t x)
+{
+	T y;
+	memcpy(&y, &x, sizeof(y));
+	return y;
+}
+
+template <typename T>
+inline uint64_t to_word_bits(T x)
+{
+	uint64_t y;
+	memcpy(&y, &x, sizeof(y));
+	return y;
+}
+
+// The events of a value (so that a tape is written by the same builder)
+inline void write_json_value(const JsonValue &x, JsonTapeBuilder &builder)
+{
+	visit(overloaded {
+		[&builder](const JsonObject &y) {
+			builder.on_object_begin();
+			for (auto &[ key, value ] : get<0>(y)) {
+				builder.on_key(key);
+				write_json_value(value, builder);
+			}
+			builder.on_object_end();
+		},
+		[&builder](const JsonArray &y) {
+			builder.on_array_begin();
+			for (auto &value : get<0>(y)) write_json_value(value, builder);
+			builder.on_array_end();
+		},
+		[&builder](const JsonString &y) {
+			builder.on_string(json_string_view(y));
+		},
+		[&builder](const JsonNumber &y) { builder.on_number(JsonNumber{y}); },
+		[&builder](const JsonBool &y) { builder.on_bool(get<0>(y)); },
+		[&builder](const JsonNull &) { builder.on_null(); },
+	}, x);
+}
+
+// }}}1
+
+
+// Values {{{1
+
+JsonValueKind JsonTapeValue::kind() const
+{
+	if (tape == nullptr || index >= tape->words.size())
+		return JsonValueKind::None;
+
+	switch (word_kind(tape->words[index])) {
+		case '{': return JsonValueKind::Object;
+		case '[': return JsonValueKind::Array;
+		case '"': return JsonValueKind::String;
+		case 'l': case 'u': case 'd': case 'r': return JsonValueKind::Number;
+		case 't': case 'f': return JsonValueKind::Bool;
+		case 'n': return JsonValueKind::Null;
+		default: return JsonValueKind::None;
+	}
+}
+
+size_t JsonTapeValue::end() const
+{
+	const uint64_t x = tape->words[index];
+	switch (word_kind(x)) {
+		case '{': case '[': return word_payload(x);
+		case '}': case ']': case 't': case 'f': case 'n': return index + 1;
+		default: return index + 2;
+	}
+}
+
+JsonTapeValue JsonTape::root() const
+{
+	return JsonTapeValue{this, 0};
+}
+
+// }}}1
+
+
+// Builder {{{1
+
+JsonTapeBuilder::JsonTapeBuilder(size_t input_size)
+{
+	// About a word per token of a usual document
+	tape.words.reserve(input_size / 4);
+	tape.strings.reserve(input_size / 2);
+}
+
+void JsonTapeBuilder::add_string(char kind, string_view x)
+{
+	tape.words.push_back(make_word(kind, tape.strings.size()));
+	tape.words.push_back(x.size());
+	tape.strings += x;
+}
+
+void JsonTapeBuilder::add_close(char kind)
+{
+	const size_t begin = open.back();
+	open.pop_back();
+	tape.words.push_back(make_word(kind, begin));
+	tape.words[begin] |= tape.words.size();
+}
+
+bool JsonTapeBuilder::on_null()
+{
+	tape.words.push_back(make_word('n', 0));
+	return true;
+}
+
+bool JsonTapeBuilder::on_bool(bool x)
+{
+	tape.words.push_back(make_word(x ? 't' : 'f', 0));
+	return true;
+}
+
+bool JsonTapeBuilder::on_number(JsonNumber &&x)
+{
+	if (auto raw = get_if<RawJsonNumber>(&get<0>(x))) {
+		add_string('r', raw_json_number_view(*raw));
+		return true;
+	}
+
+	visit(overloaded {
+		[this](int64_t y) {
+			tape.words.push_back(make_word('l', 0));
+			tape.words.push_back(to_word_bits(y));
+		},
+		[this](uint64_t y) {
+			tape.words.push_back(make_word('u', 0));
+			tape.words.push_back(y);
+		},
+		[this](double y) {
+			tape.words.push_back(make_word('d', 0));
+			tape.words.push_back(to_word_bits(y));
+		},
+	}, get<JsonNumberValue>(get<0>(x)));
+	return true;
+}
+
+bool JsonTapeBuilder::on_string(string_view x)
+{
+	add_string('"', x);
+	return true;
+}
+
+bool JsonTapeBuilder::on_array_begin()
+{
+	open.push_back(tape.words.size());
+	tape.words.push_back(make_word('[', 0));
+	return true;
+}
+
+bool JsonTapeBuilder::on_array_end()
+{
+	add_close(']');
+	return true;
+}
+
+bool JsonTapeBuilder::on_object_begin()
+{
+	open.push_back(tape.words.size());
+	tape.words.push_back(make_word('{', 0));
+	return true;
+}
+
+bool JsonTapeBuilder::on_key(string_view x)
+{
+	add_string('"', x);
+	return true;
+}
+
+bool JsonTapeBuilder::on_object_end()
+{
+	add_close('}');
+	return true;
+}
+
+JsonTape JsonTapeBuilder::take_result()
+{
+	return move(tape);
+}
+
+// }}}1
+
+
+variant<ParsingError<I>, JsonTape> parse_json_tape(
+	I input,
+	JsonParsingOptions options
+)
+{
+	JsonTapeBuilder builder(input.size());
+	if (auto err = parse_json_events(input, builder, move(options)))
+		return *err;
+	return builder.take_result();
+}
+
+JsonTape make_json_tape(const JsonValue &x)
+{
+	JsonTapeBuilder builder;
+	write_json_value(x, builder);
+	return builder.take_result();
+}
+
+JsonValue to_json_value(const JsonTapeValue &x)
+{
+	const JsonTape &tape = *x.tape;
+	const size_t end = x.end();
+
+	// Unfinished arrays and objects, and the keys of the values being built
+	// (one per unfinished object)
+	vector<JsonValue> stack;
+	vector<string> keys;
+	JsonValue result;
+
+	for (size_t i = x.index; i < end;) {
+		const bool in_object =
+			!stack.empty() && holds_alternative<JsonObject>(stack.back());
+		// A key goes before every value of an object
+		if (in_object && word_kind(tape.words[i]) != '}') {
+			keys.emplace_back(tape_string(tape, i));
+			i += 2;
+		}
+
+		const uint64_t word = tape.words[i];
+		JsonValue value;
+		switch (word_kind(word)) {
+			case '{':
+				stack.push_back(JsonValue{JsonObject{}});
+				++i;
+				continue;
+			case '[':
+				stack.push_back(JsonValue{JsonArray{}});
+				++i;
+				continue;
+			case '}': case ']':
+				value = move(stack.back());
+				stack.pop_back();
+				break;
+			case '"':
+				value = JsonValue{
+					make_json_string(string(tape_string(tape, i)))
+				};
+				break;
+			case 'r':
+				value = JsonValue{
+					make_raw_json_number(string(tape_string(tape, i)))
+				};
+				break;
+			case 'l':
+				value = JsonValue{
+					make_json_number(word_bits<int64_t>(tape.words[i + 1]))
+				};
+				break;
+			case 'u':
+				value = JsonValue{make_json_number(tape.words[i + 1])};
+				break;
+			case 'd':
+				value = JsonValue{
+					make_json_number(word_bits<double>(tape.words[i + 1]))
+				};
+				break;
+			case 't': case 'f':
+				value = JsonValue{make_json_bool(word_kind(word) == 't')};
+				break;
+			default:
+				value = JsonValue{JsonNull{unit()}};
+		}
+		i = JsonTapeValue{&tape, i}.end();
+
+		if (stack.empty()) {
+			result = move(value);
+		} else if (auto array = get_if<JsonArray>(&stack.back())) {
+			get<0>(*array).push_back(move(value));
+		} else {
+			// First key wins (like with the other engines)
+			get<0>(get<JsonObject>(stack.back())).emplace(
+				move(keys.back()),
+				move(value)
+			);
+			keys.pop_back();
+		}
+	}
+
+	return result;
+}
+
+
+// Unwrappers {{{1
+
+optional<OrderedMap<JsonTapeValue>> from_json_object(const JsonTapeValue &x)
+{
+	if (x.kind() != JsonValueKind::Object) return nullopt;
+
+	OrderedMap<JsonTapeValue> out;
+	const size_t end = x.end() - 1;
+	for (size_t i = x.index + 1; i < end;) {
+		const JsonTapeValue value{x.tape, i + 2};
+		out.try_emplace(tape_string(*x.tape, i), value);
+		i = value.end();
+	}
+	return out;
+}
+
+optional<vector<JsonTapeValue>> from_json_array(const JsonTapeValue &x)
+{
+	if (x.kind() != JsonValueKind::Array) return nullopt;
+
+	vector<JsonTapeValue> out;
+	const size_t end = x.end() - 1;
+	for (size_t i = x.index + 1; i < end; i = out.back().end())
+		out.push_back(JsonTapeValue{x.tape, i});
+	return out;
+}
+
+optional<string_view> from_json_string(const JsonTapeValue &x)
+{
+	if (x.kind() != JsonValueKind::String) return nullopt;
+	return tape_string(*x.tape, x.index);
+}
+
+optional<JsonNumberValue> from_json_number(const JsonTapeValue &x)
+{
+	if (x.kind() != JsonValueKind::Number) return nullopt;
+
+	const uint64_t *word = &x.tape->words[x.index];
+	switch (word_kind(word[0])) {
+		case 'l': return JsonNumberValue{word_bits<int64_t>(word[1])};
+		case 'u': return JsonNumberValue{word[1]};
+		case 'd': return JsonNumberValue{word_bits<double>(word[1])};
+		default:
+			return convert_raw_json_number(tape_string(*x.tape, x.index));
+	}
+}
+
+optional<bool> from_json_bool(const JsonTapeValue &x)
+{
+	if (x.kind() != JsonValueKind::Bool) return nullopt;
+	return word_kind(x.tape->words[x.index]) == 't';
+}
+
+optional<JsonTapeValue> in_key(string_view key, const JsonTapeValue &x)
+{
+	if (x.kind() != JsonValueKind::Object) return nullopt;
+
+	const size_t end = x.end() - 1;
+	for (size_t i = x.index + 1; i < end;) {
+		const JsonTapeValue value{x.tape, i + 2};
+		if (tape_string(*x.tape, i) == key) return value;
+		i = value.end();
+	}
+	return nullopt;
+}
+
+// }}}1
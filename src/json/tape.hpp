@@ -0,0 +1,123 @@
+#pragma once
+
+// Flat document: the whole document is a single contiguous “tape” of 64-bit
+// words in the order of the text, plus a single buffer with all the strings.
+// So a document is two allocations instead of one (or more) per value, a walk
+// over it goes through the memory forward, and destroying it is freeing two
+// buffers.
+//
+// A word is a kind in the highest byte and a payload in the lower 56 bits:
+//
+//   * “{”/“[” begins an object/an array, its payload is the index of the word
+//     right after the matching “}”/“]” (so the whole value is jumped over at
+//     once), and the payload of “}”/“]” is the index of its “{”/“[”. The
+//     members of an object are the key (a string) followed by the value.
+//
+//   * “"” is a string (or a key), its payload is the offset of it in the
+//     buffer of the strings and the next word is its length. “r” is a number
+//     kept as its source text (see “lazy_numbers” option) stored the same way.
+//
+//   * “l”, “u” and “d” are “int64_t”, “uint64_t” and “double” numbers, the
+//     next word is the number itself.
+//
+//   * “t”, “f” and “n” are “true”, “false” and “null”.
+//
+// The root value starts at the first word. The values are read with the same
+// unwrappers as “JsonValue” (see “json/types.hpp”), they give nothing when the
+// value is of another kind. The strings are views into the tape.
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "json/ordered-map.hpp"
+#include "json/sax.hpp"
+#include "json/types.hpp"
+#include "parser/types.hpp"
+
+using namespace std;
+
+
+struct JsonTape;
+
+// A value of a tape (valid as long as the tape is not changed)
+struct JsonTapeValue
+{
+	const JsonTape *tape = nullptr;
+	// The first word of the value
+	size_t index = 0;
+
+	JsonValueKind kind() const;
+	// The index of the word after the value
+	size_t end() const;
+};
+
+struct JsonTape
+{
+	vector<uint64_t> words;
+	string strings;
+
+	JsonTapeValue root() const;
+};
+
+// Writes the tape out of the events of a parser (see “parse_json_tape”)
+class JsonTapeBuilder final: public JsonHandler
+{
+public:
+	// The size of the input is only a hint for the size of the tape
+	explicit JsonTapeBuilder(size_t input_size = 0);
+
+	bool on_null() override;
+	bool on_bool(bool x) override;
+	bool on_number(JsonNumber &&x) override;
+	bool on_string(string_view x) override;
+	bool on_array_begin() override;
+	bool on_array_end() override;
+	bool on_object_begin() override;
+	bool on_key(string_view x) override;
+	bool on_object_end() override;
+
+	// The tape after the last event
+	JsonTape take_result();
+
+private:
+	JsonTape tape;
+	// The “{”/“[” words of the unfinished objects and arrays
+	vector<size_t> open;
+
+	void add_string(char kind, string_view x);
+	void add_close(char kind);
+};
+
+// Same grammar as the other engines, the nesting is kept on the heap (see
+// “parse_json_events” from “json/sax.hpp”). Only “lazy_numbers” and
+// “max_depth” options make a difference here.
+variant<ParsingError<ParserInputType<Parser>>, JsonTape> parse_json_tape(
+	ParserInputType<Parser> input,
+	JsonParsingOptions options = {}
+);
+
+// Conversions to and from “JsonValue”. A tape keeps all the keys of an object
+// (in the order they were given), the first of the same keys wins in
+// “JsonValue”.
+JsonTape make_json_tape(const JsonValue &x);
+JsonValue to_json_value(const JsonTapeValue &x);
+
+// Unwrappers {{{1
+
+// In the order of the keys (like “JsonValue”), the first of the same keys wins
+optional<OrderedMap<JsonTapeValue>> from_json_object(const JsonTapeValue &x);
+optional<vector<JsonTapeValue>> from_json_array(const JsonTapeValue &x);
+optional<string_view> from_json_string(const JsonTapeValue &x);
+optional<JsonNumberValue> from_json_number(const JsonTapeValue &x);
+optional<bool> from_json_bool(const JsonTapeValue &x);
+
+// Value of a key of an object without building a map (the first of the same
+// keys wins)
+optional<JsonTapeValue> in_key(string_view key, const JsonTapeValue &x);
+
+// }}}1
@@ -0,0 +1,267 @@
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "json/scanners.hpp"
+#include "json/serialization.hpp"
+#include "json/transcoder.hpp"
+#include "json/types.hpp"
+
+using namespace std;
+
+
+JsonTranscoder::JsonTranscoder(
+	ostream &out,
+	string line_break,
+	string block_indent,
+	JsonParsingOptions options
+):
+	out(out),
+	line_break(move(line_break)),
+	block_indent(move(block_indent)),
+	options(move(options))
+{}
+
+// Helpers {{{1
+
+bool JsonTranscoder::fail(const char *message, size_t pos)
+{
+	failure = message;
+	failure_offset = offset + pos;
+	return false;
+}
+
+void JsonTranscoder::begin_item()
+{
+	// The value of a key goes right after “:”
+	if (frames.empty() || (frames.back().is_object && expect != Expect::Key))
+		return;
+
+	Frame &frame = frames.back();
+	if (!frame.empty) output += ',';
+	frame.empty = false;
+	output += line_break;
+	indent();
+}
+
+void JsonTranscoder::indent()
+{
+	// Nothing to repeat for the compact output (so the depth costs nothing)
+	if (block_indent.empty()) return;
+	if (block_indent.size() == 1) {
+		output.append(frames.size(), block_indent[0]);
+		return;
+	}
+	output.reserve(output.size() + frames.size() * block_indent.size());
+	for (size_t i = 0; i < frames.size(); ++i) output += block_indent;
+}
+
+void JsonTranscoder::flush(bool all)
+{
+	if (!all && output.size() < output_bound) return;
+	out.write(output.data(), output.size());
+	output.clear();
+}
+
+void JsonTranscoder::open(bool is_object)
+{
+	begin_item();
+	output += is_object ? '{' : '[';
+	frames.push_back(Frame{is_object, true});
+	expect = is_object ? Expect::Key : Expect::Value;
+}
+
+void JsonTranscoder::close()
+{
+	const Frame frame = frames.back();
+	frames.pop_back();
+	// Same as “serialize_json”: “{}” and “[]” when there is nothing inside
+	if (!frame.empty) {
+		output += line_break;
+		indent();
+	}
+	output += frame.is_object ? '}' : ']';
+	done_value();
+}
+
+void JsonTranscoder::done_value()
+{
+	expect = frames.empty() ? Expect::End : Expect::Comma;
+}
+
+bool JsonTranscoder::run(bool last)
+{
+	size_t pos = 0;
+	bool incomplete = false;
+
+	for (;;) {
+		// The output of a single piece is not kept whole
+		flush(false);
+		while (pos < input.size() && is_json_spacer(input[pos])) ++pos;
+		if (pos >= input.size()) break;
+		const char c = input[pos];
+
+		switch (expect) {
+			case Expect::End:
+				return fail("end_of_input: input is not empty", pos);
+			case Expect::Colon:
+				if (c != ':') return fail("JsonObject: “:” is expected", pos);
+				++pos;
+				output += ':';
+				if (!line_break.empty() || !block_indent.empty()) output += ' ';
+				expect = Expect::Value;
+				continue;
+			case Expect::Comma: {
+				const bool is_object = frames.back().is_object;
+				if (c == ',') {
+					++pos;
+					expect = is_object ? Expect::Key : Expect::Value;
+					continue;
+				}
+				if (c != (is_object ? '}' : ']'))
+					return fail(
+						is_object
+							? "JsonObject: “}” is expected"
+							: "JsonArray: “]” is expected",
+						pos
+					);
+				++pos;
+				close();
+				continue;
+			}
+			case Expect::Key:
+				if (c == '}' && frames.back().empty) {
+					++pos;
+					close();
+					continue;
+				}
+				if (c != '"') return fail("JsonObject: key is expected", pos);
+				break;
+			case Expect::Value:
+				if (
+					c == ']' && !frames.empty() &&
+					!frames.back().is_object && frames.back().empty
+				) {
+					++pos;
+					close();
+					continue;
+				}
+				if (c == '[' || c == '{') {
+					++pos;
+					open(c == '{');
+					continue;
+				}
+				if (
+					c != '"' && c != 't' && c != 'f' && c != 'n' &&
+					!is_json_number_start(c)
+				) return fail("JsonValue: unexpected character", pos);
+		}
+
+		// A string or a literal is transcoded only when all of it is here. Only
+		// the end of the input tells where a token at the end of a piece ends.
+		size_t end = pos;
+		if (skip_json_value(input, end) != nullptr || end >= input.size()) {
+			if (!last) {
+				incomplete = true;
+				break;
+			}
+		}
+
+		begin_item();
+		if (c == '"') {
+			string_view x;
+			if (const char *err = scan_json_string(input, pos, x, buffer))
+				return fail(err, pos);
+			serialize_json_string(x, output);
+			if (expect == Expect::Key) {
+				expect = Expect::Colon;
+				continue;
+			}
+		} else if (is_json_number_start(c)) {
+			JsonNumber x;
+			const char *err =
+				scan_json_number(input, pos, x, options.lazy_numbers);
+			if (err != nullptr) return fail(err, pos);
+			output += serialize_json(move(x));
+		} else {
+			const string_view literal =
+				c == 't' ? "true" : c == 'f' ? "false" : "null";
+			if (string_view(input).substr(pos, literal.size()) != literal)
+				return fail("JsonValue: unexpected literal", pos);
+			pos += literal.size();
+			output += literal;
+		}
+		done_value();
+	}
+
+	// Only the unfinished token is kept
+	input.erase(0, pos);
+	offset += pos;
+	// Scanning a short token again costs nothing
+	wait_for = incomplete && input.size() >= 4096 ? 2 * input.size() : 0;
+	return true;
+}
+
+// }}}1
+
+bool JsonTranscoder::feed(string_view chunk)
+{
+	if (failure != nullptr) return false;
+
+	input.append(chunk);
+	if (input.size() < wait_for) return true;
+
+	const bool ok = run(false);
+	flush(true);
+	return ok;
+}
+
+bool JsonTranscoder::finish()
+{
+	if (failure != nullptr) return false;
+
+	const bool ok = run(true);
+	flush(true);
+	if (!ok) return false;
+
+	// Everything is consumed, so the failure is at the end of the input
+	switch (expect) {
+		case Expect::End:
+			return true;
+		case Expect::Value:
+			return fail(
+				!frames.empty() && !frames.back().is_object && frames.back().empty
+					? "JsonArray: “]” is expected"
+					: "JsonValue: input is empty",
+				0
+			);
+		case Expect::Key:
+			return fail(
+				frames.back().empty
+					? "JsonObject: “}” is expected"
+					: "JsonObject: key is expected",
+				0
+			);
+		case Expect::Colon:
+			return fail("JsonObject: “:” is expected", 0);
+		case Expect::Comma:
+			return fail(
+				frames.back().is_object
+					? "JsonObject: “}” is expected"
+					: "JsonArray: “]” is expected",
+				0
+			);
+	}
+	return true;
+}
+
+const char* JsonTranscoder::error() const
+{
+	return failure;
+}
+
+size_t JsonTranscoder::error_offset() const
+{
+	return failure_offset;
+}
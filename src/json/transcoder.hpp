@@ -0,0 +1,98 @@
+#pragma once
+
+// Streaming transcoder: rewrites JSON text compact or indented without
+// building a document. The input comes in pieces of any size (a token can be
+// split between them), every complete token is written to the output right
+// away and only the unfinished one is kept. So the memory does not depend on
+// the size of the input, only on the nesting depth and on the longest token.
+//
+// The output is the same as “serialize_json” of the parsed document (see
+// “json/serialization.hpp”) with one exception: duplicate keys are all written
+// (instead of only the first one).
+//
+// Mind that when the input is malformed the output up to the failure is
+// already written.
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "json/types.hpp"
+
+using namespace std;
+
+
+class JsonTranscoder
+{
+public:
+	// Same formatting arguments as “serialize_json” (the compact output by
+	// default). Only “lazy_numbers” option makes a difference here (numbers
+	// are written exactly as they are in the input).
+	explicit JsonTranscoder(
+		ostream &out,
+		string line_break = "",
+		string block_indent = "",
+		JsonParsingOptions options = {}
+	);
+
+	// Next piece of the input. What could be transcoded is written to the
+	// output (not flushed). Returns “false” after a failure (see “error”).
+	bool feed(string_view chunk);
+	// End of the input (also checks that the root value is complete)
+	bool finish();
+
+	// The first failure (“nullptr” when there is none) and its byte offset
+	// from the beginning of the whole input
+	const char* error() const;
+	size_t error_offset() const;
+
+private:
+	// What token goes next
+	enum class Expect { Value, Key, Colon, Comma, End };
+
+	// An array or an object the transcoder is in
+	struct Frame
+	{
+		bool is_object;
+		// Nothing was written in it yet
+		bool empty;
+	};
+
+	ostream &out;
+	string line_break;
+	string block_indent;
+	JsonParsingOptions options;
+	// The unfinished token and the rest of the input after it
+	string input;
+	// Of “input[0]” in the whole input
+	size_t offset = 0;
+	// Nothing is tried until “input” is this long (so that a long unfinished
+	// token is not scanned again for every small piece of it)
+	size_t wait_for = 0;
+	// What is written to “out” once it is “output_bound” long (and at the end
+	// of every piece)
+	string output;
+	static constexpr size_t output_bound = 64 * 1024;
+	vector<Frame> frames;
+	Expect expect = Expect::Value;
+	// For the strings with escapes
+	string buffer;
+	const char *failure = nullptr;
+	size_t failure_offset = 0;
+
+	bool fail(const char *message, size_t pos);
+	// Writes all the complete tokens of “input” and drops them. The last
+	// token is complete at the end of the input.
+	bool run(bool last);
+	// Separator and indentation before an element or a key
+	void begin_item();
+	// Indentation of the current depth
+	void indent();
+	// Writes “output” when it is long enough (or anyway when “all” is set)
+	void flush(bool all);
+	void open(bool is_object);
+	void close();
+	void done_value();
+};
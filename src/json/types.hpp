@@ -1,13 +1,18 @@
 #pragma once
 
-#include <map>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 #include <variant>
 #include <vector>
 
 #include "helpers.hpp"
+#include "json/ordered-map.hpp"
 #include "parser/types.hpp"
 
 using namespace std;
@@ -15,11 +20,29 @@ using namespace std;
 
 struct JsonValue; // Algebraic data type
 
+// Members of an object in the order of the document (see
+// “json/ordered-map.hpp”)
+using JsonMembers = OrderedMap<JsonValue>;
+
 // Constructors-ish
-struct JsonObject: tuple<map<string, JsonValue>> {};
+struct JsonObject: tuple<JsonMembers> {};
 struct JsonArray: tuple<vector<JsonValue>> {};
-struct JsonString: tuple<string> {};
-struct JsonNumber: tuple<variant<int, double>> {};
+// A view into a buffer shared by many values (the parsed input, see
+// “shared_input” parsing option below), “owner” keeps the buffer alive
+struct SharedStringView
+{
+	shared_ptr<const void> owner;
+	string_view view;
+};
+struct JsonString: tuple<variant<string, SharedStringView>> {};
+// Integer numbers are “int64_t” (“uint64_t” only when they do not fit into
+// “int64_t”), the other numbers are “double”
+using JsonNumberValue = variant<int64_t, uint64_t, double>;
+// Source text of a number (already validated) which is converted only when it
+// is accessed (see “lazy_numbers” parsing option below). Like a string value
+// it is a view into the input when the input is kept.
+struct RawJsonNumber: tuple<variant<string, SharedStringView>> {};
+struct JsonNumber: tuple<variant<JsonNumberValue, RawJsonNumber>> {};
 struct JsonBool: tuple<bool> {};
 struct JsonNull: Unit {};
 
@@ -30,50 +53,157 @@ struct JsonValue: variant<
 	JsonNumber,
 	JsonBool,
 	JsonNull
-> {};
+>
+{
+	using variant::variant;
+	JsonValue() = default;
+	JsonValue(const JsonValue &) = default;
+	JsonValue(JsonValue &&) = default;
+	JsonValue &operator=(const JsonValue &) = default;
+	JsonValue &operator=(JsonValue &&) = default;
+	// Goes into the nested values without recursion, so that a document of
+	// any depth is fine (see “json/parse-context.cpp”)
+	~JsonValue();
+};
+
+// Kind of a value that is not parsed yet (see “json/cursor.hpp” and
+// “json/lazy.hpp”), “None” means there is no value
+enum class JsonValueKind { Object, Array, String, Number, Bool, Null, None };
+
+
+// Options of all the JSON parsing engines
+struct JsonParsingOptions
+{
+	// Numbers are kept as “RawJsonNumber” (the conversion is done by
+	// “from_json_number” and the serialization copies the source text as is,
+	// so a number that is just passed through is never converted and is not
+	// changed in any way).
+	//
+	// Mind that a number is converted again on every access. The converted
+	// value is not stored in the number: the values are plain data which are
+	// copied by the unwrappers and read from many threads at once, so a stored
+	// value would need synchronization and it would make every value bigger.
+	// The conversion of a validated number costs about as much as a copy of
+	// it (see “numbers” benchmark), so a number that is used many times should
+	// be converted once by the caller.
+	bool lazy_numbers = false;
+
+	// Whatever keeps the parsed input alive (a “string” or a mapped file).
+	// When it is set the string values without escapes and the lazy numbers
+	// are views into the input (“SharedStringView”) and only the strings with
+	// escapes are decoded into their own “string”. Object keys are always
+	// copied.
+	shared_ptr<const void> shared_input;
+
+	// The deepest nesting of arrays and objects that is accepted. It bounds
+	// the memory of the stack of the engines that keep the nesting on the heap
+	// (“parse_json” with a context, “parse_json_events” and “validate_json”,
+	// see also “recursive_json_max_depth”), the other engines take it into
+	// account too.
+	size_t max_depth = SIZE_MAX;
+};
+
+// The engines that recurse for every level of nesting (the combinators,
+// “parse_json_structural” and “parse_json_parallel”) recurse this many levels
+// at most, so that they never run out of the call stack. The values nested
+// deeper are built on the heap the same way as “parse_json” with a context
+// does (see “json/sax.hpp”).
+constexpr size_t recursive_json_max_depth = 512;
+
+// The failure of a document nested deeper than “max_depth”
+constexpr const char *json_too_deep_failure = "JsonValue: nesting is too deep";
 
 
 // Wrappers and unwrappers {{{1
 
 // JsonObject
-inline JsonObject make_json_object(map<string, JsonValue> x)
+inline JsonObject make_json_object(JsonMembers x)
 {
-	return JsonObject{x};
+	return JsonObject{move(x)};
 };
-inline map<string, JsonValue> from_json_object(JsonObject x)
+inline JsonMembers from_json_object(JsonObject x)
 {
-	return get<0>(x);
+	return move(get<0>(x));
 }
 
 // JsonArray
 inline JsonArray make_json_array(vector<JsonValue> x)
 {
-	return JsonArray{x};
+	return JsonArray{move(x)};
 };
 inline vector<JsonValue> from_json_array(JsonArray x)
 {
-	return get<0>(x);
+	return move(get<0>(x));
 }
 
 // JsonString
 inline JsonString make_json_string(string x)
 {
-	return JsonString{x};
+	return JsonString{move(x)};
+};
+inline JsonString make_shared_json_string(
+	shared_ptr<const void> owner,
+	string_view x
+)
+{
+	return JsonString{SharedStringView{move(owner), x}};
 };
 inline string from_json_string(JsonString x)
 {
-	return get<0>(x);
+	if (auto shared = get_if<SharedStringView>(&get<0>(x)))
+		return string(shared->view);
+	return move(get<string>(get<0>(x)));
+}
+// Contents of either kind of string without copying
+// (valid as long as the value is)
+inline string_view json_string_view(const JsonString &x)
+{
+	if (auto shared = get_if<SharedStringView>(&get<0>(x)))
+		return shared->view;
+	return get<string>(get<0>(x));
 }
 
 // JsonNumber
 template <typename T>
 inline JsonNumber make_json_number(T x)
 {
-	return JsonNumber{x};
+	if constexpr (is_same_v<T, JsonNumberValue>)
+		return visit([](auto y) { return make_json_number(y); }, x);
+	else if constexpr (is_floating_point_v<T>)
+		return JsonNumber{JsonNumberValue{double(x)}};
+	else if constexpr (is_signed_v<T>)
+		return JsonNumber{JsonNumberValue{int64_t(x)}};
+	else if (uint64_t(x) <= uint64_t(INT64_MAX))
+		return JsonNumber{JsonNumberValue{int64_t(x)}};
+	else
+		return JsonNumber{JsonNumberValue{uint64_t(x)}};
 }
-inline variant<int, double> from_json_number(JsonNumber x)
+inline JsonNumber make_raw_json_number(string x)
 {
-	return get<0>(x);
+	return JsonNumber{RawJsonNumber{move(x)}};
+}
+inline JsonNumber make_shared_raw_json_number(
+	shared_ptr<const void> owner,
+	string_view x
+)
+{
+	return JsonNumber{RawJsonNumber{SharedStringView{move(owner), x}}};
+}
+// Source text of either kind of raw number without copying
+// (valid as long as the value is)
+inline string_view raw_json_number_view(const RawJsonNumber &x)
+{
+	if (auto shared = get_if<SharedStringView>(&get<0>(x)))
+		return shared->view;
+	return get<string>(get<0>(x));
+}
+// Conversion of the source text of a number (see “json/scanners.cpp”)
+JsonNumberValue convert_raw_json_number(string_view x);
+inline JsonNumberValue from_json_number(const JsonNumber &x)
+{
+	if (auto raw = get_if<RawJsonNumber>(&get<0>(x)))
+		return convert_raw_json_number(raw_json_number_view(*raw));
+	return get<JsonNumberValue>(get<0>(x));
 }
 
 // JsonBool
@@ -90,7 +220,7 @@ inline bool from_json_bool(JsonBool x)
 template <typename T>
 inline JsonValue make_json_value(T x)
 {
-	return JsonValue{x};
+	return JsonValue{move(x)};
 }
 inline variant<
 	JsonObject,
@@ -101,18 +231,20 @@ inline variant<
 	JsonNull
 > from_json_value(JsonValue x)
 {
-	return move(x);
+	return x;
 }
 
 // }}}1
 
 // Helpers {{{1
 
-template <typename K, typename V>
-inline map<K, V> make_map_from_vector(vector<tuple<K, V>> list)
+// The first of the same keys wins
+template <typename V>
+inline OrderedMap<V> make_map_from_vector(vector<tuple<string, V>> list)
 {
-	map<K, V> result;
-	for (auto [ k, v ] : list) result.insert(make_pair(k, v));
+	OrderedMap<V> result;
+	result.reserve(list.size());
+	for (auto &[ k, v ] : list) result.try_emplace(move(k), move(v));
 	return result;
 }
 
@@ -0,0 +1,338 @@
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#if defined(__AVX2__) || defined(__SSSE3__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "json/utf8.hpp"
+#include "parser/types.hpp"
+
+using namespace std;
+
+// Local shorthand
+using I = ParserInputType<Parser>;
+
+
+// Scalar check {{{1
+
+inline bool is_continuation_byte(char c) { return (c & 0xC0) == 0x80; }
+
+// Checks a single character at “pos” and moves “pos” past it
+inline const char* validate_utf8_char(string_view input, size_t &pos)
+{
+	const unsigned char lead = input[pos];
+
+	if (lead < 0x80) {
+		++pos;
+		return nullptr;
+	}
+
+	size_t length;
+	// Bounds of the second byte of the sequence
+	unsigned char min = 0x80, max = 0xBF;
+	const char *out_of_bounds = nullptr;
+
+	if (lead < 0xC0) {
+		return "UTF-8: unexpected continuation byte";
+	} else if (lead < 0xC2) {
+		return "UTF-8: overlong encoding";
+	} else if (lead < 0xE0) {
+		length = 2;
+	} else if (lead < 0xF0) {
+		length = 3;
+		if (lead == 0xE0) {
+			min = 0xA0;
+			out_of_bounds = "UTF-8: overlong encoding";
+		} else if (lead == 0xED) {
+			max = 0x9F;
+			out_of_bounds = "UTF-8: encoded UTF-16 surrogate";
+		}
+	} else if (lead < 0xF5) {
+		length = 4;
+		if (lead == 0xF0) {
+			min = 0x90;
+			out_of_bounds = "UTF-8: overlong encoding";
+		} else if (lead == 0xF4) {
+			max = 0x8F;
+			out_of_bounds = "UTF-8: code point is out of range";
+		}
+	} else {
+		return "UTF-8: invalid byte";
+	}
+
+	for (size_t i = 1; i < length; ++i) {
+		if (pos + i >= input.size() || !is_continuation_byte(input[pos + i]))
+			return "UTF-8: truncated sequence";
+		const unsigned char c = input[pos + i];
+		if (i == 1 && (c < min || c > max)) return out_of_bounds;
+	}
+
+	pos += length;
+	return nullptr;
+}
+
+// }}}1
+
+
+// Vectorized check {{{1
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+
+#if defined(__AVX2__)
+using Vector = __m256i;
+constexpr size_t vector_size = 32;
+
+inline Vector load(const char *p) { return _mm256_loadu_si256((const Vector*) p); }
+inline Vector splat(uint8_t x) { return _mm256_set1_epi8(char(x)); }
+inline Vector and_bits(Vector a, Vector b) { return _mm256_and_si256(a, b); }
+inline Vector or_bits(Vector a, Vector b) { return _mm256_or_si256(a, b); }
+inline Vector xor_bits(Vector a, Vector b) { return _mm256_xor_si256(a, b); }
+inline Vector saturating_sub(Vector a, Vector b) { return _mm256_subs_epu8(a, b); }
+inline bool is_ascii(Vector x) { return _mm256_movemask_epi8(x) == 0; }
+inline bool is_zero(Vector x) { return _mm256_testz_si256(x, x); }
+
+inline Vector table(const uint8_t (&x)[16])
+{
+	return _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) x));
+}
+
+inline Vector lookup(Vector table, Vector index)
+{
+	return _mm256_shuffle_epi8(table, index);
+}
+
+inline Vector high_nibbles(Vector x)
+{
+	return _mm256_and_si256(_mm256_srli_epi16(x, 4), splat(0x0F));
+}
+
+// Bytes of “input” shifted by “N” with the last bytes of “prev” coming in
+template <int N>
+inline Vector shifted(Vector input, Vector prev)
+{
+	return _mm256_alignr_epi8(
+		input,
+		_mm256_permute2x128_si256(prev, input, 0x21),
+		16 - N
+	);
+}
+#else
+using Vector = __m128i;
+constexpr size_t vector_size = 16;
+
+inline Vector load(const char *p) { return _mm_loadu_si128((const Vector*) p); }
+inline Vector splat(uint8_t x) { return _mm_set1_epi8(char(x)); }
+inline Vector and_bits(Vector a, Vector b) { return _mm_and_si128(a, b); }
+inline Vector or_bits(Vector a, Vector b) { return _mm_or_si128(a, b); }
+inline Vector xor_bits(Vector a, Vector b) { return _mm_xor_si128(a, b); }
+inline Vector saturating_sub(Vector a, Vector b) { return _mm_subs_epu8(a, b); }
+inline bool is_ascii(Vector x) { return _mm_movemask_epi8(x) == 0; }
+
+inline bool is_zero(Vector x)
+{
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_setzero_si128())) == 0xFFFF;
+}
+
+inline Vector table(const uint8_t (&x)[16])
+{
+	return _mm_loadu_si128((const __m128i*) x);
+}
+
+inline Vector lookup(Vector table, Vector index)
+{
+	return _mm_shuffle_epi8(table, index);
+}
+
+inline Vector high_nibbles(Vector x)
+{
+	return _mm_and_si128(_mm_srli_epi16(x, 4), splat(0x0F));
+}
+
+// Bytes of “input” shifted by “N” with the last bytes of “prev” coming in
+template <int N>
+inline Vector shifted(Vector input, Vector prev)
+{
+	return _mm_alignr_epi8(input, prev, 16 - N);
+}
+#endif
+
+// Error classes of a pair of bytes (the previous one and the current one).
+// A pair is malformed when all three lookups have the same bit set.
+constexpr uint8_t too_short = 1 << 0; // 11______ 0_______ or 11______ 11______
+constexpr uint8_t too_long = 1 << 1; // 0_______ 10______
+constexpr uint8_t overlong_3 = 1 << 2; // 11100000 100_____
+constexpr uint8_t too_large = 1 << 3; // 11110100 1001____ and above
+constexpr uint8_t surrogate = 1 << 4; // 11101101 101_____
+constexpr uint8_t overlong_2 = 1 << 5; // 1100000_ 10______
+constexpr uint8_t too_large_1000 = 1 << 6; // 11110101 1000____ and above
+constexpr uint8_t overlong_4 = 1 << 6; // 11110000 1000____
+constexpr uint8_t two_conts = 1 << 7; // 10______ 10______
+constexpr uint8_t carry = too_short | too_long | two_conts;
+
+// By the high nibble of the previous byte
+constexpr uint8_t byte_1_high_table[16] = {
+	// 0_______ (ASCII)
+	too_long, too_long, too_long, too_long,
+	too_long, too_long, too_long, too_long,
+	// 10______ (continuation)
+	two_conts, two_conts, two_conts, two_conts,
+	// 1100____
+	too_short | overlong_2,
+	// 1101____
+	too_short,
+	// 1110____
+	too_short | overlong_3 | surrogate,
+	// 1111____
+	too_short | too_large | too_large_1000 | overlong_4,
+};
+
+// By the low nibble of the previous byte
+constexpr uint8_t byte_1_low_table[16] = {
+	// ____0000
+	carry | overlong_3 | overlong_2 | overlong_4,
+	// ____0001
+	carry | overlong_2,
+	// ____001_
+	carry,
+	carry,
+	// ____0100
+	carry | too_large,
+	// ____0101
+	carry | too_large | too_large_1000,
+	// ____011_
+	carry | too_large | too_large_1000,
+	carry | too_large | too_large_1000,
+	// ____1___
+	carry | too_large | too_large_1000,
+	carry | too_large | too_large_1000,
+	carry | too_large | too_large_1000,
+	carry | too_large | too_large_1000,
+	carry | too_large | too_large_1000,
+	// ____1101
+	carry | too_large | too_large_1000 | surrogate,
+	carry | too_large | too_large_1000,
+	carry | too_large | too_large_1000,
+};
+
+// By the high nibble of the current byte
+constexpr uint8_t byte_2_high_table[16] = {
+	// 0_______ (ASCII)
+	too_short, too_short, too_short, too_short,
+	too_short, too_short, too_short, too_short,
+	// 1000____
+	too_long | overlong_2 | two_conts | overlong_3 | too_large_1000 | overlong_4,
+	// 1001____
+	too_long | overlong_2 | two_conts | overlong_3 | too_large,
+	// 101_____
+	too_long | overlong_2 | two_conts | surrogate | too_large,
+	too_long | overlong_2 | two_conts | surrogate | too_large,
+	// 11______
+	too_short, too_short, too_short, too_short,
+};
+
+// Non-zero when there is an error in “input” (sequences started in “prev”
+// are taken into account)
+inline Vector utf8_errors(Vector input, Vector prev)
+{
+	const Vector prev_1 = shifted<1>(input, prev);
+
+	const Vector special_cases = and_bits(
+		and_bits(
+			lookup(table(byte_1_high_table), high_nibbles(prev_1)),
+			lookup(table(byte_1_low_table), and_bits(prev_1, splat(0x0F)))
+		),
+		lookup(table(byte_2_high_table), high_nibbles(input))
+	);
+
+	// The high bit is set where the third or the fourth byte of a sequence
+	// must be (it is a continuation byte with “two_conts” set)
+	const Vector must_be_continuation = and_bits(
+		or_bits(
+			saturating_sub(shifted<2>(input, prev), splat(0xE0 - 0x80)),
+			saturating_sub(shifted<3>(input, prev), splat(0xF0 - 0x80))
+		),
+		splat(0x80)
+	);
+
+	return xor_bits(must_be_continuation, special_cases);
+}
+
+// Maximal values of the last bytes of a block where a sequence can not start
+// unfinished (the other bytes can be anything)
+constexpr uint8_t incomplete_max[32] = {
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1,
+};
+
+// Non-zero when the last bytes of “input” start a sequence which is not
+// finished in it
+inline Vector incomplete_at_end(Vector input)
+{
+	return saturating_sub(
+		input,
+		load((const char*) incomplete_max + sizeof(incomplete_max) - vector_size)
+	);
+}
+
+#endif
+
+// }}}1
+
+
+const char* validate_utf8(string_view input, size_t &pos)
+{
+#if defined(__AVX2__) || defined(__SSSE3__)
+	const size_t start = pos;
+
+	// Stopping at the end or at the first block with an error, the exact
+	// position is found by the scalar check below
+	Vector prev = splat(0);
+	Vector prev_incomplete = splat(0);
+	for (; input.size() - pos >= vector_size; pos += vector_size) {
+		const Vector x = load(input.data() + pos);
+		if (is_ascii(x)) {
+			if (!is_zero(prev_incomplete)) break;
+		} else {
+			if (!is_zero(utf8_errors(x, prev))) break;
+			prev_incomplete = incomplete_at_end(x);
+		}
+		prev = x;
+	}
+
+	// Going back to the start of the sequence crossing the block boundary
+	for (size_t i = 0; i < 3 && pos > start; ++i) {
+		if (!is_continuation_byte(input[pos - 1])) break;
+		--pos;
+	}
+	if (pos > start && (unsigned char) input[pos - 1] >= 0xC0) --pos;
+#endif
+
+	while (pos < input.size()) {
+#if !defined(__AVX2__) && !defined(__SSSE3__) && defined(__SSE2__)
+		// Skipping ASCII characters
+		while (
+			input.size() - pos >= 16 &&
+			_mm_movemask_epi8(_mm_loadu_si128((const __m128i*) (input.data() + pos)))
+				== 0
+		) pos += 16;
+		if (pos >= input.size()) break;
+#endif
+		const char *err = validate_utf8_char(input, pos);
+		if (err != nullptr) return err;
+	}
+
+	return nullptr;
+}
+
+optional<ParsingError<I>> utf8_parsing_error(I input)
+{
+	size_t pos = 0;
+	const char *err = validate_utf8(input, pos);
+	if (err == nullptr) return nullopt;
+	return make_parsing_error<I>(err, input.substr(pos));
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+// Validation of UTF-8 well-formedness (RFC 3629: no overlong encodings, no
+// UTF-16 surrogates, nothing above U+10FFFF).
+//
+// With AVX2 (or SSSE3) it runs the vectorized lookup algorithm by Keiser and
+// Lemire (the one of “simdjson”) which checks 32 (or 16) bytes at a time with
+// a few table lookups. Otherwise blocks of ASCII characters are skipped with
+// SSE2 and the rest is checked byte by byte. In any case the exact position is
+// found by the scalar check.
+//
+// It is an optional stage that can be run before any JSON parsing engine (see
+// “--validate-utf8” option of the application).
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+#include "parser/types.hpp"
+
+using namespace std;
+
+
+// Starts at “pos”. On success it returns “nullptr” and “pos” is the size of
+// the input, on failure it returns an error message and “pos” is the offset
+// of the first byte of the malformed sequence.
+const char* validate_utf8(string_view input, size_t &pos);
+
+// Same check as a parsing error (its tail starts at the malformed sequence,
+// so that “parsing_error_offset” gives the exact offset)
+optional<ParsingError<ParserInputType<Parser>>> utf8_parsing_error(
+	ParserInputType<Parser> input
+);
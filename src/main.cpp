@@ -1,22 +1,52 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
 #include <sstream>
 #include <string.h>
 #include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
 #include <variant>
+#include <vector>
 
 #include "helpers.hpp"
+#include "json/ndjson.hpp"
+#include "json/offset-index.hpp"
 #include "json/parsers.hpp"
+#include "json/parallel.hpp"
+#include "json/parse-context.hpp"
+#include "json/pointer.hpp"
+#include "json/sax.hpp"
+#include "json/select.hpp"
 #include "json/serialization.hpp"
+#include "json/structural-index.hpp"
+#include "json/transcoder.hpp"
 #include "json/types.hpp"
+#include "json/utf8.hpp"
+#include "mapped-file.hpp"
+#include "parser/position.hpp"
 #include "parser/resolvers.hpp"
 #include "parser/types.hpp"
-#include "test.hpp"
+#include "thread-pool.hpp"
 
 #include "json/data-modeling/example-type.hpp"
 #include "json/data-modeling/parsers.hpp"
 #include "json/data-modeling/serialization.hpp"
 
+// The unit tests and the benchmarks count the allocations, so they are only
+// built into a separate program (see “Makefile”)
+#ifdef WITH_DEV_COMMANDS
+#include "bench.hpp"
+#include "test.hpp"
+#endif
+
 using namespace std;
 
 
@@ -32,6 +62,53 @@ void show_usage(ostream& out, char* app)
 		<< "  -h, --help  Show this help message" << endl
 		<< "  --pretty    Enable pretty printing for output JSON" << endl
 		<< endl
+		<< "  --engine NAME" << endl
+		<< "              JSON parsing engine:" << endl
+		<< "                combinators  Composition of parsers (default)" << endl
+		<< "                structural   Vectorized structural index" << endl
+		<< "                parallel     Structural index on all the cores" << endl
+		<< "                             (for huge arrays and objects)" << endl
+		<< "                context      Events without recursion" << endl
+		<< endl
+		<< "  --validate-utf8" << endl
+		<< "              Reject input which is not well-formed UTF-8" << endl
+		<< "              (checked before parsing with any engine)" << endl
+		<< endl
+		<< "  --lazy-numbers" << endl
+		<< "              Keep the source text of numbers and convert" << endl
+		<< "              it only when it is used (numbers are written" << endl
+		<< "              to the output exactly as they are)" << endl
+		<< endl
+		<< "  --zero-copy-strings" << endl
+		<< "              String values without escapes are views" << endl
+		<< "              into the input instead of copies" << endl
+		<< endl
+		<< "  --validate  Only check that the input is valid JSON" << endl
+		<< "              (nothing is built and nothing is printed," << endl
+		<< "              the engine does not matter)" << endl
+		<< endl
+		<< "  --stream    Rewrite the input token by token as it" << endl
+		<< "              comes (compact or with “--pretty”) without" << endl
+		<< "              building a document (keys keep their order," << endl
+		<< "              the engine does not matter)" << endl
+		<< endl
+		<< "  --ndjson    Every line of the input is a separate document" << endl
+		<< "              (they are parsed on all the cores and written" << endl
+		<< "              in the same order, a failure of a line is" << endl
+		<< "              reported with its number and the rest of the" << endl
+		<< "              lines are still processed; it works with" << endl
+		<< "              “--pretty”, “--model” and “--validate”)" << endl
+		<< endl
+		<< "  --select PATH" << endl
+		<< "              Print only the values at the path, one per" << endl
+		<< "              line (a JSON Pointer like “/a/3/b” where “*”" << endl
+		<< "              matches every key or element; the rest of the" << endl
+		<< "              input is skipped without parsing and it is" << endl
+		<< "              not validated, except that nothing may follow" << endl
+		<< "              the value of an empty path, which is the whole" << endl
+		<< "              document; it can be repeated and it works" << endl
+		<< "              with “--ndjson”)" << endl
+		<< endl
 		<< "  --model     Apply parsing from JSON into a data model" << endl
 		<< "              and then apply serialization back to JSON" << endl
 		<< "              (mind that it works only with data from" << endl
@@ -40,11 +117,43 @@ void show_usage(ostream& out, char* app)
 		<< "              empty list of unknown type)" << endl
 		<< endl
 		<< "Commands:" << endl
+		<< "  index FILE [INDEX]" << endl
+		<< "              Write an offset index of a JSON file" << endl
+		<< "              (to “FILE.index” by default)" << endl
+		<< "  get FILE POINTER [INDEX]" << endl
+		<< "              Print a value of an indexed JSON file by" << endl
+		<< "              its JSON Pointer (like “/a/3/b”), only that" << endl
+		<< "              value is read and parsed (with the engine)" << endl;
+#ifdef WITH_DEV_COMMANDS
+	out
 		<< "  test        Run the unit tests" << endl
-		<< endl;
+		<< "  bench [NAME(S)]" << endl
+		<< "              Run the benchmarks (all of them by default)" << endl
+		<< "              Available benchmarks:" << endl
+		<< "                threads  Parsing on multiple threads" << endl
+		<< "                engines  JSON parsing engines compared" << endl
+		<< "                depth    Engines on deep nesting" << endl
+		<< "                huge     Parsing a huge document on many cores" << endl
+		<< "                cursor   A field of a huge array with a cursor" << endl
+		<< "                lazy     A few fields with a lazy document" << endl
+		<< "                transcode" << endl
+		<< "                         Minifying and pretty-printing" << endl
+		<< "                         without a document" << endl
+		<< "                ndjson   Records of NDJSON on many cores" << endl
+		<< "                incremental" << endl
+		<< "                         Small edits of a huge document" << endl
+		<< "                index    A field found with an offset index" << endl
+		<< "                select   Fields selected without a document" << endl
+		<< "                tape     A flat document compared with a tree" << endl
+		<< "                objects  Lookups in objects compared with std::map" << endl
+		<< "                numbers  Parsing and conversion of numbers" << endl
+		<< "                strings  Strings copied or shared with input" << endl
+		<< "                utf8     UTF-8 validation" << endl;
+#endif
+	out << endl;
 }
 
-string serialize_json_to_string(bool pretty_print, JsonValue x)
+string serialize_json_to_string(bool pretty_print, const JsonValue &x)
 {
 	if (pretty_print) {
 		ostringstream line_break;
@@ -55,20 +164,98 @@ string serialize_json_to_string(bool pretty_print, JsonValue x)
 	}
 }
 
-JsonValue parse_json_and_resolve_result(string json_input)
+using JsonEngine = function<
+	variant<ParsingError<ParserInputType<Parser>>, JsonValue>
+	(ParserInputType<Parser>, JsonParsingOptions)
+>;
+
+variant<ParsingError<ParserInputType<Parser>>, JsonValue> parse_with_context(
+	ParserInputType<Parser> x,
+	JsonParsingOptions options
+)
 {
-	return visit(overloaded {
-		[](ParsingError<ParserInputType<Parser>> err) -> JsonValue {
-			cerr
-				<< "Failed to parse JSON: " << err.first << endl
-				<< "Input tail: " << quoted(err.second) << endl;
-			exit(EXIT_FAILURE);
-		},
-		[](JsonValue x) -> JsonValue { return x; }
-	}, parse_json(json_input));
+	ParseContext ctx;
+	return parse_json(ctx, x, options);
+}
+
+// The data model is parsed out of a document recursively (and the document
+// is copied on the way), so the document must not be nested deeper than this
+const size_t model_max_depth = 256;
+
+// Available JSON parsing engines by their names
+const map<string, JsonEngine> json_engines = {
+	{"combinators", [](ParserInputType<Parser> x, JsonParsingOptions options) {
+		return parse_json(x, options);
+	}},
+	{"structural", [](ParserInputType<Parser> x, JsonParsingOptions options) {
+		return parse_json_structural(x, options);
+	}},
+	{"parallel", [](ParserInputType<Parser> x, JsonParsingOptions options) {
+		static ThreadPool pool(thread::hardware_concurrency());
+		return parse_json_parallel(pool, x, 1 << 20, options);
+	}},
+	{"context", parse_with_context},
+};
+
+// Runs the UTF-8 validation before the engine
+JsonEngine with_utf8_validation(JsonEngine engine)
+{
+	return [engine](ParserInputType<Parser> x, JsonParsingOptions options)
+	-> variant<ParsingError<ParserInputType<Parser>>, JsonValue> {
+		if (auto err = utf8_parsing_error(x)) return *err;
+		return engine(x, options);
+	};
+}
+
+void show_parsing_error(
+	string_view json_input,
+	ParsingError<ParserInputType<Parser>> err,
+	const char *what = "Failed to parse JSON"
+)
+{
+	const TextPosition position = text_position(
+		json_input,
+		parsing_error_offset(json_input, err)
+	);
+	cerr
+		<< what << ": " << err.first << endl
+		<< "At line " << position.line << ", column " << position.column
+		<< " (byte offset " << position.offset << "):" << endl
+		<< text_excerpt(json_input, position.offset) << endl;
+}
+
+JsonValue parse_json_and_resolve_result(
+	const JsonEngine &engine,
+	JsonParsingOptions options,
+	const string &json_input
+)
+{
+	auto result = engine(json_input, options);
+	if (auto err = get_if<ParsingError<ParserInputType<Parser>>>(&result)) {
+		show_parsing_error(json_input, *err);
+		exit(EXIT_FAILURE);
+	}
+	// Moved, a copy of a deep document would recurse
+	return move(get<JsonValue>(result));
 }
 
-ExampleType parse_example_type_and_resolve_result(JsonValue json_input)
+// Where a failure of the parsing from JSON is (keys separated by dots)
+string show_json_path(const ParsingError<ParserInputType<FromJsonParser>> &err)
+{
+	ostringstream out;
+	bool first = true;
+	for (auto x : err.second.second) {
+		if (first) {
+			out << x;
+			first = false;
+		} else {
+			out << "." << x;
+		}
+	}
+	return out.str();
+}
+
+ExampleType parse_example_type_and_resolve_result(const JsonValue &json_input)
 {
 	variant<
 		ParsingError<ParserInputType<FromJsonParser>>,
@@ -81,20 +268,7 @@ ExampleType parse_example_type_and_resolve_result(JsonValue json_input)
 
 	return visit(overloaded {
 		[](ParsingError<ParserInputType<FromJsonParser>> err) -> ExampleType {
-			string json_path;
-			{
-				ostringstream out;
-				bool first = true;
-				for (auto x : err.second.second) {
-					if (first) {
-						out << x;
-						first = false;
-					} else {
-						out << "." << x;
-					}
-				}
-				json_path = out.str();
-			}
+			const string json_path = show_json_path(err);
 
 			cerr
 				// TODO substitute type name
@@ -118,6 +292,253 @@ string slurp_stdin()
 	return out.str();
 }
 
+// Reads the input piece by piece (whatever is available, so that the output
+// goes as soon as the input comes) until “consume” returns “false”. Returns
+// “false” only when the input cannot be read.
+bool read_stdin_pieces(const function<bool(string_view)> &consume)
+{
+	vector<char> chunk(1 << 16);
+	for (;;) {
+		const ssize_t n = read(STDIN_FILENO, chunk.data(), chunk.size());
+		if (n == 0) return true;
+		if (n < 0) {
+			cerr << "Failed to read the input" << endl;
+			return false;
+		}
+		if (!consume(string_view(chunk.data(), n))) return true;
+	}
+}
+
+int transcode_stdin(bool pretty_print, JsonParsingOptions options)
+{
+	JsonTranscoder transcoder(
+		cout,
+		pretty_print ? "\n" : "",
+		pretty_print ? "  " : "",
+		move(options)
+	);
+
+	bool ok = true;
+	if (!read_stdin_pieces([&transcoder, &ok](string_view x) {
+		ok = transcoder.feed(x);
+		cout.flush();
+		return ok;
+	})) return EXIT_FAILURE;
+	if (ok) ok = transcoder.finish();
+
+	if (!ok) {
+		cout << endl;
+		cerr
+			<< "Failed to parse JSON: " << transcoder.error() << endl
+			<< "At byte offset " << transcoder.error_offset() << endl;
+		return EXIT_FAILURE;
+	}
+	cout << endl;
+	return EXIT_SUCCESS;
+}
+
+// Offset index of a file (see “json/offset-index.hpp”)
+int write_index_file(const string &path, const string &index_path)
+{
+	const MappedFile file(path);
+	if (file.error() != nullptr) {
+		cerr << file.error() << ": " << quoted(path) << endl;
+		return EXIT_FAILURE;
+	}
+
+	ofstream out(index_path, ios::binary);
+	if (auto err = write_json_offset_index(file.data(), out)) {
+		show_parsing_error(file.data(), *err);
+		out.close();
+		remove(index_path.c_str());
+		return EXIT_FAILURE;
+	}
+
+	out.close();
+	if (!out) {
+		cerr << "Failed to write the index: " << quoted(index_path) << endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+// Only the value is parsed, the index tells where it is
+int get_value_from_file(
+	const JsonEngine &engine,
+	JsonParsingOptions options,
+	bool pretty_print,
+	const string &path,
+	const string &pointer,
+	const string &index_path
+)
+{
+	using I = ParserInputType<Parser>;
+
+	const MappedFile file(path);
+	const MappedFile index(index_path);
+	for (auto [x, x_path] : {pair(&file, &path), pair(&index, &index_path)})
+		if (x->error() != nullptr) {
+			cerr << x->error() << ": " << quoted(*x_path) << endl;
+			return EXIT_FAILURE;
+		}
+
+	// The index of a file that was changed since then is not used
+	struct stat file_info, index_info;
+	if (
+		stat(path.c_str(), &file_info) != 0 ||
+		stat(index_path.c_str(), &index_info) != 0 ||
+		index_info.st_mtime < file_info.st_mtime
+	) {
+		cerr
+			<< "The index is older than the file (see “index” command): "
+			<< quoted(index_path) << endl;
+		return EXIT_FAILURE;
+	}
+
+	auto found = find_json_value(file.data(), index.data(), pointer);
+	if (auto err = get_if<ParsingError<I>>(&found)) {
+		show_parsing_error(file.data(), *err, "Failed to find the value");
+		return EXIT_FAILURE;
+	}
+
+	const string_view value = get<string_view>(found);
+	auto json = engine(value, options);
+	if (auto err = get_if<ParsingError<I>>(&json)) {
+		// The position in the whole file
+		const size_t offset =
+			(value.data() - file.data().data()) +
+			parsing_error_offset(value, *err);
+		show_parsing_error(
+			file.data(),
+			make_parsing_error<I>(err->first, file.data().substr(offset))
+		);
+		return EXIT_FAILURE;
+	}
+
+	cout << serialize_json_to_string(pretty_print, get<JsonValue>(json)) << endl;
+	return EXIT_SUCCESS;
+}
+
+// The values at the paths (see “json/select.hpp”) parsed with the engine, one
+// per line
+optional<ParsingError<ParserInputType<Parser>>> select_values(
+	const JsonEngine &engine,
+	const JsonParsingOptions &options,
+	bool pretty_print,
+	ParserInputType<Parser> input,
+	const vector<vector<string>> &paths,
+	string &out
+)
+{
+	using I = ParserInputType<Parser>;
+
+	auto selected = select_json(input, paths);
+	if (auto err = get_if<ParsingError<I>>(&selected)) return *err;
+
+	for (auto &values : get<vector<vector<string_view>>>(selected))
+		for (string_view value : values) {
+			auto json = engine(value, options);
+			if (auto err = get_if<ParsingError<I>>(&json)) {
+				// The position in the whole input
+				const size_t offset =
+					(value.data() - input.data()) +
+					parsing_error_offset(value, *err);
+				return make_parsing_error<I>(err->first, input.substr(offset));
+			}
+			out += serialize_json_to_string(pretty_print, get<JsonValue>(json));
+			out += '\n';
+		}
+
+	return nullopt;
+}
+
+// Every line of the input is a separate document (see “json/ndjson.hpp”)
+int process_ndjson_stdin(
+	const JsonEngine &engine,
+	JsonParsingOptions options,
+	bool pretty_print,
+	bool modeled_data,
+	bool validation_only,
+	bool utf8_validation,
+	const vector<vector<string>> &select_paths
+)
+{
+	using I = ParserInputType<Parser>;
+
+	NdjsonProcessor::Transform transform =
+		[&](string_view record, string &out) -> optional<string> {
+			const auto show_error = [record](ParsingError<I> err) -> string {
+				const TextPosition position = text_position(
+					record,
+					parsing_error_offset(record, err)
+				);
+				return
+					"Failed to parse JSON: " + err.first +
+					" (column " + to_string(position.column) + ")";
+			};
+
+			if (validation_only) {
+				optional<ParsingError<I>> err =
+					utf8_validation ? utf8_parsing_error(record) : nullopt;
+				if (!err.has_value()) err = validate_json(record);
+				if (err.has_value()) return show_error(*err);
+				return nullopt;
+			}
+
+			if (!select_paths.empty()) {
+				optional<ParsingError<I>> err =
+					utf8_validation ? utf8_parsing_error(record) : nullopt;
+				if (!err.has_value())
+					err = select_values(
+						engine,
+						options,
+						pretty_print,
+						record,
+						select_paths,
+						out
+					);
+				if (err.has_value()) return show_error(*err);
+				return nullopt;
+			}
+
+			auto json = engine(record, options);
+			if (auto err = get_if<ParsingError<I>>(&json)) return show_error(*err);
+
+			if (modeled_data) {
+				auto x = parse<ExampleType, FromJsonParser>(
+					from_json<ExampleType>(),
+					make_from_json_input(get<JsonValue>(json))
+				);
+				using E = ParsingError<ParserInputType<FromJsonParser>>;
+				if (auto err = get_if<E>(&x)) {
+					const string json_path = show_json_path(*err);
+					return
+						"Failed to parse ExampleType: " + err->first +
+						" (JSON path: “" +
+						(json_path.empty() ? "(root)" : json_path) + "”)";
+				}
+				out += serialize_json_to_string(
+					pretty_print,
+					to_json(get<ExampleType>(x))
+				);
+			} else {
+				out += serialize_json_to_string(pretty_print, get<JsonValue>(json));
+			}
+			out += '\n';
+			return nullopt;
+		};
+
+	ThreadPool pool(thread::hardware_concurrency());
+	NdjsonProcessor processor(pool, move(transform), cout, cerr);
+	if (!read_stdin_pieces([&processor](string_view x) {
+		processor.feed(x);
+		return true;
+	})) return EXIT_FAILURE;
+	processor.finish();
+
+	return processor.failures_count() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 void show_incorrect_arguments_error(int argc, char* argv[])
 {
 	cerr << "Incorrect arguments:";
@@ -132,12 +553,34 @@ int main(int argc, char* argv[])
 	bool pretty_print = false;
 	bool modeled_data = false;
 	bool run_tests = false;
+	bool run_bench = false;
+	bool utf8_validation = false;
+	bool validation_only = false;
+	bool streaming = false;
+	bool ndjson = false;
+	JsonParsingOptions parsing_options;
+	bool zero_copy_strings = false;
+	string engine = "combinators";
+	vector<string> bench_names;
+	bool index_command = false;
+	bool get_command = false;
+	vector<string> command_arguments;
+	vector<vector<string>> select_paths;
 
 	for (decltype(argc) i = 1; i < argc; ++i) {
 		// It’s always okay to call “--help” at any point
 		if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
 			show_help = true;
 		}
+		// After “bench” sub-command only benchmark names can go
+		else if (run_bench) {
+			bench_names.push_back(argv[i]);
+		}
+		// After “index” or “get” sub-command only its arguments can go
+		else if (index_command || get_command) {
+			command_arguments.push_back(argv[i]);
+		}
+#ifdef WITH_DEV_COMMANDS
 		// “test” sub-command
 		else if (strcmp(argv[i], "test") == 0) {
 			if (run_tests && (pretty_print || modeled_data)) {
@@ -147,15 +590,79 @@ int main(int argc, char* argv[])
 				run_tests = true;
 			}
 		}
+		// “bench” sub-command
+		else if (strcmp(argv[i], "bench") == 0) {
+			if (run_tests || pretty_print || modeled_data) {
+				show_incorrect_arguments_error(argc, argv);
+				return EXIT_FAILURE;
+			} else {
+				run_bench = true;
+			}
+		}
+#endif
 		// If there were “test” sub-command any other argument is incorrect
 		else if (run_tests) {
 			show_incorrect_arguments_error(argc, argv);
 			return EXIT_FAILURE;
 		}
+		// “index” sub-command
+		else if (strcmp(argv[i], "index") == 0) {
+			index_command = true;
+		}
+		// “get” sub-command
+		else if (strcmp(argv[i], "get") == 0) {
+			get_command = true;
+		}
 		// Print “pretty” human-readable JSON instead of one-line JSON
 		else if (strcmp(argv[i], "--pretty") == 0) {
 			pretty_print = true;
 		}
+		// Pick a JSON parsing engine
+		else if (strcmp(argv[i], "--engine") == 0) {
+			if (i + 1 >= argc || json_engines.count(argv[i + 1]) == 0) {
+				show_incorrect_arguments_error(argc, argv);
+				return EXIT_FAILURE;
+			} else {
+				engine = argv[++i];
+			}
+		}
+		// Check that the input is well-formed UTF-8 before parsing
+		else if (strcmp(argv[i], "--validate-utf8") == 0) {
+			utf8_validation = true;
+		}
+		// Convert numbers only when they are used
+		else if (strcmp(argv[i], "--lazy-numbers") == 0) {
+			parsing_options.lazy_numbers = true;
+		}
+		// Keep the input and make string values views into it
+		else if (strcmp(argv[i], "--zero-copy-strings") == 0) {
+			zero_copy_strings = true;
+		}
+		// Only check the input
+		else if (strcmp(argv[i], "--validate") == 0) {
+			validation_only = true;
+		}
+		// Transcode without parsing into a document
+		else if (strcmp(argv[i], "--stream") == 0) {
+			streaming = true;
+		}
+		// Every line is a separate document
+		else if (strcmp(argv[i], "--ndjson") == 0) {
+			ndjson = true;
+		}
+		// Only the values at the path
+		else if (strcmp(argv[i], "--select") == 0) {
+			if (i + 1 >= argc) {
+				show_incorrect_arguments_error(argc, argv);
+				return EXIT_FAILURE;
+			}
+			select_paths.emplace_back();
+			const char *err = split_json_pointer(argv[++i], select_paths.back());
+			if (err != nullptr) {
+				cerr << err << ": " << quoted(argv[i]) << endl;
+				return EXIT_FAILURE;
+			}
+		}
 		// Also parse “ExampleType” from parsed JSON
 		else if (strcmp(argv[i], "--model") == 0) {
 			modeled_data = true;
@@ -166,15 +673,142 @@ int main(int argc, char* argv[])
 		}
 	}
 
+	// The streaming mode never has the whole input
+	if (
+		streaming &&
+		(modeled_data || utf8_validation || validation_only || zero_copy_strings)
+	) {
+		show_incorrect_arguments_error(argc, argv);
+		return EXIT_FAILURE;
+	}
+
+	// Records are parsed on all the cores already, and they are not kept
+	if (ndjson && (streaming || zero_copy_strings || engine == "parallel")) {
+		show_incorrect_arguments_error(argc, argv);
+		return EXIT_FAILURE;
+	}
+
+	// Selected values are printed as they are
+	if (
+		!select_paths.empty() &&
+		(modeled_data || validation_only || streaming)
+	) {
+		show_incorrect_arguments_error(argc, argv);
+		return EXIT_FAILURE;
+	}
+
+	// A file instead of the input and a single value of it in the output
+	if (
+		(index_command || get_command) &&
+		(
+			modeled_data || validation_only || streaming || ndjson ||
+			!select_paths.empty() ||
+			zero_copy_strings || utf8_validation ||
+			command_arguments.size() < (index_command ? 1 : 2) ||
+			command_arguments.size() > (index_command ? 2 : 3)
+		)
+	) {
+		show_incorrect_arguments_error(argc, argv);
+		return EXIT_FAILURE;
+	}
+
+	if (modeled_data) parsing_options.max_depth = model_max_depth;
+
 	if (show_help) {
 		show_usage(cout, argv[0]);
 		return EXIT_SUCCESS;
 	}
+#ifdef WITH_DEV_COMMANDS
 	else if (run_tests) {
 		return run_test_cases();
 	}
+	else if (run_bench) {
+		return run_benchmarks(bench_names);
+	}
+#endif
+	else if (index_command) {
+		return write_index_file(
+			command_arguments[0],
+			command_arguments.size() > 1
+				? command_arguments[1]
+				: command_arguments[0] + ".index"
+		);
+	}
+	else if (get_command) {
+		return get_value_from_file(
+			json_engines.at(engine),
+			parsing_options,
+			pretty_print,
+			command_arguments[0],
+			command_arguments[1],
+			command_arguments.size() > 2
+				? command_arguments[2]
+				: command_arguments[0] + ".index"
+		);
+	}
+	else if (ndjson) {
+		return process_ndjson_stdin(
+			utf8_validation
+				? with_utf8_validation(json_engines.at(engine))
+				: json_engines.at(engine),
+			parsing_options,
+			pretty_print,
+			modeled_data,
+			validation_only,
+			utf8_validation,
+			select_paths
+		);
+	}
+	else if (streaming) {
+		return transcode_stdin(pretty_print, parsing_options);
+	}
+	else if (validation_only) {
+		const string input = slurp_stdin();
+		optional<ParsingError<ParserInputType<Parser>>> err =
+			utf8_validation ? utf8_parsing_error(input) : nullopt;
+		if (!err.has_value()) err = validate_json(input);
+
+		if (err.has_value()) {
+			show_parsing_error(input, *err);
+			return EXIT_FAILURE;
+		}
+		return EXIT_SUCCESS;
+	}
 	else {
-		JsonValue json = parse_json_and_resolve_result(slurp_stdin());
+		const auto input = make_shared<const string>(slurp_stdin());
+		if (zero_copy_strings) parsing_options.shared_input = input;
+
+		// The whole input is checked for UTF-8 even though only a part of it
+		// is parsed
+		if (!select_paths.empty()) {
+			string out;
+			optional<ParsingError<ParserInputType<Parser>>> err =
+				utf8_validation ? utf8_parsing_error(*input) : nullopt;
+			if (!err.has_value())
+				err = select_values(
+					json_engines.at(engine),
+					parsing_options,
+					pretty_print,
+					*input,
+					select_paths,
+					out
+				);
+
+			if (err.has_value()) {
+				show_parsing_error(*input, *err);
+				return EXIT_FAILURE;
+			}
+			cout << out;
+			return EXIT_SUCCESS;
+		}
+
+		JsonValue json = parse_json_and_resolve_result(
+			utf8_validation
+				? with_utf8_validation(json_engines.at(engine))
+				: json_engines.at(engine),
+			parsing_options,
+			*input
+		);
 
 		if (modeled_data) {
 			ExampleType x = parse_example_type_and_resolve_result(json);
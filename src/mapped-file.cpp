@@ -0,0 +1,52 @@
+#include <fcntl.h>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mapped-file.hpp"
+
+using namespace std;
+
+
+MappedFile::MappedFile(const string &path)
+{
+	const int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		failure = "Failed to open the file";
+		return;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		failure = "Failed to get the size of the file";
+	} else if (info.st_size > 0) {
+		// The mapping stays after the file is closed
+		void *x = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (x == MAP_FAILED) {
+			failure = "Failed to map the file";
+		} else {
+			address = x;
+			size = info.st_size;
+		}
+	}
+
+	close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+	if (address != nullptr) munmap(address, size);
+}
+
+string_view MappedFile::data() const
+{
+	if (address == nullptr) return string_view();
+	return string_view(static_cast<const char*>(address), size);
+}
+
+const char* MappedFile::error() const
+{
+	return failure;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+// A whole file mapped into memory read-only. Nothing is read up front, the
+// pages are read from the disk only when they are touched, so a small part of
+// a huge file costs about the same as that part alone.
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+
+class MappedFile
+{
+public:
+	explicit MappedFile(const string &path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// The contents (empty after a failure)
+	string_view data() const;
+	// “nullptr” when the file is mapped
+	const char* error() const;
+
+private:
+	void *address = nullptr;
+	size_t size = 0;
+	const char *failure = nullptr;
+};
@@ -99,25 +99,22 @@ Parser<string> string_(string s)
 	return prefix_parsing_failure(
 		"string_(\"" + s + "\")",
 		Parser<string>{[=](I input) -> ParsingResult<string, I> {
-			string taken_string;
-
 			if (input.empty())
 				return make_parsing_error<I>("Input is empty", input);
 			else if (input.size() < s.size())
 				return make_parsing_error<I>(
-					"Input is less than string (input is: \"" + input + "\")",
+					"Input is less than string (input is: \"" +
+					string(input) + "\")",
 					input
 				);
-			else if ((taken_string = input.substr(0, s.size())) != s)
+			else if (input.substr(0, s.size()) != s)
 				return make_parsing_error<I>(
-					"String is different, got this: \"" + taken_string + "\"",
+					"String is different, got this: \"" +
+					string(input.substr(0, s.size())) + "\"",
 					input
 				);
 			else
-				return make_parsing_success<string, I>(
-					taken_string,
-					input.substr(s.size())
-				);
+				return make_parsing_success<string, I>(s, input.substr(s.size()));
 		}}
 	);
 }
@@ -133,9 +130,11 @@ Parser<string> digits()
 template <typename T>
 inline Parser<T> generic_decimal_parser(string parser_name)
 {
+	Parser<string> decimal_number = digits();
+
 	return prefix_parsing_failure(
 		parser_name,
-		Parser<T>{[](I input) -> ParsingResult<T, I> {
+		Parser<T>{[decimal_number](I input) -> ParsingResult<T, I> {
 			return visit(overloaded {
 				[](ParsingError<I> err) -> ParsingResult<T, I> { return err; },
 				[input](ParsingSuccess<string, I> x) -> ParsingResult<T, I> {
@@ -153,7 +152,7 @@ inline Parser<T> generic_decimal_parser(string parser_name)
 						);
 					}
 				}
-			}, digits()(input));
+			}, decimal_number(input));
 		}}
 	);
 }
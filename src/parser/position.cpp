@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "parser/position.hpp"
+#include "parser/types.hpp"
+
+using namespace std;
+
+
+size_t parsing_error_offset(
+	ParserInputType<Parser> input,
+	ParsingError<ParserInputType<Parser>> err
+)
+{
+	// The tail is always a suffix of the input
+	return input.size() - min(input.size(), err.second.size());
+}
+
+// Newlines are counted in per-byte counters of a vector register (comparison
+// gives -1 for every match so the match is subtracted). The counters are
+// summed up before any of them could overflow.
+size_t count_newlines(string_view input)
+{
+	const char *p = input.data();
+	const char *const end = p + input.size();
+	size_t count = 0;
+
+#if defined(__AVX2__)
+	const __m256i newline = _mm256_set1_epi8('\n');
+	while (end - p >= 32) {
+		__m256i counters = _mm256_setzero_si256();
+		for (int i = 0; i < 255 && end - p >= 32; ++i, p += 32) {
+			const __m256i chunk = _mm256_loadu_si256((const __m256i*) p);
+			counters = _mm256_sub_epi8(
+				counters,
+				_mm256_cmpeq_epi8(chunk, newline)
+			);
+		}
+		const __m256i sums = _mm256_sad_epu8(counters, _mm256_setzero_si256());
+		count +=
+			_mm256_extract_epi64(sums, 0) + _mm256_extract_epi64(sums, 1) +
+			_mm256_extract_epi64(sums, 2) + _mm256_extract_epi64(sums, 3);
+	}
+#elif defined(__SSE2__)
+	const __m128i newline = _mm_set1_epi8('\n');
+	while (end - p >= 16) {
+		__m128i counters = _mm_setzero_si128();
+		for (int i = 0; i < 255 && end - p >= 16; ++i, p += 16) {
+			const __m128i chunk = _mm_loadu_si128((const __m128i*) p);
+			counters = _mm_sub_epi8(counters, _mm_cmpeq_epi8(chunk, newline));
+		}
+		const __m128i sums = _mm_sad_epu8(counters, _mm_setzero_si128());
+		count +=
+			_mm_cvtsi128_si32(sums) +
+			_mm_cvtsi128_si32(_mm_unpackhi_epi64(sums, sums));
+	}
+#endif
+
+	for (; p < end; ++p) if (*p == '\n') ++count;
+	return count;
+}
+
+inline bool is_utf8_continuation(char c)
+{
+	return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+inline size_t count_code_points(string_view s)
+{
+	return count_if(s.begin(), s.end(), [](char c) {
+		return !is_utf8_continuation(c);
+	});
+}
+
+inline size_t line_start(string_view input, size_t offset)
+{
+	if (offset == 0) return 0;
+	size_t newline = input.rfind('\n', offset - 1);
+	return newline == string_view::npos ? 0 : newline + 1;
+}
+
+TextPosition text_position(string_view input, size_t offset)
+{
+	offset = min(offset, input.size());
+	const size_t start = line_start(input, offset);
+	return TextPosition{
+		offset,
+		count_newlines(input.substr(0, start)) + 1,
+		count_code_points(input.substr(start, offset - start)) + 1
+	};
+}
+
+string text_excerpt(string_view input, size_t offset, size_t radius)
+{
+	offset = min(offset, input.size());
+	const size_t start = line_start(input, offset);
+	const size_t end = min(input.find('\n', offset), input.size());
+
+	size_t from = max(start, offset > radius ? offset - radius : 0);
+	size_t to = min(end, offset + 1 + radius);
+	// Do not cut UTF-8 characters
+	while (from < offset && is_utf8_continuation(input[from])) ++from;
+	while (to > offset && to < end && is_utf8_continuation(input[to])) --to;
+
+	string line = from > start ? "…" : "";
+	for (char c : input.substr(from, to - from))
+		line.push_back(static_cast<unsigned char>(c) < ' ' ? ' ' : c);
+	if (to < end) line += "…";
+
+	const size_t caret_column =
+		(from > start ? 1 : 0) +
+		count_code_points(input.substr(from, offset - from));
+
+	return line + "\n" + string(caret_column, ' ') + "^";
+}
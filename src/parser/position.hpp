@@ -0,0 +1,37 @@
+#pragma once
+
+// Resolving a position of a parsing failure in the original input.
+//
+// Nothing is tracked while parsing. The tail of a parsing error is a view into
+// the input, so the byte offset of a failure is known for free. The line and
+// the column are computed only when the failure is reported.
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include "parser/types.hpp"
+
+using namespace std;
+
+
+struct TextPosition {
+	size_t offset; // In bytes, starting from 0
+	size_t line;   // Starting from 1
+	size_t column; // In characters (UTF-8 code points), starting from 1
+};
+
+// Byte offset of a failure in the input the parser was applied to
+size_t parsing_error_offset(
+	ParserInputType<Parser> input,
+	ParsingError<ParserInputType<Parser>> err
+);
+
+// Number of “\n” characters (vectorized when SSE2 or AVX2 is available)
+size_t count_newlines(string_view input);
+
+TextPosition text_position(string_view input, size_t offset);
+
+// Two lines: the line of the input around the offset (no more than “radius”
+// bytes on either side) and a line with “^” pointing at the offset
+string text_excerpt(string_view input, size_t offset, size_t radius = 40);
@@ -27,13 +27,12 @@ function<B(ParsingResult<A, ParserInputType<F>>)> parsing_resolver(
 	return [=](ParsingResult<A, ParserInputType<F>> result) {
 		return visit(overloaded {
 			[success_resolve](ParsingSuccess<A, ParserInputType<F>> x) -> B {
-				auto [ value, _ ] = x;
-				return success_resolve(value);
+				return success_resolve(move(x.first));
 			},
 			[failure_resolve](ParsingError<ParserInputType<F>> err) -> B {
 				return failure_resolve(err);
 			}
-		}, result);
+		}, move(result));
 	};
 }
 
@@ -44,7 +43,7 @@ function<B(ParsingResult<A, ParserInputType<F>>)> parsing_resolver(
 template <typename A, typename B, template<typename>typename F>
 B parse(
 	function<B(ParsingResult<A, ParserInputType<F>>)> resolver,
-	F<A> parser,
+	const F<A>& parser,
 	ParserInputType<F> input
 )
 {
@@ -53,7 +52,7 @@ B parse(
 
 template <typename A, template<typename>typename F>
 variant<ParsingError<ParserInputType<F>>, A> parse(
-	F<A> parser,
+	const F<A>& parser,
 	ParserInputType<F> input
 )
 {
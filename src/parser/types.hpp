@@ -8,7 +8,9 @@
 
 #include <functional>
 #include <string>
+#include <string_view>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -30,7 +32,29 @@ using ParsingResult = variant<ParsingError<I>, ParsingSuccess<A, I>>;
 
 template <typename A>
 // Parser a = String → Either String (a, String)
-struct Parser: function<ParsingResult<A, string>(string)> {};
+//
+// The input is a view so that taking the tail of the input costs nothing. The
+// tail in a parsing result is a view into the original input too, so the
+// position in the input (see “parser/position.hpp”) comes for free. Mind that
+// the input must outlive the parsing result.
+//
+// Thread-safety: a parser is immutable once it is constructed. All the
+// combinators capture their sub-parsers by value (copying a “std::function”
+// is a deep copy, there are no shared reference counters) and keep all the
+// state of a single parsing run on the stack of that run. So the same parser
+// object can be called from any number of threads at the same time, there is
+// no need to build a grammar per thread (see “shared_json_value()”). The
+// combinators also avoid copying the sub-parsers while parsing, the grammar
+// is only ever copied while it is being composed.
+struct Parser: function<ParsingResult<A, string_view>(string_view)> {};
+
+
+// Type of the value of a parsing result
+template <typename R>
+struct ParsingResultValue;
+
+template <typename A, typename I>
+struct ParsingResultValue<ParsingResult<A, I>> { using type = A; };
 
 
 template <template<typename>typename F>
@@ -40,10 +64,17 @@ struct ParserInput;
 template <template<typename>typename F>
 using ParserInputType = decltype(ParserInput<F>::input_type);
 
+// Type of the value parsed by a callable returned by “monad_bind”
+// continuation “K” (see “abstractions/monad.hpp”)
+template <template<typename>typename F, typename A, typename K>
+using BoundValueType = typename ParsingResultValue<
+	invoke_result_t<invoke_result_t<K, A>, ParserInputType<F>>
+>::type;
+
 
 // Instance for “Parser”
 template <>
-struct ParserInput<Parser> { string input_type; };
+struct ParserInput<Parser> { string_view input_type; };
 
 
 // Generic type class instances-ish for all parser types {{{1
@@ -72,9 +103,9 @@ F<B> fmap(function<B(A)> map_fn, F<A> parser)
 	using I = ParserInputType<F>;
 	return F<B>{[=](I input) {
 		return visit(overloaded {
-			[=](ParsingSuccess<A, I> x) -> ParsingResult<B, I> {
-				auto [ value, tail ] = x;
-				return make_parsing_success<B, I>(map_fn(value), tail);
+			[&map_fn](ParsingSuccess<A, I> x) -> ParsingResult<B, I> {
+				auto &[ value, tail ] = x;
+				return make_parsing_success<B, I>(map_fn(move(value)), tail);
 			},
 			[](ParsingError<I> err) -> ParsingResult<B, I> { return err; },
 		}, parser(input));
@@ -96,15 +127,39 @@ F<B> apply(F<function<B(A)>> fn_parser, F<A> parser)
 	using I = ParserInputType<F>;
 	return F<B>{[=](I input) -> ParsingResult<B, I> {
 		return visit(overloaded {
-			[parser](ParsingSuccess<function<B(A)>, I> x) -> ParsingResult<B, I> {
-				auto [ fn, tail ] = x;
-				return fmap<A, B, F>(fn, parser)(tail);
+			// Not constructing an “fmap” parser here since it would copy
+			// the whole “parser” tree on every call
+			[&parser](ParsingSuccess<function<B(A)>, I> x) -> ParsingResult<B, I> {
+				auto &[ fn, tail ] = x;
+				return visit(overloaded {
+					[&fn](ParsingSuccess<A, I> y) -> ParsingResult<B, I> {
+						return make_parsing_success<B, I>(fn(move(y.first)), y.second);
+					},
+					[](ParsingError<I> err) -> ParsingResult<B, I> { return err; }
+				}, parser(tail));
 			},
 			[](ParsingError<I> err) -> ParsingResult<B, I> { return err; }
 		}, fn_parser(input));
 	}};
 }
 
+// Monad
+template <typename A, template<typename>typename F, typename K>
+F<BoundValueType<F, A, K>> monad_bind(F<A> parser, K continuation)
+{
+	using I = ParserInputType<F>;
+	using B = BoundValueType<F, A, K>;
+	return F<B>{[=](I input) {
+		return visit(overloaded {
+			[&continuation](ParsingSuccess<A, I> x) -> ParsingResult<B, I> {
+				// The callable is constructed and called right away
+				return continuation(move(x.first))(move(x.second));
+			},
+			[](ParsingError<I> err) -> ParsingResult<B, I> { return err; }
+		}, parser(input));
+	}};
+}
+
 // Alternative
 template <typename A, template<typename>typename F>
 F<A> alt(F<A> parser_a, F<A> parser_b)
@@ -112,7 +167,7 @@ F<A> alt(F<A> parser_a, F<A> parser_b)
 	using I = ParserInputType<F>;
 	return F<A>{[=](I input) {
 		return visit(overloaded {
-			[input, parser_b](ParsingError<I>) -> ParsingResult<A, I> {
+			[input, &parser_b](ParsingError<I>) -> ParsingResult<A, I> {
 				return parser_b(input);
 			},
 			[](ParsingSuccess<A, I> x) -> ParsingResult<A, I> { return x; }
@@ -130,28 +185,23 @@ F<vector<A>> some(F<A> parser)
 			[](ParsingError<I> err) -> ParsingResult<vector<A>, I> {
 				return err;
 			},
-			[parser](ParsingSuccess<A, I> first) -> ParsingResult<vector<A>, I> {
-				auto [ first_element, first_tail ] = first;
-				vector<A> list = { first_element };
-
-				using RecurResult = ParsingSuccess<vector<A>, I>;
-				using RecurFn = function<RecurResult(I)>;
-				RecurFn recur = [&recur, &list, parser](I tail) {
-					return visit(overloaded {
-						[&list, tail](ParsingError<I>) -> RecurResult {
-							return make_parsing_success<vector<A>, I>(list, tail);
-						},
-						[&list, &recur](
-							ParsingSuccess<A, I> current
-						) -> RecurResult {
-							auto [ current_element, current_tail ] = current;
-							list.push_back(current_element);
-							return recur(current_tail);
-						}
-					}, parser(tail));
-				};
-
-				return recur(first_tail);
+			[&parser](ParsingSuccess<A, I> first) -> ParsingResult<vector<A>, I> {
+				auto &[ first_element, tail ] = first;
+				vector<A> list;
+				list.push_back(move(first_element));
+
+				// A loop rather than a recursion, so that the stack does not
+				// grow with the amount of the elements
+				for (;;) {
+					auto current = parser(tail);
+					if (holds_alternative<ParsingError<I>>(current)) break;
+					auto &[ current_element, current_tail ] =
+						get<ParsingSuccess<A, I>>(current);
+					list.push_back(move(current_element));
+					tail = current_tail;
+				}
+
+				return make_parsing_success<vector<A>, I>(move(list), tail);
 			}
 		}, parser(input));
 	};
@@ -170,22 +220,17 @@ F<vector<A>> many(F<A> parser)
 	return F<vector<A>>{[=](I input) {
 		vector<A> list;
 
-		using RecurResult = ParsingSuccess<vector<A>, I>;
-		using RecurFn = function<RecurResult(I)>;
-		RecurFn recur = [&recur, &list, parser](I tail) {
-			return visit(overloaded {
-				[&list, tail](ParsingError<I>) -> RecurResult {
-					return make_parsing_success<vector<A>, I>(list, tail);
-				},
-				[&list, &recur](ParsingSuccess<A, I> current) -> RecurResult {
-					auto [ current_element, current_tail ] = current;
-					list.push_back(current_element);
-					return recur(current_tail);
-				}
-			}, parser(tail));
-		};
-
-		return recur(input);
+		// A loop rather than a recursion (see “some”)
+		for (;;) {
+			auto current = parser(input);
+			if (holds_alternative<ParsingError<I>>(current)) break;
+			auto &[ current_element, current_tail ] =
+				get<ParsingSuccess<A, I>>(current);
+			list.push_back(move(current_element));
+			input = current_tail;
+		}
+
+		return make_parsing_success<vector<A>, I>(move(list), input);
 	}};
 }
 
@@ -222,6 +267,23 @@ inline Parser<B> apply(Parser<function<B(A)>> fn_parser, Parser<A> parser)
 	return apply<A, B, Parser>(fn_parser, parser);
 }
 
+// Monad (“>>=” applies only to the types marked like this, see
+// “abstractions/monad.hpp”)
+template <template<typename>typename F>
+struct IsMonad;
+
+template <>
+struct IsMonad<Parser>: true_type {};
+
+template <typename A, typename K>
+inline Parser<BoundValueType<Parser, A, K>> monad_bind(
+	Parser<A> parser,
+	K continuation
+)
+{
+	return monad_bind<A, Parser, K>(parser, continuation);
+}
+
 // Alternative
 template <typename A>
 inline Parser<A> alt(Parser<A> parser_a, Parser<A> parser_b)
@@ -272,7 +334,7 @@ inline ParsingError<I> make_parsing_error(string message, I input)
 template <typename A, typename I>
 inline ParsingSuccess<A, I> make_parsing_success(A value, I input)
 {
-	return ParsingSuccess<A, I>{make_pair(value, input)};
+	return ParsingSuccess<A, I>{make_pair(move(value), input)};
 }
 
 template <typename A, template<typename>typename F>
@@ -286,7 +348,7 @@ F<A> map_parsing_failure(
 	using I = ParserInputType<F>;
 	return F<A>{[=](I input) {
 		return visit(overloaded {
-			[map_fn](ParsingError<I> err) -> ParsingResult<A, I> {
+			[&map_fn](ParsingError<I> err) -> ParsingResult<A, I> {
 				return map_fn(err);
 			},
 			[](ParsingSuccess<A, I> x) -> ParsingResult<A, I> { return x; }
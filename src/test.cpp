@@ -1,11 +1,18 @@
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
 #include <functional>
+#include <iomanip>
 #include <iostream>
 #include <iterator>
 #include <memory>
 #include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
 #include <variant>
 #include <vector>
 
@@ -14,13 +21,36 @@
 #include "abstractions/alternative.hpp"
 #include "abstractions/applicative.hpp"
 #include "abstractions/functor.hpp"
+#include "abstractions/monad.hpp"
 #include "abstractions/monadfail.hpp"
 
 #include "parser/parsers.hpp"
+#include "parser/position.hpp"
 #include "parser/resolvers.hpp"
 
+#include "json/cursor.hpp"
+#include "json/incremental.hpp"
+#include "json/lazy.hpp"
+#include "json/ndjson.hpp"
+#include "json/offset-index.hpp"
+#include "json/parallel.hpp"
+#include "json/parse-context.hpp"
+#include "json/pointer.hpp"
+#include "json/parsers.hpp"
+#include "json/scanners.hpp"
+#include "json/sax.hpp"
+#include "json/select.hpp"
+#include "json/serialization.hpp"
+#include "json/static-json.hpp"
+#include "json/structural-index.hpp"
+#include "json/tape.hpp"
+#include "json/transcoder.hpp"
+#include "json/utf8.hpp"
+
+#include "allocation-counter.hpp"
 #include "helpers.hpp"
 #include "test.hpp"
+#include "thread-pool.hpp"
 
 using namespace std;
 
@@ -114,6 +144,28 @@ class Test;
 void test_basic_boilerplate(shared_ptr<Test> test);
 void test_simple_parsers(shared_ptr<Test> test);
 void test_composition_of_simple_parsers(shared_ptr<Test> test);
+void test_position(shared_ptr<Test> test);
+void test_parse_context(shared_ptr<Test> test);
+void test_json_events(shared_ptr<Test> test);
+void test_json_cursor(shared_ptr<Test> test);
+void test_lazy_json(shared_ptr<Test> test);
+void test_json_transcoder(shared_ptr<Test> test);
+void test_ndjson(shared_ptr<Test> test);
+void test_incremental_json(shared_ptr<Test> test);
+void test_json_offset_index(shared_ptr<Test> test);
+void test_json_selection(shared_ptr<Test> test);
+void test_json_tape(shared_ptr<Test> test);
+void test_json_object_members(shared_ptr<Test> test);
+void test_shared_grammar(shared_ptr<Test> test);
+void test_structural_index(shared_ptr<Test> test);
+void test_parallel_parsing(shared_ptr<Test> test);
+void test_json_strings(shared_ptr<Test> test);
+void test_json_numbers(shared_ptr<Test> test);
+void test_utf8_validation(shared_ptr<Test> test);
+
+#if __cplusplus >= 202002L
+void test_static_json(shared_ptr<Test> test);
+#endif
 
 int run_test_cases()
 {
@@ -121,9 +173,39 @@ int run_test_cases()
 	test_basic_boilerplate(test);
 	test_simple_parsers(test);
 	test_composition_of_simple_parsers(test);
+	test_position(test);
+	test_parse_context(test);
+	test_json_events(test);
+	test_json_cursor(test);
+	test_lazy_json(test);
+	test_json_transcoder(test);
+	test_ndjson(test);
+	test_incremental_json(test);
+	test_json_offset_index(test);
+	test_json_selection(test);
+	test_json_tape(test);
+	test_json_object_members(test);
+	test_shared_grammar(test);
+	test_structural_index(test);
+	test_parallel_parsing(test);
+	test_json_strings(test);
+	test_json_numbers(test);
+	test_utf8_validation(test);
+#if __cplusplus >= 202002L
+	test_static_json(test);
+#endif
 	return test->resolve() ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
+// Whether “>>=” applies to “M” (with a continuation returning a parser)
+template <typename M, typename = void>
+struct HasMonadBind: false_type {};
+
+template <typename M>
+struct HasMonadBind<M, void_t<
+	decltype(declval<M>() >>= declval<function<Parser<int>(int)>>())
+>>: true_type {};
+
 template <typename A>
 inline Parser<A> simple_parsing_failure(Parser<A> parser)
 {
@@ -312,6 +394,80 @@ void test_basic_boilerplate(shared_ptr<Test> test)
 	}
 	// }}}3
 
+	// Monad {{{3
+	{
+		// Context-sensitive parsing: the parsed char is the one to repeat
+		const auto same_char_again = [](char c) {
+			return [c](I input) -> ParsingResult<string, I> {
+				if (!input.empty() && input[0] == c)
+					return make_parsing_success<string, I>(
+						string(2, c),
+						input.substr(1)
+					);
+				else
+					return make_parsing_error<I>("not the same char", input);
+			};
+		};
+
+		const Parser<string> test_fn = monad_bind(any_char(), same_char_again);
+		test->should_be<ParsingResult<string, I>>(
+			"‘monad_bind’ passes the value to the continuation",
+			test_fn("xxfoo"),
+			make_parsing_success<string, I>("xx", "foo")
+		);
+
+		const Parser<string> test_op = any_char() >>= same_char_again;
+		test->should_be<ParsingResult<string, I>>(
+			"‘>>=’ works the same way as ‘monad_bind’",
+			test_op("yyfoo"),
+			make_parsing_success<string, I>("yy", "foo")
+		);
+		test->should_be<ParsingResult<string, I>>(
+			"‘>>=’ fails when the continuation fails",
+			test_op("xyfoo"),
+			make_parsing_error<I>("not the same char", "yfoo")
+		);
+		test->should_be<ParsingResult<string, I>>(
+			"‘>>=’ fails without calling the continuation",
+			simple_parsing_failure(test_op)(""),
+			make_parsing_error<I>("failure", "")
+		);
+
+		const Parser<int> test_parser_continuation =
+			(test_pure >>= [](int x) { return pure(x + 1); })
+			>>= [](int x) { return pure(x * 2); };
+		test->should_be<ParsingResult<int, I>>(
+			"‘>>=’ accepts continuations returning parsers",
+			test_parser_continuation("foo"),
+			make_parsing_success<int, I>(248, "foo")
+		);
+
+		const Parser<int> test_no_allocations = test_pure >>= [](int x) {
+			return [x](I input) -> ParsingResult<int, I> {
+				return make_parsing_success<int, I>(x + 1, input);
+			};
+		};
+		const size_t allocations_before = allocations_counter();
+		const ParsingResult<int, I> result = test_no_allocations("foo");
+		test->should_be<size_t>(
+			"‘>>=’ does not allocate a parser when continuation is called",
+			allocations_counter() - allocations_before,
+			0
+		);
+		test->should_be<ParsingResult<int, I>>(
+			"‘>>=’ with plain callable continuation returns correct result",
+			result,
+			make_parsing_success<int, I>(124, "foo")
+		);
+		test->should_be<bool>(
+			"‘>>=’ applies only to the types with the instance",
+			HasMonadBind<Parser<int>>::value &&
+				!HasMonadBind<optional<int>>::value,
+			true
+		);
+	}
+	// }}}3
+
 	// Alternative {{{3
 	{ // “alt” {{{4
 		const Parser<int> test_two_pure = alt(pure(10), pure(20));
@@ -924,3 +1080,2203 @@ void test_composition_of_simple_parsers(shared_ptr<Test> test)
 		);
 	}
 }
+
+void test_position(shared_ptr<Test> test)
+{
+	{ // count_newlines {{{2
+		// Crossing the sizes of vector registers and the counters overflow
+		bool all_correct = true;
+		for (size_t size : {0, 1, 15, 16, 17, 31, 32, 33, 100, 10000}) {
+			string input;
+			size_t expected = 0;
+			for (size_t i = 0; i < size; ++i) {
+				const bool is_newline = i % 3 == 0 || i % 7 == 0;
+				input.push_back(is_newline ? '\n' : 'x');
+				if (is_newline) ++expected;
+			}
+			if (count_newlines(input) != expected) all_correct = false;
+		}
+		test->should_be<bool>(
+			"‘count_newlines’ counts newlines in inputs of different sizes",
+			all_correct,
+			true
+		);
+	} // }}}2
+	{ // text_position {{{2
+		const string input = "{\n  \"ключ\": x\n}";
+		const size_t offset = input.find('x');
+		const TextPosition position = text_position(input, offset);
+		test->should_be<string>(
+			"‘text_position’ resolves line and column (in characters)",
+			to_string(position.line) + ":" + to_string(position.column),
+			"2:11"
+		);
+
+		const Parser<string> parser = string_("{") >> string_("}");
+		const variant<ParsingError<I>, string> result =
+			parse<string, Parser>(parser, input);
+		test->should_be<size_t>(
+			"‘parsing_error_offset’ gives offset of the failure",
+			visit(overloaded {
+				[&input](ParsingError<I> err) {
+					return parsing_error_offset(input, err);
+				},
+				[](string) { return string::npos; }
+			}, result),
+			1
+		);
+	} // }}}2
+	{ // text_excerpt {{{2
+		test->should_be<string>(
+			"‘text_excerpt’ points at the offset",
+			text_excerpt("[1,\n\t2, x]", 8),
+			" 2, x]\n    ^"
+		);
+		test->should_be<string>(
+			"‘text_excerpt’ is bounded on long lines",
+			text_excerpt(string(1000, 'a') + "x" + string(1000, 'b'), 1000, 3),
+			"…aaaxbbb…\n    ^"
+		);
+	} // }}}2
+}
+
+void test_parse_context(shared_ptr<Test> test)
+{
+	using JsonResult = variant<ParsingError<I>, JsonValue>;
+
+	// Serialized JSON or “failure” to compare the results of different parsers
+	const auto show_result = [](JsonResult x) -> string {
+		return visit(overloaded {
+			[](ParsingError<I>) -> string { return "failure"; },
+			[](JsonValue y) -> string { return serialize_json(y); }
+		}, x);
+	};
+
+	// Some documents of the same shape but with different values
+	const auto make_document = [](size_t i) -> string {
+		ostringstream out;
+		out
+			<< "{ \"firstName\": \"John #" << i << "\", \"age\": " << i % 100
+			<< ", \"isAlive\": " << (i % 2 == 0 ? "true" : "false")
+			<< ", \"height\": " << i << ".25"
+			<< ", \"address\": { \"streetAddress\": \"" << i
+			<< " 2nd Street, some rather long description\" }"
+			<< ", \"spouse\": null, \"phoneNumbers\": [";
+		for (size_t j = 0; j < i % 4; ++j)
+			out
+				<< (j == 0 ? "" : ", ")
+				<< "{ \"type\": \"home\", \"number\": \"212 555-" << i << j
+				<< "\" }";
+		out << "] }";
+		return out.str();
+	};
+
+	{ // Same results as “parse_json” without a context {{{2
+		ParseContext ctx;
+		const vector<string> inputs = {
+			make_document(0),
+			make_document(7),
+			" [ 1 , -2.5 , +3 , \"a\\\"b\" , [ ] , { } ] ",
+			"{\"a\": 1, \"a\": 2}",
+			"[1, 2,]",
+			"[1.]",
+			"\"\"",
+			"99999999999999999999",
+			"{\"a\" 1}",
+			"[] []",
+		};
+		for (auto &input : inputs)
+			test->should_be<string>(
+				"‘parse_json’ with a context gives the same result for: " + input,
+				show_result(parse_json(ctx, input)),
+				show_result(parse_json(input))
+			);
+	} // }}}2
+
+	{ // Reusing memory {{{2
+		vector<string> documents;
+		for (size_t i = 0; i < 10000; ++i) documents.push_back(make_document(i));
+
+		ParseContext ctx;
+		const size_t warm_up = 100;
+		size_t failures = 0;
+		size_t allocations = 0;
+
+		for (size_t i = 0; i < documents.size(); ++i) {
+			const size_t allocations_before = allocations_counter();
+			JsonResult result = parse_json(ctx, documents[i]);
+			visit(overloaded {
+				[&failures](ParsingError<I> &) { ++failures; },
+				[&ctx](JsonValue &x) { ctx.recycle(move(x)); }
+			}, result);
+			if (i >= warm_up) allocations += allocations_counter() - allocations_before;
+		}
+
+		test->should_be<size_t>(
+			"‘parse_json’ with a context parses 10000 documents",
+			failures,
+			0
+		);
+		test->should_be<size_t>(
+			"‘parse_json’ with a context does not allocate after warm-up",
+			allocations,
+			0
+		);
+	} // }}}2
+}
+
+void test_json_events(shared_ptr<Test> test)
+{
+	// Writes down every event
+	class Recorder: public JsonHandler
+	{
+	public:
+		string out;
+		// Stops at this key if it is not empty
+		string stop_key;
+
+		bool on_null() override { out += "null "; return true; }
+		bool on_bool(bool x) override
+		{
+			out += x ? "true " : "false ";
+			return true;
+		}
+		bool on_number(JsonNumber &&x) override
+		{
+			out += serialize_json(JsonValue{move(x)}) + " ";
+			return true;
+		}
+		bool on_string(string_view x) override
+		{
+			out += "“" + string(x) + "” ";
+			return true;
+		}
+		bool on_array_begin() override { out += "[ "; return true; }
+		bool on_array_end() override { out += "] "; return true; }
+		bool on_object_begin() override { out += "{ "; return true; }
+		bool on_key(string_view x) override
+		{
+			out += string(x) + ": ";
+			return stop_key.empty() || x != stop_key;
+		}
+		bool on_object_end() override { out += "} "; return true; }
+	};
+
+	const auto record = [](string_view input, string stop_key = "") -> string {
+		Recorder recorder;
+		recorder.stop_key = stop_key;
+		if (auto err = parse_json_events(input, recorder))
+			recorder.out += "failure: " + err->first + " at “" +
+				string(err->second.substr(0, 6)) + "”";
+		return recorder.out;
+	};
+
+	{ // Events {{{2
+		test->should_be<string>(
+			"‘parse_json_events’ calls the handler for every token",
+			record(" {\"a\\\"\": [1, -2.5, \"x\\ny\", true, null], \"b\": {}} "),
+			"{ a\": [ 1 -2.5 “x\ny” true null ] b: { } } "
+		);
+		test->should_be<string>(
+			"‘parse_json_events’ reports the events before the malformed token",
+			record("[1, [2, }]"),
+			"[ 1 [ 2 failure: JsonValue: unexpected character at “}]”"
+		);
+		test->should_be<string>(
+			"‘parse_json_events’ stops when the handler says so",
+			record("{\"a\": 1, \"stop\": [2], \"c\": 3}", "stop"),
+			"{ a: 1 stop: failure: JsonHandler: parsing is stopped by the handler "
+				"at “\"stop\"”"
+		);
+
+		// Counting without building the document
+		class Counter: public JsonHandler
+		{
+		public:
+			size_t numbers = 0;
+			bool on_number(JsonNumber &&) override { ++numbers; return true; }
+		};
+		string input = "[";
+		for (size_t i = 0; i < 1000; ++i)
+			input += (i == 0 ? "" : ",") + string("{\"x\": [") + to_string(i) + "]}";
+		input += "]";
+		Counter counter;
+		test->should_be<size_t>(
+			"‘parse_json_events’ with the default events counts numbers",
+			parse_json_events(input, counter).has_value() ? 0 : counter.numbers,
+			1000
+		);
+	} // }}}2
+
+	{ // Validation {{{2
+		const vector<string> inputs = {
+			" {\"a\\\"\": [1, -2.5e3, \"x\\ny\\u00e9\", true, null], \"b\": {}} ",
+			"[1, 2,]",
+			"[1.5.3]",
+			"{\"a\" 1}",
+			"[\"\\uD83D\"]",
+			"[\"a\tb\"]",
+			"[\"\\q\"]",
+			"[1e999]",
+			"[] []",
+			"",
+		};
+		JsonHandler ignoring;
+		for (auto &input : inputs) {
+			const auto show = [&input](optional<ParsingError<I>> err) -> string {
+				if (!err.has_value()) return "valid";
+				return err->first + " at " +
+					to_string(input.size() - err->second.size());
+			};
+			test->should_be<string>(
+				"‘validate_json’ gives the same result as the events for: " + input,
+				show(validate_json(input)),
+				show(parse_json_events(input, ignoring))
+			);
+		}
+
+		string document = "[";
+		for (size_t i = 0; i < 100; ++i)
+			document +=
+				(i == 0 ? "" : ", ") + string("{\"key\\n") + to_string(i) +
+				"\": [\"" + string(i, 'x') + "\\u00e9\", " + to_string(i) + ".5]}";
+		document += "]";
+		const size_t allocations_before = allocations_counter();
+		const bool valid = !validate_json(document).has_value();
+		test->should_be<size_t>(
+			"‘validate_json’ does not allocate",
+			valid ? allocations_counter() - allocations_before : 1000,
+			0
+		);
+	} // }}}2
+
+	{ // JsonValueBuilder {{{2
+		const vector<string> inputs = {
+			" [ 1 , -2.5 , +3 , \"a\\\"b\" , [ ] , { } ] ",
+			"{\"a\": 1, \"a\": 2, \"b\": {\"c\": [null, false]}}",
+			"[1, 2,]",
+			"{\"a\": [1, {\"b\": }]}",
+		};
+		for (auto &input : inputs) {
+			ParseContext ctx;
+			JsonValueBuilder builder(ctx);
+			string result =
+				parse_json_events(input, builder).has_value()
+					? "failure"
+					: serialize_json(builder.take_result());
+			test->should_be<string>(
+				"‘JsonValueBuilder’ builds the same document for: " + input,
+				result,
+				visit(overloaded {
+					[](ParsingError<I>) -> string { return "failure"; },
+					[](JsonValue x) -> string { return serialize_json(x); }
+				}, parse_json(input))
+			);
+		}
+	} // }}}2
+
+	{ // Deep nesting {{{2
+		const size_t depth = 1000000;
+		const string arrays = string(depth, '[') + string(depth, ']');
+		string objects;
+		for (size_t i = 0; i < depth; ++i) objects += "{\"a\":";
+		objects += "null" + string(depth, '}');
+
+		test->should_be<bool>(
+			"‘validate_json’ takes 1M levels of nesting",
+			validate_json(arrays).has_value() || validate_json(objects).has_value(),
+			false
+		);
+
+		// How deep the document is (going down the first elements and keys)
+		const auto show_depth = [](const JsonValue &x) -> size_t {
+			size_t n = 0;
+			for (const JsonValue *y = &x; y != nullptr; ++n) {
+				if (auto list = get_if<JsonArray>(y))
+					y = get<0>(*list).empty() ? nullptr : &get<0>(*list)[0];
+				else if (auto entries = get_if<JsonObject>(y))
+					y = &get<0>(*entries).begin()->second;
+				else
+					y = nullptr;
+			}
+			return n;
+		};
+
+		ParseContext ctx;
+		variant<ParsingError<I>, JsonValue> x = parse_json(ctx, arrays);
+		variant<ParsingError<I>, JsonValue> y = parse_json(ctx, objects);
+		test->should_be<string>(
+			"‘parse_json’ with a context takes 1M levels of nesting",
+			to_string(show_depth(get<JsonValue>(x))) + " " +
+				to_string(show_depth(get<JsonValue>(y))),
+			"1000000 1000001"
+		);
+		test->should_be<bool>(
+			"‘serialize_json’ takes 1M levels of nesting",
+			serialize_json(get<JsonValue>(x)) == arrays &&
+				serialize_json(get<JsonValue>(y)) == objects,
+			true
+		);
+		// Neither of these recurses
+		ctx.recycle(move(get<JsonValue>(x)));
+		y = JsonValue{};
+
+		JsonParsingOptions options;
+		options.max_depth = 3;
+		const auto show_error = [](optional<ParsingError<I>> err) -> string {
+			if (!err.has_value()) return "success";
+			return err->first + " at “" + string(err->second) + "”";
+		};
+		test->should_be<string>(
+			"‘max_depth’ option limits the nesting",
+			show_error(validate_json("[{\"a\": [1]}]", options)) + "; " +
+				show_error(validate_json("[{\"a\": [[]]}]", options)),
+			"success; JsonValue: nesting is too deep at “[]]}]”"
+		);
+
+		// The recursive engines build the values nested too deep for them
+		// on the heap
+		variant<ParsingError<I>, JsonValue> z = parse_json(arrays);
+		variant<ParsingError<I>, JsonValue> w = parse_json_structural(objects);
+		test->should_be<string>(
+			"The recursive engines take 1M levels of nesting",
+			to_string(show_depth(get<JsonValue>(z))) + " " +
+				to_string(show_depth(get<JsonValue>(w))),
+			"1000000 1000001"
+		);
+
+		const string deep = string(1000, '[') + "1" + string(1000, ']');
+		const string mixed = "[" + deep + ",{\"a\":" + deep + "},2]";
+		const auto show_result = [](variant<ParsingError<I>, JsonValue> x) {
+			if (holds_alternative<ParsingError<I>>(x))
+				return get<ParsingError<I>>(x).first;
+			return serialize_json(get<JsonValue>(x));
+		};
+		test->should_be<string>(
+			"The recursive engines go on after a value nested too deep",
+			show_result(parse_json(mixed)) + "; " +
+				show_result(parse_json_structural(mixed)),
+			mixed + "; " + mixed
+		);
+
+		// The combinators report the failure inside an array or an object
+		// as the failure of that array or object
+		const bool is_too_deep = holds_alternative<ParsingError<I>>(
+			parse_json("[{\"a\": [[]]}]", options)
+		);
+		test->should_be<string>(
+			"The recursive engines take ‘max_depth’ option into account",
+			show_result(parse_json_structural("[{\"a\": [[]]}]", options)) +
+				"; " + show_result(parse_json("[[]]", options)) +
+				"; " + (is_too_deep ? "failure" : "success"),
+			"JsonValue: nesting is too deep; [[]]; failure"
+		);
+	} // }}}2
+}
+
+void test_json_cursor(shared_ptr<Test> test)
+{
+	const string document =
+		"{\"name\": \"a\\\"b\", \"skipped\": [\"]}\\\\\", {\"x\": [[]]}, 1e5],\n"
+		" \"list\": [1, -2, 3.5, true, null, \"x\"],"
+		" \"nested\": {\"c\": {\"d\": 42}, \"e\": false}, \"last\": null}";
+
+	const auto show_error = [](const JsonCursor &cursor) -> string {
+		auto err = cursor.error();
+		if (!err.has_value()) return "no error";
+		return err->first + " at “" + string(err->second.substr(0, 6)) + "”";
+	};
+
+	{ // Reading values {{{2
+		JsonCursor cursor(document);
+		string_view name;
+		test->should_be<bool>(
+			"‘JsonCursor’ reads a string with escapes",
+			cursor.enter_object() && cursor.find_key("name") &&
+				cursor.get_string(name) && name == "a\"b",
+			true
+		);
+
+		string out;
+		int64_t i;
+		double d;
+		bool b;
+		string_view s;
+		test->should_be<bool>(
+			"‘JsonCursor’ skips values up to the key",
+			cursor.find_key("list") && cursor.enter_array(),
+			true
+		);
+		while (cursor.next_element())
+			switch (cursor.peek()) {
+				case JsonValueKind::Number:
+					if (cursor.get_int64(i)) out += to_string(i) + " ";
+					break;
+				case JsonValueKind::Bool:
+					if (cursor.get_bool(b)) out += b ? "true " : "false ";
+					break;
+				case JsonValueKind::Null:
+					if (cursor.get_null()) out += "null ";
+					break;
+				default:
+					cursor.skip();
+			}
+		test->should_be<string>(
+			"‘JsonCursor’ fails on a number that is not an integer",
+			out + show_error(cursor),
+			"1 -2 JsonCursor: “int64_t” number is expected at “3.5, t”"
+		);
+
+		JsonCursor other(document);
+		test->should_be<bool>(
+			"‘JsonCursor’ finds the keys in any order",
+			other.enter_object() &&
+				other.find_key("nested") && other.enter_object() &&
+				other.find_key("e") && other.get_bool(b) && !b &&
+				other.find_key("c") && other.enter_object() &&
+				other.find_key("d") && other.get_double(d) && d == 42 &&
+				other.leave() &&
+				!other.find_key("d") &&
+				other.leave() &&
+				other.find_key("skipped") && other.enter_array() &&
+				other.next_element() && other.get_string(s) && s == "]}\\" &&
+				other.leave() &&
+				other.finish(),
+			true
+		);
+		test->should_be<string>(
+			"‘JsonCursor’ has no error after all of that",
+			show_error(other),
+			"no error"
+		);
+	} // }}}2
+
+	{ // Keys {{{2
+		JsonCursor cursor(document);
+		string keys;
+		string_view key;
+		cursor.enter_object();
+		while (cursor.next_key(key)) keys += string(key) + " ";
+		test->should_be<string>(
+			"‘JsonCursor’ goes through the keys",
+			keys + show_error(cursor) + (cursor.finish() ? "" : " not finished"),
+			"name skipped list nested last no error"
+		);
+	} // }}}2
+
+	{ // Failures {{{2
+		const auto read = [&show_error](string input) -> string {
+			JsonCursor cursor(input);
+			string_view key;
+			cursor.enter_object();
+			while (cursor.next_key(key)) cursor.skip();
+			cursor.finish();
+			return show_error(cursor);
+		};
+		test->should_be<string>(
+			"‘JsonCursor’ fails on a missing comma",
+			read("{\"a\": 1 \"b\": 2}"),
+			"JsonObject: “}” is expected at “\"b\": 2”"
+		);
+		test->should_be<string>(
+			"‘JsonCursor’ fails on an unterminated string in a skipped value",
+			read("{\"a\": [\"]}]}"),
+			"JsonString: closing quote is expected at “”"
+		);
+		test->should_be<string>(
+			"‘JsonCursor’ fails on an unterminated array in a skipped value",
+			read("{\"a\": [[1, 2]"),
+			"JsonValue: closing bracket is expected at “”"
+		);
+		test->should_be<string>(
+			"‘JsonCursor’ fails on trailing input",
+			read("{} []"),
+			"end_of_input: input is not empty at “[]”"
+		);
+		test->should_be<string>(
+			"‘JsonCursor’ fails on misuse",
+			[]() {
+				JsonCursor cursor("[1]");
+				string_view key;
+				cursor.enter_array();
+				cursor.next_key(key);
+				return cursor.error()->first;
+			}(),
+			"JsonCursor: the cursor is not in an object"
+		);
+	} // }}}2
+}
+
+void test_lazy_json(shared_ptr<Test> test)
+{
+	using LazyResult = variant<ParsingError<I>, LazyJsonValue>;
+
+	// Serialized value or the error with the beginning of its tail
+	const auto show = [](variant<ParsingError<I>, JsonValue> x) -> string {
+		return visit(overloaded {
+			[](ParsingError<I> err) -> string {
+				return err.first + " at “" + string(err.second.substr(0, 5)) + "”";
+			},
+			[](JsonValue y) -> string { return serialize_json(y); }
+		}, x);
+	};
+	// Walks the keys (“/” to go into the value) and shows what is there
+	const auto show_path = [&show](LazyResult x, vector<string> path) -> string {
+		for (auto &key : path) {
+			if (holds_alternative<ParsingError<I>>(x)) break;
+			x = in_key(key, get<LazyJsonValue>(x));
+		}
+		if (auto err = get_if<ParsingError<I>>(&x)) return show(*err);
+		return show(to_json_value(get<LazyJsonValue>(x)));
+	};
+
+	const string document =
+		"{\"id\": 7, \"items\": [{\"a\": [1, \"]}\"]}, 2, {}],"
+		" \"route\": {\"from\": \"A\", \"to\": \"B\\n\"}, \"bad\": [1 2],"
+		" \"id\": 8}";
+	const LazyResult root = parse_json_lazy(document);
+
+	{ // Accessing {{{2
+		test->should_be<string>(
+			"‘in_key’ finds a value of a lazy object",
+			show_path(root, {"route", "to"}),
+			"\"B\\n\""
+		);
+		test->should_be<string>(
+			"‘in_key’ gives the first of the duplicate keys",
+			show_path(root, {"id"}),
+			"7"
+		);
+		test->should_be<string>(
+			"‘to_json_value’ parses a lazy array completely",
+			show_path(root, {"items"}),
+			"[{\"a\":[1,\"]}\"]},2,{}]"
+		);
+		test->should_be<string>(
+			"‘in_key’ fails on a missing key",
+			show_path(root, {"route", "via"}),
+			"Key \"via\" is not found at “{\"fro”"
+		);
+
+		string kinds;
+		auto items = from_json_array(get<LazyJsonValue>(in_key(
+			"items",
+			get<LazyJsonValue>(root)
+		)));
+		for (auto &x : get<vector<LazyJsonValue>>(items))
+			kinds += x.kind() == JsonValueKind::Object ? "object " : "other ";
+		test->should_be<string>(
+			"‘from_json_array’ gives the elements of a lazy array",
+			kinds,
+			"object other object "
+		);
+		string keys;
+		auto entries = from_json_object(get<LazyJsonValue>(root));
+		for (auto &[ key, value ] : get<1>(entries))
+			keys += key + (value.kind() == JsonValueKind::Number ? "=n " : " ");
+		test->should_be<string>(
+			"‘from_json_object’ gives the entries of a lazy object in order",
+			keys,
+			"id=n items route bad "
+		);
+	} // }}}2
+
+	{ // Failures {{{2
+		test->should_be<string>(
+			"A malformed lazy array is reported only when it is accessed",
+			show_path(root, {"bad"}) + "; " +
+				visit(overloaded {
+					[](ParsingError<I> err) -> string { return err.first; },
+					[](vector<LazyJsonValue>) -> string { return "success"; }
+				}, from_json_array(get<LazyJsonValue>(in_key(
+					"bad",
+					get<LazyJsonValue>(root)
+				)))),
+			"JsonArray: “]” is expected at “2], \"”; JsonArray: “]” is expected"
+		);
+		test->should_be<string>(
+			"‘in_key’ fails on a lazy array",
+			show_path(root, {"items", "a"}),
+			"LazyJsonValue: object is expected at “[{\"a\"”"
+		);
+
+		// Even the end of the document is checked only on the access
+		const auto show_error = [](auto x) -> string {
+			if (auto err = get_if<ParsingError<I>>(&x))
+				return err->first + " at “" + string(err->second) + "”";
+			return "success";
+		};
+		test->should_be<string>(
+			"A lazy array fails on unbalanced brackets",
+			show_error(from_json_array(
+				get<LazyJsonValue>(parse_json_lazy("[[1, {}] "))
+			)),
+			"JsonArray: “]” is expected at “ ”"
+		);
+		test->should_be<string>(
+			"A lazy object fails on trailing input",
+			show_error(from_json_object(
+				get<LazyJsonValue>(parse_json_lazy(" {} {}"))
+			)),
+			"end_of_input: input is not empty at “{}”"
+		);
+		test->should_be<string>(
+			"A lazy number fails on trailing input",
+			show_path(parse_json_lazy("12 3 "), {}),
+			"end_of_input: input is not empty at “3 ”"
+		);
+	} // }}}2
+}
+
+void test_json_transcoder(shared_ptr<Test> test)
+{
+	// Output of the transcoder fed with pieces of “chunk_size” bytes, or its
+	// failure with the byte offset
+	const auto transcode = [](
+		string_view input,
+		size_t chunk_size,
+		string line_break = "",
+		string block_indent = "",
+		JsonParsingOptions options = {}
+	) -> string {
+		ostringstream out;
+		JsonTranscoder transcoder(out, line_break, block_indent, options);
+		bool ok = true;
+		for (size_t i = 0; ok && i < input.size(); i += chunk_size)
+			ok = transcoder.feed(input.substr(i, chunk_size));
+		if (ok && transcoder.finish()) return out.str();
+		return
+			string(transcoder.error()) + " at " +
+			to_string(transcoder.error_offset());
+	};
+
+	{ // Same as the serialization {{{2
+		const vector<string> inputs = {
+			"{\"a\": [1, -2.5e3, \"x\\\"\\n\\u0001é\\/\", null],"
+				" \"b\": {\"c\": true, \"d\": []}, \"e\": {}}",
+			" [ [[], {}], [false, -7, 12345678901234567890, 0.1, 1E2] ] ",
+			"\"a\\u00e9\\ud83d\\ude00\"",
+			"  -0.5e-3\n",
+			"null",
+			"[]",
+		};
+
+		JsonParsingOptions lazy;
+		lazy.lazy_numbers = true;
+
+		for (size_t i = 0; i < inputs.size(); ++i) {
+			const JsonValue x = get<JsonValue>(parse_json(inputs[i]));
+			const JsonValue lazy_x = get<JsonValue>(parse_json(inputs[i], lazy));
+			bool same = true;
+			for (size_t chunk_size : {inputs[i].size(), size_t(1), size_t(3)})
+				same = same &&
+					transcode(inputs[i], chunk_size) == serialize_json(x) &&
+					transcode(inputs[i], chunk_size, "\n", "  ") ==
+						serialize_json(x, "\n", "  ") &&
+					transcode(inputs[i], chunk_size, "", "", lazy) ==
+						serialize_json(lazy_x);
+			test->should_be<bool>(
+				"‘JsonTranscoder’ writes the same as ‘serialize_json’ (input #" +
+					to_string(i) + ")",
+				same,
+				true
+			);
+		}
+	} // }}}2
+
+	{ // Streaming {{{2
+		test->should_be<string>(
+			"‘JsonTranscoder’ keeps the order of the keys and duplicate keys",
+			transcode("{\"b\": 1, \"a\": {\"d\": 2, \"c\": 3}, \"b\": 4}", 5),
+			"{\"b\":1,\"a\":{\"d\":2,\"c\":3},\"b\":4}"
+		);
+
+		ostringstream out;
+		JsonTranscoder transcoder(out);
+		string steps;
+		for (string_view x : {"[1, 2", "3, \"a", "bc\"", " ]"}) {
+			transcoder.feed(x);
+			steps += out.str() + "; ";
+		}
+		transcoder.finish();
+		test->should_be<string>(
+			"‘JsonTranscoder’ writes every complete token right away",
+			steps + out.str(),
+			"[1; [1,23; [1,23; [1,23,\"abc\"]; [1,23,\"abc\"]"
+		);
+
+		// Only the sizes of the writes are kept
+		struct WriteSizes: streambuf
+		{
+			size_t total = 0, biggest = 0;
+			streamsize xsputn(const char *, streamsize n) override
+			{
+				total += size_t(n);
+				biggest = max(biggest, size_t(n));
+				return n;
+			}
+		};
+		// The pretty output of it is a few MiB
+		const string nested = string(2000, '[') + "1" + string(2000, ']');
+		WriteSizes sizes;
+		ostream sink(&sizes);
+		JsonTranscoder pretty(sink, "\n", " ");
+		const bool pretty_ok = pretty.feed(nested) && pretty.finish();
+		test->should_be<string>(
+			"‘JsonTranscoder’ writes a single big piece in bounded parts",
+			to_string(pretty_ok) + " " +
+				to_string(sizes.total > 10 * 64 * 1024) + " " +
+				to_string(sizes.biggest < 2 * 64 * 1024),
+			"1 1 1"
+		);
+
+		const string deep = string(1000000, '[') + string(1000000, ']');
+		test->should_be<bool>(
+			"‘JsonTranscoder’ takes any depth",
+			transcode(deep, 64 * 1024) == deep,
+			true
+		);
+	} // }}}2
+
+	{ // Failures {{{2
+		const vector<string> inputs = {
+			"", "  ", "[1, 2,]", "{\"a\" 1}", "{\"a\": 1,}", "[1 2]", "[1, 2",
+			"{", "[", "{\"a\":", "{\"a\"", "[1,", "\"abc", "tru", "[nulx]",
+			"[1] 2", "{\"a\": 1}}", "[-]", "\"a\\x\"", "[1.]", "{1: 2}", "}",
+			"[\"a\nb\"]", "{\"a\": [1, {\"b\": [tru]}]}",
+		};
+
+		// The message and the offset as with the other engines
+		const auto validate = [](string_view input) -> string {
+			auto err = validate_json(input);
+			if (!err.has_value()) return "success";
+			return
+				err->first + " at " + to_string(input.size() - err->second.size());
+		};
+
+		for (auto &input : inputs) {
+			bool same = true;
+			for (size_t chunk_size : {size_t(1), size_t(2), size_t(100)})
+				same = same && transcode(input, chunk_size) == validate(input);
+			test->should_be<bool>(
+				"‘JsonTranscoder’ fails like ‘validate_json’ on " + input,
+				same,
+				true
+			);
+		}
+	} // }}}2
+}
+
+void test_ndjson(shared_ptr<Test> test)
+{
+	// Records are compact serialized documents (or failures with the first
+	// characters of the tail)
+	const NdjsonProcessor::Transform transform =
+		[](string_view record, string &out) -> optional<string> {
+			auto x = parse_json_structural(record);
+			if (auto err = get_if<ParsingError<I>>(&x))
+				return
+					err->first + " at “" + string(err->second.substr(0, 3)) + "”";
+			out += serialize_json(get<JsonValue>(x)) + "\n";
+			return nullopt;
+		};
+
+	// The outputs, then the failures, then the counts
+	const auto process = [&transform](
+		ThreadPool &pool,
+		string_view input,
+		size_t chunk_size,
+		size_t batch_size
+	) -> string {
+		ostringstream out, failures;
+		NdjsonProcessor processor(pool, transform, out, failures, batch_size);
+		for (size_t i = 0; i < input.size(); i += chunk_size)
+			processor.feed(input.substr(i, chunk_size));
+		processor.finish();
+		return
+			out.str() + failures.str() +
+			to_string(processor.records_count()) + " records, " +
+			to_string(processor.failures_count()) + " failures";
+	};
+
+	ThreadPool pool(4);
+
+	test->should_be<string>(
+		"‘NdjsonProcessor’ reports the failures with the line numbers",
+		process(pool, "[1, 2]\n\n {\"a\":\"x\"}\r\n[1,]\n  \n\"end\"", 1, 1),
+		"[1,2]\n{\"a\":\"x\"}\n\"end\"\n"
+		"Line 4: JsonValue: unexpected character at “]”\n"
+		"4 records, 1 failures"
+	);
+
+	{
+		string input, expected;
+		for (size_t i = 0; i < 2000; ++i) {
+			const string items = "[\"" + string(i % 50, 'x') + "\"]";
+			input += "{\"n\": " + to_string(i) + ", \"s\": " + items + "}\n";
+			expected += "{\"n\":" + to_string(i) + ",\"s\":" + items + "}\n";
+		}
+		expected += "2000 records, 0 failures";
+
+		// From a batch for every line to a single batch
+		const vector<size_t> batch_sizes = {1, 100, 4096, 1 << 20};
+		const vector<size_t> chunk_sizes = {7, 1000, input.size()};
+		bool same = true;
+		for (size_t batch_size : batch_sizes)
+			for (size_t chunk_size : chunk_sizes)
+				same = same &&
+					process(pool, input, chunk_size, batch_size) == expected;
+		test->should_be<bool>(
+			"‘NdjsonProcessor’ writes the records in the order of the input",
+			same,
+			true
+		);
+	}
+}
+
+void test_incremental_json(shared_ptr<Test> test)
+{
+	// Kinds and positions of all the values (the absolute ones)
+	const function<string(const IncrementalJsonNode&, size_t)> show_tree =
+		[&show_tree](const IncrementalJsonNode &x, size_t begin) -> string {
+			string out = x.key.empty() ? "" : x.key + ":";
+			out += to_string(begin) + "+" + to_string(x.length);
+			if (!x.children.empty()) {
+				out += "(";
+				for (auto &y : x.children)
+					out += (&y == &x.children[0] ? "" : " ") +
+						show_tree(y, begin + y.offset);
+				out += ")";
+			}
+			return out;
+		};
+	const auto show = [&show_tree](const IncrementalJsonDocument &x) -> string {
+		return show_tree(x.root(), x.root().offset);
+	};
+
+	{ // Edits {{{2
+		IncrementalJsonDocument document(
+			"{\"a\": [1, 22, {\"b\": null}], \"c\": \"x\"}"
+		);
+		test->should_be<string>(
+			"‘IncrementalJsonDocument’ finds the positions of all the values",
+			show(document),
+			"0+37(a:6+20(7+1 10+2 14+11(b:20+4)) c:33+3)"
+		);
+
+		// “22” becomes “333”: only the number is parsed again (with the “,”
+		// and the spaces around it) and the values after it move
+		document.edit(10, 2, "333");
+		test->should_be<string>(
+			"‘IncrementalJsonDocument’ re-parses only the edited value",
+			show(document) + " " + to_string(document.reparsed_size()),
+			"0+38(a:6+21(7+1 10+3 15+11(b:21+4)) c:34+3) 7"
+		);
+
+		// Two more members of the array
+		document.edit(9, 0, " true, [],");
+		test->should_be<string>(
+			"‘IncrementalJsonDocument’ splices new values in",
+			show(document) + " " + string(document.text()),
+			"0+48(a:6+31(7+1 10+4 16+2 20+3 25+11(b:31+4)) c:44+3) "
+			"{\"a\": [1, true, [], 333, {\"b\": null}], \"c\": \"x\"}"
+		);
+
+		// A new key is spliced into the nested object, the key “a” is replaced
+		document.edit(34, 0, ", \"d\": -1.5");
+		document.edit(1, 3, "\"e\"");
+		const string text(document.text());
+		test->should_be<string>(
+			"‘IncrementalJsonDocument’ builds the same tree as a full parsing",
+			show(document),
+			show(IncrementalJsonDocument(text))
+		);
+		test->should_be<string>(
+			"‘IncrementalJsonDocument’ builds the same document as ‘parse_json’",
+			serialize_json(document.to_json_value()),
+			serialize_json(get<JsonValue>(parse_json(text)))
+		);
+	} // }}}2
+
+	{ // Failures {{{2
+		IncrementalJsonDocument document("[1, [2, 3], 4]");
+		const auto show_edit = [&document](
+			size_t offset,
+			size_t deleted,
+			string_view inserted
+		) -> string {
+			if (document.edit(offset, deleted, inserted))
+				return string(document.text());
+			return string(document.error()) + " at " +
+				to_string(document.error_offset()) + " of " +
+				string(document.text());
+		};
+
+		// One edit at a time (the order of the operands of “+” is unspecified)
+		vector<string> results;
+		for (auto [offset, deleted, inserted] : {
+			tuple<size_t, size_t, string>{9, 1, ""},
+			{5, 0, ","},
+			{12, 1, "5"},
+			{1, 1, "tru"},
+			{15, 0, "x"},
+		})
+			results.push_back(show_edit(offset, deleted, inserted));
+
+		test->should_be<string>(
+			"‘IncrementalJsonDocument’ rejects an edit that breaks the text",
+			results[0] + "; " + results[1] + "; " + results[2],
+			"JsonArray: “]” is expected at 13 of [1, [2, 3], 4]; "
+			"JsonValue: unexpected character at 5 of [1, [2, 3], 4]; "
+			"[1, [2, 3], 5]"
+		);
+		test->should_be<string>(
+			"‘IncrementalJsonDocument’ reports the failure like ‘validate_json’",
+			results[3] + "; " + results[4],
+			"JsonValue: unexpected literal at 1 of [1, [2, 3], 5]; "
+			"IncrementalJsonDocument: edit is out of the text at 14 of "
+			"[1, [2, 3], 5]"
+		);
+
+		IncrementalJsonDocument broken("[1, 2");
+		const bool was_broken = broken.root().kind == JsonValueKind::None;
+		const bool fixed = broken.edit(5, 0, "]");
+		test->should_be<string>(
+			"‘IncrementalJsonDocument’ accepts an edit that fixes the text",
+			to_string(was_broken) + " " + to_string(fixed) + " " + show(broken),
+			"1 1 0+6(1+1 4+1)"
+		);
+	} // }}}2
+
+	{ // Big document {{{2
+		string text = "[";
+		for (size_t i = 0; i < 10000; ++i)
+			text += (i == 0 ? "" : ", ") + string("{\"n\": [") + to_string(i) + "]}";
+		text += "]";
+		IncrementalJsonDocument document(text);
+
+		bool local = true;
+		for (size_t i = 0; i < 100; ++i) {
+			const size_t pos = document.text().find(
+				"[" + to_string(i * 97) + "]"
+			) + 1;
+			const string number = to_string(i * 97);
+			local =
+				document.edit(pos, number.size(), "-" + number + ".5") &&
+				document.reparsed_size() == number.size() + 3 &&
+				local;
+		}
+		test->should_be<bool>(
+			"‘IncrementalJsonDocument’ parses only the edited values of a big "
+				"document",
+			local,
+			true
+		);
+		test->should_be<string>(
+			"‘IncrementalJsonDocument’ builds the same tree as a full parsing of "
+				"a big document",
+			show(document),
+			show(IncrementalJsonDocument(string(document.text())))
+		);
+	} // }}}2
+}
+
+void test_json_offset_index(shared_ptr<Test> test)
+{
+	const string input =
+		"{\"a\": [1, {\"b\": \"x\", \"c/d\": [true, null]}, -2.5],"
+		" \"e~f\": {}, \"a\": 3, \"\\u0067\": \"y\"}";
+
+	// Every array and object gets into the index or only the root one
+	vector<string> indices;
+	for (size_t min_container_size : {0, 4096}) {
+		ostringstream out;
+		const auto err = write_json_offset_index(input, out, min_container_size);
+		indices.push_back(err.has_value() ? "" : out.str());
+	}
+
+	const auto show = [&input](
+		const string &index,
+		string_view pointer
+	) -> string {
+		auto x = find_json_value(input, index, pointer);
+		if (auto err = get_if<ParsingError<I>>(&x))
+			return err->first + " at " +
+				to_string(parsing_error_offset(string_view(input), *err));
+		return string(get<string_view>(x));
+	};
+
+	for (auto &index : indices) {
+		const string suffix =
+			&index == &indices[0] ? " (full index)" : " (small index)";
+
+		vector<string> values;
+		for (string_view x : {"/a/1/b", "/a/2", "/a/1/c~1d/1", "/e~0f", "/g"})
+			values.push_back(show(index, x));
+		test->should_be<string>(
+			"‘find_json_value’ finds a value by a JSON Pointer" + suffix,
+			values[0] + " " + values[1] + " " + values[2] + " " + values[3] +
+				" " + values[4],
+			"\"x\" -2.5 null {} \"y\""
+		);
+		test->should_be<string>(
+			"‘find_json_value’ finds the root value and the first same key" +
+				suffix,
+			to_string(show(index, "") == input) + " " + show(index, "/a/0"),
+			"1 1"
+		);
+
+		values.clear();
+		for (string_view x : {"/x", "/a/3", "/a/01", "/a/-", "/a/0/b"})
+			values.push_back(show(index, x));
+		test->should_be<string>(
+			"‘find_json_value’ fails when there is no value" + suffix,
+			values[0] + "; " + values[1] + "; " + values[2] + "; " + values[3] +
+				"; " + values[4],
+			"Key \"x\" is not found at 0; "
+			"Element \"3\" is not found at 6; "
+			"Element \"01\" is not found at 6; "
+			"Element \"-\" is not found at 6; "
+			"JsonOffsetIndex: array or object is expected at 7"
+		);
+	}
+
+	vector<string> failures;
+	for (string_view x : {"a", "/a/~2"})
+		failures.push_back(show(indices[1], x));
+	test->should_be<string>(
+		"‘find_json_value’ rejects a malformed JSON Pointer",
+		failures[0] + "; " + failures[1],
+		"JsonPointer: pointer must start with “/” at 0; "
+		"JsonPointer: “~” must be followed by “0” or “1” at 0"
+	);
+
+	ostringstream other;
+	write_json_offset_index(string_view("[1, 2]"), other);
+	const auto mismatch = find_json_value(input, other.str(), "/a");
+	test->should_be<string>(
+		"‘find_json_value’ rejects an index of another document",
+		holds_alternative<ParsingError<I>>(mismatch)
+			? get<ParsingError<I>>(mismatch).first
+			: "",
+		"JsonOffsetIndex: index does not match the input"
+	);
+
+	ostringstream out;
+	const auto err = write_json_offset_index(string_view("[1, {]"), out);
+	test->should_be<string>(
+		"‘write_json_offset_index’ rejects malformed JSON like ‘validate_json’",
+		(err.has_value() ? err->first : "") + " " + to_string(out.str().size()),
+		string(validate_json(string_view("[1, {]"))->first) + " 0"
+	);
+
+	{ // Big document {{{2
+		string text = "{\"items\": [";
+		for (size_t i = 0; i < 10000; ++i)
+			text +=
+				(i == 0 ? "" : ", ") + string("{\"n\": ") + to_string(i) + "}";
+		text += "]}";
+		ostringstream index;
+		write_json_offset_index(text, index, 256);
+
+		bool found = true;
+		for (size_t i = 0; i < 10000; i += 7) {
+			auto x = find_json_value(
+				text,
+				index.str(),
+				"/items/" + to_string(i) + "/n"
+			);
+			found =
+				found &&
+				holds_alternative<string_view>(x) &&
+				get<string_view>(x) == to_string(i);
+		}
+		test->should_be<bool>(
+			"‘find_json_value’ finds the elements of a big array",
+			found,
+			true
+		);
+	} // }}}2
+}
+
+void test_json_selection(shared_ptr<Test> test)
+{
+	const string input =
+		"{\"a\": [{\"b\": 1, \"c\": \"x\"}, {\"b\": [2, 3]}, 4],"
+		" \"d~/\": {\"e\": null}, \"a\": 5}";
+
+	// Values of every path separated by “;”
+	const auto show = [](
+		string_view input,
+		const vector<string> &pointers
+	) -> string {
+		vector<vector<string>> paths;
+		for (auto &x : pointers) {
+			paths.emplace_back();
+			if (const char *err = split_json_pointer(x, paths.back()))
+				return err;
+		}
+
+		auto x = select_json(input, paths);
+		if (auto err = get_if<ParsingError<I>>(&x))
+			return err->first + " at " +
+				to_string(parsing_error_offset(input, *err));
+
+		string out;
+		for (auto &values : get<vector<vector<string_view>>>(x)) {
+			if (&values != &get<vector<vector<string_view>>>(x)[0]) out += "; ";
+			for (auto &y : values)
+				out += (&y == &values[0] ? "" : " ") + string(y);
+		}
+		return out;
+	};
+
+	test->should_be<string>(
+		"‘select_json’ selects values by JSON Pointers",
+		show(input, {"/a/0/c", "/d~0~1/e", "/a/2", "/a/1/b/1"}),
+		"\"x\"; null; 4; 3"
+	);
+	test->should_be<string>(
+		"‘select_json’ matches every key and element with “*”",
+		show(input, {"/a/*/b", "/*", "/a/*/b/*"}),
+		"1 [2, 3]; "
+		"[{\"b\": 1, \"c\": \"x\"}, {\"b\": [2, 3]}, 4] {\"e\": null} 5; "
+		"2 3"
+	);
+	test->should_be<string>(
+		"‘select_json’ selects a value and the values inside of it",
+		show(input, {"/a/1", "/a/1/b/0", ""}),
+		"{\"b\": [2, 3]}; 2; " + input
+	);
+	test->should_be<string>(
+		"‘select_json’ selects nothing when there is no value",
+		show(input, {"/x", "/a/3", "/a/01", "/a/0/b/c", "/a/-"}),
+		"; ; ; ; "
+	);
+
+	// “/0” is found before the malformed value (the rest is not read)
+	vector<string> results;
+	for (string_view x : {
+		"[[1, 2], [3, 4, [}]",
+		"[[1, 2], [3, 4, [}]",
+		"[1, \"x]",
+		"{\"a\": 1 \"b\": 2}",
+	})
+		results.push_back(show(x, {results.size() == 0 ? "/0" : "/*/0"}));
+	test->should_be<string>(
+		"‘select_json’ stops when everything is found",
+		results[0],
+		"[1, 2]"
+	);
+	test->should_be<string>(
+		"‘select_json’ fails on malformed input it walks through",
+		results[1] + "; " + results[2] + "; " + results[3],
+		"JsonArray: “]” is expected at 19; "
+		"JsonString: closing quote is expected at 7; "
+		"JsonObject: “}” is expected at 8"
+	);
+
+	test->should_be<string>(
+		"‘select_json’ fails on anything after the root value it selects",
+		show("[\n]]", {""}) + "; " +
+			show("12345678901234567890]1234567890", {"", "/0"}) + "; " +
+			show(" [1] \n", {"", "/0"}),
+		"end_of_input: input is not empty at 3; "
+		"end_of_input: input is not empty at 20; "
+		"[1]; 1"
+	);
+}
+
+void test_json_tape(shared_ptr<Test> test)
+{
+	const string input =
+		"{\"b\": [1, -2.5, 18446744073709551615, \"x\\ny\"],"
+		" \"a\": {\"c\": true, \"d\": null}, \"b\": false}";
+	const JsonTape tape = get<JsonTape>(parse_json_tape(input));
+
+	// Kinds of the words and the jumps of the arrays and the objects
+	string words;
+	for (size_t i = 0; i < tape.words.size(); ++i) {
+		const char kind = char(tape.words[i] >> 56);
+		words += (i == 0 ? "" : " ") + string(1, kind);
+		if (kind == '{' || kind == '[')
+			words += to_string(tape.words[i] & 0xFFFFFFFF);
+		// The next word is not a value
+		if (kind != '{' && kind != '[' && kind != '}' && kind != ']' &&
+			kind != 't' && kind != 'f' && kind != 'n') ++i;
+	}
+	test->should_be<string>(
+		"‘parse_json_tape’ writes the values in the order of the text",
+		words,
+		"{27 \" [13 l d u \" ] \" {23 \" t \" n } \" f }"
+	);
+
+	test->should_be<string>(
+		"‘to_json_value’ of a tape gives the same document as ‘parse_json’",
+		serialize_json(to_json_value(tape.root())),
+		serialize_json(get<JsonValue>(parse_json(input)))
+	);
+	const JsonValue value = get<JsonValue>(parse_json(input));
+	test->should_be<string>(
+		"‘make_json_tape’ writes the same document",
+		serialize_json(to_json_value(make_json_tape(value).root())),
+		serialize_json(value)
+	);
+
+	const JsonTapeValue root = tape.root();
+	const auto b = in_key("b", root);
+	const auto array = from_json_array(*b);
+	const auto object = from_json_object(root);
+	test->should_be<string>(
+		"Unwrappers of a tape value give the values",
+		to_string(array->size()) + " " +
+			string(*from_json_string(array->at(3))) + " " +
+			to_string(get<uint64_t>(*from_json_number(array->at(2)))) + " " +
+			to_string(*from_json_bool(*in_key("c", *in_key("a", root)))) + " " +
+			to_string(object->size()) + " " +
+			to_string(object->at("b").index == b->index),
+		"4 x\ny 18446744073709551615 1 2 1"
+	);
+	string keys;
+	for (auto &[ key, value ] : *object)
+		keys += key + "=" + to_string(value.index) + " ";
+	test->should_be<string>(
+		"‘from_json_object’ of a tape keeps the order of the keys",
+		keys,
+		"b=3 a=15 "
+	);
+	test->should_be<string>(
+		"Unwrappers of a tape value give nothing for another kind",
+		to_string(from_json_array(root).has_value()) +
+			to_string(from_json_string(array->at(0)).has_value()) +
+			to_string(
+				from_json_bool(*in_key("d", *in_key("a", root))).has_value()
+			) +
+			to_string(in_key("x", root).has_value()) +
+			to_string(in_key("b", *b).has_value()),
+		"00000"
+	);
+
+	JsonParsingOptions lazy;
+	lazy.lazy_numbers = true;
+	const auto lazy_tape = parse_json_tape("[1.50, -0]", lazy);
+	test->should_be<string>(
+		"‘parse_json_tape’ keeps the source text of the numbers",
+		serialize_json(to_json_value(get<JsonTape>(lazy_tape).root())),
+		"[1.50,-0]"
+	);
+
+	const auto failure = parse_json_tape("[1, {\"a\" 2}]");
+	test->should_be<string>(
+		"‘parse_json_tape’ fails like ‘validate_json’",
+		holds_alternative<ParsingError<I>>(failure)
+			? get<ParsingError<I>>(failure).first
+			: "",
+		validate_json(string_view("[1, {\"a\" 2}]"))->first
+	);
+
+	// A big document is a few buffers
+	string big = "[";
+	for (size_t i = 0; i < 1000; ++i)
+		big += (i == 0 ? "" : ", ") + string("{\"n\": [") + to_string(i) + "]}";
+	big += "]";
+	const size_t allocations_before = allocations_counter();
+	const auto big_tape = parse_json_tape(big);
+	test->should_be<bool>(
+		"‘parse_json_tape’ allocates only a few buffers",
+		holds_alternative<JsonTape>(big_tape) &&
+			allocations_counter() - allocations_before < 10,
+		true
+	);
+}
+
+void test_json_object_members(shared_ptr<Test> test)
+{
+	// Bigger than “small_size”, so that the hash index is used
+	string big = "{";
+	for (size_t i = 20; i > 0; --i)
+		big += "\"k" + to_string(i) + "\": " + to_string(i) + ", ";
+	big += "\"k7\": 0, \"\": []}";
+
+	const auto show_result = [](variant<ParsingError<I>, JsonValue> x) {
+		return holds_alternative<JsonValue>(x)
+			? serialize_json(get<JsonValue>(x))
+			: "failure";
+	};
+
+	{ // Order of the keys {{{2
+		const string small =
+			"{\"b\": 1, \"a\": {\"d\": 2, \"c\": 3}, \"b\": 4}";
+		const string expected_small = "{\"b\":1,\"a\":{\"d\":2,\"c\":3}}";
+		string expected_big = "{";
+		for (size_t i = 20; i > 0; --i)
+			expected_big += "\"k" + to_string(i) + "\":" + to_string(i) + ",";
+		expected_big += "\"\":[]}";
+
+		ParseContext ctx;
+		ThreadPool pool(2);
+		for (const auto &[ input, expected ] : {
+			pair(small, expected_small),
+			pair(big, expected_big),
+		}) {
+			const string label =
+				input == small ? " (small object)" : " (big object)";
+			test->should_be<string>(
+				"‘parse_json’ keeps the order of the keys" + label,
+				show_result(parse_json(input)),
+				expected
+			);
+			test->should_be<string>(
+				"‘parse_json_structural’ keeps the order of the keys" + label,
+				show_result(parse_json_structural(input)),
+				expected
+			);
+			// The second time the document is built out of the recycled one
+			for (size_t i = 0; i < 2; ++i) {
+				auto x = parse_json(ctx, input);
+				test->should_be<string>(
+					"‘parse_json’ with a context keeps the order of the keys" +
+						label + " #" + to_string(i),
+					show_result(x),
+					expected
+				);
+				if (holds_alternative<JsonValue>(x))
+					ctx.recycle(move(get<JsonValue>(x)));
+			}
+			test->should_be<string>(
+				"‘parse_json_parallel’ keeps the order of the keys" + label,
+				show_result(parse_json_parallel(pool, input, 8)),
+				expected
+			);
+		}
+	} // }}}2
+
+	{ // Lookups {{{2
+		const JsonMembers members =
+			get<0>(get<JsonObject>(get<JsonValue>(parse_json(big))));
+		string found;
+		for (size_t i = 1; i <= 20; ++i) {
+			const string key = "k" + to_string(i);
+			const JsonNumberValue n =
+				from_json_number(get<JsonNumber>(members.at(key)));
+			if (members.count(key) != 1 || get<int64_t>(n) != int64_t(i))
+				found += key + " ";
+		}
+		test->should_be<string>(
+			"‘JsonMembers’ finds every key of a big object (first one wins)",
+			found,
+			""
+		);
+		test->should_be<string>(
+			"‘JsonMembers’ finds nothing for a missing key",
+			to_string(members.count("k21")) +
+				to_string(members.find("k") == members.end()) +
+				to_string(members.find("") - members.begin()),
+			"0120"
+		);
+
+		JsonMembers small = {{"x", JsonValue{JsonNull{unit()}}}};
+		const bool added =
+			small.emplace("y", JsonValue{make_json_bool(true)}).second;
+		const bool added_again =
+			small.emplace("x", JsonValue{make_json_bool(true)}).second;
+		test->should_be<string>(
+			"‘JsonMembers’ adds a key only once (small object)",
+			to_string(added) + to_string(added_again) + " " +
+				serialize_json(JsonValue{make_json_object(small)}),
+			"10 {\"x\":null,\"y\":true}"
+		);
+
+		// The index is dropped and built again
+		JsonMembers cleared =
+			get<0>(get<JsonObject>(get<JsonValue>(parse_json(big))));
+		cleared.clear();
+		for (size_t i = 0; i < 12; ++i)
+			cleared.emplace(to_string(i % 10), JsonValue{make_json_number(i)});
+		test->should_be<string>(
+			"‘JsonMembers’ can be refilled after ‘clear’",
+			serialize_json(JsonValue{make_json_object(move(cleared))}),
+			"{\"0\":0,\"1\":1,\"2\":2,\"3\":3,\"4\":4,\"5\":5,\"6\":6,\"7\":7,"
+				"\"8\":8,\"9\":9}"
+		);
+	} // }}}2
+}
+
+void test_shared_grammar(shared_ptr<Test> test)
+{
+	const vector<string> inputs = {
+		"{\"a\": [1, 2.5, \"x\", null], \"b\": {\"c\": true}}",
+		"[[[], {}], [false, -7]]",
+		"[1, 2,]",
+		"  \"a\\\"b\"  ",
+	};
+
+	const auto show_results = [&inputs]() -> string {
+		ostringstream out;
+		for (size_t i = 0; i < 200; ++i)
+			for (auto &input : inputs)
+				visit(overloaded {
+					[&out](ParsingError<I> err) { out << "failure: " << err.first; },
+					[&out](JsonValue x) { out << serialize_json(x); }
+				}, parse_json(input));
+		return out.str();
+	};
+
+	const string expected = show_results();
+	vector<string> results(4);
+	vector<thread> threads;
+	for (auto &result : results)
+		threads.emplace_back([&result, &show_results]() { result = show_results(); });
+	for (auto &x : threads) x.join();
+
+	for (size_t i = 0; i < results.size(); ++i)
+		test->should_be<bool>(
+			"‘parse_json’ gives the same results on thread #" + to_string(i),
+			results[i] == expected,
+			true
+		);
+}
+
+void test_structural_index(shared_ptr<Test> test)
+{
+	using JsonResult = variant<ParsingError<I>, JsonValue>;
+
+	const auto show_result = [](JsonResult x) -> string {
+		return visit(overloaded {
+			[](ParsingError<I>) -> string { return "failure"; },
+			[](JsonValue y) -> string { return serialize_json(y); }
+		}, x);
+	};
+
+	{ // structural_index {{{2
+		const auto show_index = [](string_view input) -> string {
+			string out;
+			for (size_t x : structural_index(input)) out += input[x];
+			return out;
+		};
+		test->should_be<string>(
+			"‘structural_index’ finds structural characters",
+			show_index(" {\"a\\\"[\" : [ 12 , true,null ] } "),
+			"{\"\":[1,t,n]}"
+		);
+		test->should_be<size_t>(
+			"‘structural_index’ skips the contents of long strings",
+			structural_index("[\"" + string(200, ',') + "\", 1]").size(),
+			6
+		);
+	} // }}}2
+
+	{ // Same results as “parse_json” {{{2
+		const vector<string> inputs = {
+			"{\"firstName\": \"John\", \"age\": 27, \"height\": -1.75, "
+				"\"phoneNumbers\": [{\"type\": \"home\"}, {\"type\": \"office\"}], "
+				"\"children\": [], \"spouse\": null, \"isAlive\": true}",
+			" [ 1 , -2.5 , +3 , \"a\\\"b\" , [ ] , { } ] ",
+			"\"a\\\\b\"",
+			"\"a\\\\\"",
+			"\"" + string(100, 'x') + "\\\"" + string(100, '[') + "\"",
+			"{\"a\": 1, \"a\": 2}",
+			"[1, 2,]",
+			"[1.]",
+			"[1.5.3]",
+			"[1 2]",
+			"[truex]",
+			"[1\"a\"]",
+			"nul",
+			"\"\"",
+			"\"abc",
+			"99999999999999999999",
+			"{\"a\" 1}",
+			"{\"a\": }",
+			"[] []",
+			"\\\"a\"",
+			"[\"\\u00e9\\uD83D\\uDE10\\n\", \"\\\\\\\\\"]",
+			"\"\\uD83D\"",
+			"\"\\q\"",
+			"\"a\tb\"",
+			"",
+			"  ",
+		};
+		// Shifting the inputs to get every character across block boundaries
+		for (auto &input : inputs) {
+			string structural_results, combinators_results;
+			for (size_t shift = 0; shift <= 64; shift += 7) {
+				const string shifted = string(shift, ' ') + input;
+				structural_results +=
+					show_result(parse_json_structural(shifted)) + "; ";
+				combinators_results += show_result(parse_json(shifted)) + "; ";
+			}
+			test->should_be<string>(
+				"‘parse_json_structural’ gives the same result for: " + input,
+				structural_results,
+				combinators_results
+			);
+		}
+	} // }}}2
+}
+
+void test_parallel_parsing(shared_ptr<Test> test)
+{
+	using JsonResult = variant<ParsingError<I>, JsonValue>;
+
+	const auto show_result = [](JsonResult x) -> string {
+		return visit(overloaded {
+			[](ParsingError<I>) -> string { return "failure"; },
+			[](JsonValue y) -> string { return serialize_json(y); }
+		}, x);
+	};
+
+	ThreadPool pool(4);
+
+	{ // ThreadPool {{{2
+		vector<size_t> results(1000);
+		for (size_t i = 0; i < results.size(); ++i)
+			pool.submit([&pool, &results, i]() {
+				// Tasks submitted by a task are waited for too
+				pool.submit([&results, i]() { results[i] += i; });
+				results[i] += i;
+			});
+		pool.wait();
+
+		size_t sum = 0;
+		for (size_t x : results) sum += x;
+		test->should_be<size_t>(
+			"‘ThreadPool’ runs all the tasks",
+			sum,
+			999 * 1000
+		);
+	} // }}}2
+
+	{ // Same results as “parse_json_structural” {{{2
+		// Brackets, commas and quotes in strings crossing the chunks
+		string big_array = "[";
+		for (size_t i = 0; i < 100; ++i)
+			big_array +=
+				string(i == 0 ? "" : ", ") +
+				"{\"id\": " + to_string(i) + ", \"text\": \"]}" +
+				string(i % 7 * 10, ',') + "\\\"[{\", \"list\": [" +
+				to_string(i) + ", [true, null], -" + to_string(i) + ".5]}";
+		big_array += "]";
+
+		string big_object = "{";
+		for (size_t i = 0; i < 100; ++i)
+			big_object +=
+				string(i == 0 ? "" : ",\n") +
+				"\"key #" + to_string(i % 60) + "\": [\"" +
+				string(i % 5 * 20 + 1, '{') + "\", " + to_string(i) + "]";
+		big_object += "}";
+
+		const vector<string> inputs = {
+			big_array,
+			big_object,
+			big_array + " ",
+			big_array.substr(0, big_array.size() - 1),
+			big_array.substr(1),
+			"[1,, " + big_array.substr(1),
+			big_array.substr(0, big_array.size() / 2) + "]" +
+				big_array.substr(big_array.size() / 2),
+			big_array + " " + big_array,
+			big_object.substr(0, big_object.size() / 2) + ":" +
+				big_object.substr(big_object.size() / 2),
+			"\"" + string(1000, 'x') + "\"",
+			"[" + string(1000, ' ') + "]",
+		};
+
+		for (size_t i = 0; i < inputs.size(); ++i)
+			test->should_be<string>(
+				"‘parse_json_parallel’ gives the same result for input #" +
+				to_string(i),
+				show_result(parse_json_parallel(pool, inputs[i], 64)),
+				show_result(parse_json_structural(inputs[i]))
+			);
+	} // }}}2
+}
+
+void test_json_strings(shared_ptr<Test> test)
+{
+	const auto show_result = [](variant<ParsingError<I>, JsonValue> x) -> string {
+		return visit(overloaded {
+			[](ParsingError<I> err) -> string { return "failure: " + err.first; },
+			[](JsonValue y) -> string { return serialize_json(y); }
+		}, x);
+	};
+
+	const auto decode = [](string input) -> string {
+		size_t pos = 0;
+		string out;
+		const char *err = scan_json_string(input, pos, out);
+		return err == nullptr ? out : string("failure: ") + err;
+	};
+
+	{ // Escapes {{{2
+		test->should_be<string>(
+			"‘scan_json_string’ decodes simple escapes",
+			decode("\"a\\\"\\\\\\/\\b\\f\\n\\r\\tz\""),
+			"a\"\\/\b\f\n\r\tz"
+		);
+		test->should_be<string>(
+			"‘scan_json_string’ decodes “\\u” escapes into UTF-8",
+			decode("\"\\u0041\\u00e9\\u20AC\""),
+			"A\u00e9\u20ac"
+		);
+		test->should_be<string>(
+			"‘scan_json_string’ combines surrogate pairs",
+			decode("\"\\uD83D\\uDE10\""),
+			"\U0001F610"
+		);
+		test->should_be<string>(
+			"‘scan_json_string’ accepts an empty string",
+			decode("\"\""),
+			""
+		);
+		test->should_be<string>(
+			"‘scan_json_string’ rejects unknown escapes",
+			decode("\"\\x\""),
+			"failure: JsonString: unknown escape sequence"
+		);
+		test->should_be<string>(
+			"‘scan_json_string’ rejects a lone high surrogate",
+			decode("\"\\uD83Dx\""),
+			"failure: JsonString: unpaired UTF-16 high surrogate"
+		);
+		test->should_be<string>(
+			"‘scan_json_string’ rejects a lone low surrogate",
+			decode("\"\\uDE10\""),
+			"failure: JsonString: unpaired UTF-16 low surrogate"
+		);
+		test->should_be<string>(
+			"‘scan_json_string’ rejects short “\\u” escapes",
+			decode("\"\\u12\""),
+			"failure: JsonString: “\\u” must be followed by 4 hex digits"
+		);
+		test->should_be<string>(
+			"‘scan_json_string’ rejects raw control characters",
+			decode("\"" + string(40, 'x') + "\n\""),
+			"failure: JsonString: control characters must be escaped"
+		);
+	} // }}}2
+
+	{ // Zero-copy {{{2
+		const string input = "\"" + string(100, 'x') + "\" ";
+		size_t pos = 0;
+		string_view out;
+		string buffer;
+		const char *err = scan_json_string(input, pos, out, buffer);
+		test->should_be<bool>(
+			"‘scan_json_string’ gives a view into the input without escapes",
+			err == nullptr && out.data() == input.data() + 1 && out.size() == 100,
+			true
+		);
+		test->should_be<size_t>(
+			"‘scan_json_string’ moves the position past the closing quote",
+			pos,
+			102
+		);
+	} // }}}2
+
+	{ // Values shared with the input {{{2
+		auto input = make_shared<const string>(
+			"{\"key\": [\"" + string(100, 'x') + "\", \"a\\nb\", \"\"]}"
+		);
+		JsonParsingOptions options;
+		options.shared_input = input;
+		ThreadPool pool(2);
+		ParseContext ctx;
+
+		// Kind of every string value in the array: “v” for a view into the
+		// input, “s” for an own string
+		const auto kinds = [&input](variant<ParsingError<I>, JsonValue> x) {
+			if (holds_alternative<ParsingError<I>>(x))
+				return get<ParsingError<I>>(x).first;
+			string result;
+			const JsonObject &object = get<JsonObject>(get<JsonValue>(x));
+			for (auto &y : get<0>(get<JsonArray>(get<0>(object).at("key")))) {
+				const JsonString &z = get<JsonString>(y);
+				const string_view view = json_string_view(z);
+				result +=
+					holds_alternative<SharedStringView>(get<0>(z)) &&
+					view.data() >= input->data() &&
+					view.data() < input->data() + input->size()
+						? "v" : "s";
+			}
+			return result;
+		};
+
+		test->should_be<string>(
+			"Strings without escapes are views into the input with all the engines",
+			kinds(parse_json(*input, options)) + " " +
+				kinds(parse_json_structural(*input, options)) + " " +
+				kinds(parse_json_parallel(pool, *input, 64, options)) + " " +
+				kinds(parse_json(ctx, *input, options)),
+			"vss vss vss vss"
+		);
+		test->should_be<string>(
+			"‘serialize_json’ gives the same result for shared strings",
+			show_result(parse_json_structural(*input, options)),
+			show_result(parse_json_structural(*input))
+		);
+
+		const size_t allocations_before = allocations_counter();
+		auto x = parse_json_structural(*input);
+		const size_t copy_allocations = allocations_counter() - allocations_before;
+		auto y = parse_json_structural(*input, options);
+		const size_t shared_allocations =
+			allocations_counter() - allocations_before - copy_allocations;
+		test->should_be<size_t>(
+			"Strings shared with the input are not allocated",
+			copy_allocations - shared_allocations,
+			1
+		);
+
+		// The grammar of the input is built by the first call only (building
+		// one would take a lot more allocations than the strings that are not
+		// copied)
+		parse_json(*input, options);
+		const size_t combinators_before = allocations_counter();
+		parse_json(*input);
+		const size_t combinators_copy =
+			allocations_counter() - combinators_before;
+		parse_json(*input, options);
+		test->should_be<bool>(
+			"‘parse_json’ with shared input builds the grammar only once",
+			allocations_counter() - combinators_before - combinators_copy <
+				combinators_copy,
+			true
+		);
+		test->should_be<string>(
+			"‘json_value’ with shared input gives views into the input",
+			kinds(parse<JsonValue>(json_value(options), *input)),
+			"vss"
+		);
+
+		// Only the document keeps the input alive now
+		const string expected = show_result(y);
+		const weak_ptr<const string> released = input;
+		input.reset();
+		options.shared_input.reset();
+		test->should_be<string>(
+			"Shared strings keep the input alive",
+			show_result(move(y)),
+			expected
+		);
+		test->should_be<bool>(
+			"The grammar built for an input does not keep it alive",
+			released.expired(),
+			true
+		);
+	} // }}}2
+
+	{ // Serialization {{{2
+		const string input =
+			"[\"a\\\"b\\\\c\\n\\t\\u0001\\u00e9\", \"\"]";
+		test->should_be<string>(
+			"‘serialize_json’ escapes strings",
+			show_result(parse_json(input)),
+			"[\"a\\\"b\\\\c\\n\\t\\u0001\u00e9\",\"\"]"
+		);
+		const string serialized = show_result(parse_json(input));
+		test->should_be<string>(
+			"‘serialize_json’ output parses back to the same value",
+			show_result(parse_json(serialized)),
+			serialized
+		);
+	} // }}}2
+}
+
+void test_json_numbers(shared_ptr<Test> test)
+{
+	const auto scan = [](string input) -> string {
+		size_t pos = 0;
+		JsonNumber x;
+		const char *err = scan_json_number(input, pos, x);
+		if (err != nullptr) return to_string(pos) + ": " + err;
+		ostringstream out;
+		out << setprecision(17);
+		visit([&out](auto y) { out << y; }, from_json_number(x));
+		return out.str() + " (" + to_string(pos) + ")";
+	};
+
+	test->should_be<string>(
+		"‘scan_json_number’ converts integer numbers",
+		scan("12345678") + "; " + scan("-2147483647,") + "; " +
+			scan("-0.00000000000000000042]") + "; " + scan("0"),
+		"12345678 (8); -2147483647 (11); -4.1999999999999998e-19 (23); 0 (1)"
+	);
+	test->should_be<string>(
+		"‘scan_json_number’ converts 64-bit integer numbers",
+		scan("9223372036854775807") + "; " + scan("-9223372036854775808") +
+			"; " + scan("18446744073709551615") + "; " +
+			scan("-123456789012345678901234"),
+		"9223372036854775807 (19); -9223372036854775808 (20); "
+		"18446744073709551615 (20); -1.2345678901234569e+23 (25)"
+	);
+	test->should_be<string>(
+		"‘scan_json_number’ picks the type of a number",
+		[]() {
+			string types;
+			for (string x : vector<string> {
+				"1", "-9223372036854775808", "9223372036854775808",
+				"18446744073709551616", "1.0", "1e2",
+			}) {
+				size_t pos = 0;
+				JsonNumber y;
+				scan_json_number(x, pos, y);
+				types += visit(overloaded {
+					[](int64_t) { return "int64 "; },
+					[](uint64_t) { return "uint64 "; },
+					[](double) { return "double "; }
+				}, from_json_number(y));
+			}
+			return types;
+		}(),
+		"int64 int64 uint64 double double double "
+	);
+	test->should_be<string>(
+		"‘scan_json_number’ converts exponents",
+		scan("1e10") + "; " + scan("-0.5E-3") + "; " + scan("2E+2,") + "; " +
+			scan("1e") + "; " + scan("1e+") + "; " + scan("1.5e-400") + "; " +
+			scan("1e400"),
+		"10000000000 (4); -0.00050000000000000001 (7); 200 (4); 1 (1); 1 (1); "
+		"0 (8); 0: JsonNumber: value is out of “double” bounds"
+	);
+	test->should_be<string>(
+		"‘scan_json_number’ converts fractional numbers",
+		scan("3.25") + "; " + scan("-0.000000000000001") + "; " +
+			scan("1234567890.0987654321") + "; " + scan("1.5.3"),
+		"3.25 (4); -1.0000000000000001e-15 (18); "
+		"1234567890.0987654 (21); 1.5 (3)"
+	);
+	test->should_be<bool>(
+		"‘scan_json_number’ gives the same fractional numbers as ‘strtod’",
+		[&scan]() {
+			for (string x : vector<string> {
+				"0.1", "0.3", "123456789012345678.5", "9007199254740993.0",
+				"0.30000000000000004", "2.2250738585072011", "1.7976931348623157",
+				"0." + string(30, '0') + "7", "4" + string(300, '9') + ".5",
+				"4.9406564584124654e-324", "2.2250738585072014e-308",
+				"1.7976931348623157e308", "9007199254740993e0", "1e23",
+				"8.41e21", "7.3177701707893310e15", "1.00000000000000011102230246251565404236316680908203125",
+				"1.00000000000000011102230246251565404236316680908203124",
+				"1.00000000000000011102230246251565404236316680908203126",
+				"123456789e-300", "0.000000000000000000000000000001e30",
+			}) {
+				ostringstream out;
+				out << setprecision(17) << strtod(x.c_str(), nullptr);
+				if (scan(x) != out.str() + " (" + to_string(x.size()) + ")")
+					return false;
+			}
+			return true;
+		}(),
+		true
+	);
+	test->should_be<string>(
+		"‘scan_json_number’ requires digits",
+		scan("-x") + "; " + scan("+.5"),
+		"0: JsonNumber: digits are expected; 0: JsonNumber: digits are expected"
+	);
+
+	// The Eisel-Lemire algorithm with all the powers of 10 from its table and
+	// random mantissas of all the lengths
+	test->should_be<size_t>(
+		"‘scan_json_number’ conversion matches ‘strtod’ on random numbers",
+		[]() {
+			size_t mismatches = 0;
+			uint64_t state = 42;
+			const auto random = [&state]() {
+				state = state * 6364136223846793005 + 1442695040888963407;
+				return state >> 11;
+			};
+			for (int exponent = -360; exponent <= 360; ++exponent)
+				for (size_t i = 0; i < 40; ++i) {
+					const string x =
+						to_string(random() % 10) + "." +
+						to_string(random()).substr(0, 1 + i % 19) +
+						"e" + to_string(exponent);
+					size_t pos = 0;
+					JsonNumber y;
+					const char *err = scan_json_number(x, pos, y);
+					const double expected = strtod(x.c_str(), nullptr);
+					if (isinf(expected)) {
+						if (err == nullptr) ++mismatches;
+					} else if (
+						err != nullptr ||
+						get<double>(from_json_number(y)) != expected
+					) {
+						++mismatches;
+					}
+				}
+			return mismatches;
+		}(),
+		0
+	);
+
+	test->should_be<string>(
+		"‘serialize_json’ gives the shortest representation of numbers",
+		visit(overloaded {
+			[](ParsingError<I>) -> string { return "failure"; },
+			[](JsonValue x) -> string { return serialize_json(x); }
+		}, parse_json("[0.1, 1e21, 2.5e-7, 3.0, -0.0, 1e2, 12, -9223372036854775808]")),
+		"[0.1,1e+21,2.5e-07,3.0,-0.0,100.0,12,-9223372036854775808]"
+	);
+
+	test->should_be<string>(
+		"Numbers with a leading “+” or leading zeros fail with all the engines",
+		[]() {
+			// “o” for a parsed number, “f” for a failure
+			string result;
+			ParseContext ctx;
+			for (const string x : {
+				"0", "-0", "0.5", "0e1", "10", "01", "-01", "00.5", "+1", "-"
+			}) {
+				const string input = "[" + x + "]";
+				for (bool ok : {
+					holds_alternative<JsonValue>(parse_json(input)),
+					holds_alternative<JsonValue>(parse_json_structural(input)),
+					holds_alternative<JsonValue>(parse_json(ctx, input)),
+					!validate_json(string_view(input)).has_value(),
+				}) result += ok ? "o" : "f";
+				result += " ";
+			}
+			return result;
+		}(),
+		"oooo oooo oooo oooo oooo ffff ffff ffff ffff ffff "
+	);
+	test->should_be<string>(
+		"A number with leading zeros fails at its first digit",
+		visit(overloaded {
+			[](ParsingError<I> err) -> string {
+				return err.first + " at " + to_string(err.second.size());
+			},
+			[](JsonValue) -> string { return "success"; }
+		}, parse_json_structural(string_view("[-012]"))),
+		"JsonNumber: leading zeros are not allowed at 4"
+	);
+
+	{ // Lazy numbers {{{2
+		JsonParsingOptions lazy;
+		lazy.lazy_numbers = true;
+		const string input =
+			"[0.10, -0, 1E2, 123456789012345678901234, 1e-999, 1.000, 0.3e+1]";
+		const string verbatim =
+			"[0.10,-0,1E2,123456789012345678901234,1e-999,1.000,0.3e+1]";
+		ThreadPool pool(2);
+		ParseContext ctx;
+
+		const auto show = [](variant<ParsingError<I>, JsonValue> x) -> string {
+			return visit(overloaded {
+				[](ParsingError<I> err) -> string { return err.first; },
+				[](JsonValue y) -> string { return serialize_json(y); }
+			}, x);
+		};
+
+		test->should_be<string>(
+			"‘serialize_json’ copies lazy numbers verbatim with all the engines",
+			show(parse_json(input, lazy)) + "; " +
+				show(parse_json_structural(input, lazy)) + "; " +
+				show(parse_json_parallel(pool, input, 64, lazy)) + "; " +
+				show(parse_json(ctx, input, lazy)),
+			verbatim + "; " + verbatim + "; " + verbatim + "; " + verbatim
+		);
+		test->should_be<string>(
+			"‘from_json_number’ converts lazy numbers the same way",
+			[&]() {
+				const auto numbers = [](JsonValue x) {
+					ostringstream out;
+					out << setprecision(17);
+					for (auto &y : get<0>(get<JsonArray>(x)))
+						visit([&out](auto z) { out << z << " "; },
+							from_json_number(get<JsonNumber>(y)));
+					return out.str();
+				};
+				return
+					numbers(get<JsonValue>(parse_json(input, lazy))) + "/ " +
+					numbers(get<JsonValue>(parse_json(input)));
+			}(),
+			"0.10000000000000001 0 100 1.2345678901234569e+23 0 1 3 / "
+			"0.10000000000000001 0 100 1.2345678901234569e+23 0 1 3 "
+		);
+		test->should_be<string>(
+			"Lazy numbers that are out of “double” bounds fail",
+			show(parse_json_structural("[1, 1e400]", lazy)),
+			"JsonNumber: value is out of “double” bounds"
+		);
+		const string long_integer = "[" + string(400, '9') + "]";
+		test->should_be<string>(
+			"Lazy integer numbers that are out of “double” bounds fail",
+			show(parse_json_structural(long_integer, lazy)) + " / " +
+				show(parse_json_structural(long_integer)),
+			"JsonNumber: value is out of “double” bounds / "
+			"JsonNumber: value is out of “double” bounds"
+		);
+		test->should_be<string>(
+			"Long lazy integer numbers within “double” bounds are kept",
+			show(parse_json_structural("[" + string(300, '9') + "]", lazy)),
+			"[" + string(300, '9') + "]"
+		);
+
+		// “v” for a view into the input, “s” for an own string
+		auto shared = make_shared<const string>(input);
+		JsonParsingOptions shared_lazy = lazy;
+		shared_lazy.shared_input = shared;
+		const auto kinds = [&shared](variant<ParsingError<I>, JsonValue> x) {
+			if (holds_alternative<ParsingError<I>>(x))
+				return get<ParsingError<I>>(x).first;
+			string result;
+			for (auto &y : get<0>(get<JsonArray>(get<JsonValue>(x)))) {
+				const auto &raw = get<RawJsonNumber>(get<0>(get<JsonNumber>(y)));
+				const string_view view = raw_json_number_view(raw);
+				result +=
+					holds_alternative<SharedStringView>(get<0>(raw)) &&
+					view.data() >= shared->data() &&
+					view.data() < shared->data() + shared->size()
+						? "v" : "s";
+			}
+			return result;
+		};
+		test->should_be<string>(
+			"Lazy numbers are views into the shared input",
+			kinds(parse_json(*shared, shared_lazy)) + " " +
+				kinds(parse_json_structural(*shared, shared_lazy)) + " " +
+				kinds(parse_json_parallel(pool, *shared, 64, shared_lazy)) + " " +
+				kinds(parse_json(ctx, *shared, shared_lazy)) + " " +
+				kinds(parse_json_structural(*shared, lazy)),
+			"vvvvvvv vvvvvvv vvvvvvv vvvvvvv sssssss"
+		);
+		test->should_be<string>(
+			"‘serialize_json’ copies shared lazy numbers verbatim",
+			show(parse_json_structural(*shared, shared_lazy)),
+			verbatim
+		);
+	} // }}}2
+
+	string big_array = "[";
+	for (size_t i = 0; i < 100000; ++i)
+		big_array += (i == 0 ? "" : ",") + to_string(i);
+	big_array += "]";
+	test->should_be<size_t>(
+		"‘parse_json’ parses an array of 100000 numbers",
+		visit(overloaded {
+			[](ParsingError<I>) -> size_t { return 0; },
+			[](JsonValue x) -> size_t {
+				return get<0>(get<JsonArray>(x)).size();
+			}
+		}, parse_json(big_array)),
+		100000
+	);
+}
+
+void test_utf8_validation(shared_ptr<Test> test)
+{
+	const auto validate = [](string input) -> string {
+		size_t pos = 0;
+		const char *err = validate_utf8(input, pos);
+		return err == nullptr ? "ok" : to_string(pos) + ": " + err;
+	};
+
+	const string text = "JSON données данные データ 😀 ";
+	string long_text;
+	for (size_t i = 0; i < 10; ++i) long_text += text;
+
+	// Shifting the inputs to get every sequence across vector boundaries
+	string results;
+	for (size_t shift = 0; shift < 64; ++shift)
+		results += validate(string(shift, ' ') + long_text) + " ";
+	test->should_be<string>(
+		"‘validate_utf8’ accepts well-formed text at any offset",
+		results,
+		[]() { string x; for (size_t i = 0; i < 64; ++i) x += "ok "; return x; }()
+	);
+
+	const vector<pair<string, string>> invalid = {
+		{"\x80", "unexpected continuation byte"},
+		{"\xC0\xAF", "overlong encoding"},
+		{"\xE0\x9F\xBF", "overlong encoding"},
+		{"\xF0\x8F\xBF\xBF", "overlong encoding"},
+		{"\xED\xA0\x80", "encoded UTF-16 surrogate"},
+		{"\xF4\x90\x80\x80", "code point is out of range"},
+		{"\xF8\x88\x80\x80\x80", "invalid byte"},
+		{"\xE2\x82x", "truncated sequence"},
+		{"\xF0\x9F\x98", "truncated sequence"},
+	};
+	for (auto &[ sequence, message ] : invalid) {
+		string results, expected;
+		for (size_t offset : {0, 5, 15, 31, 33, 62, 100}) {
+			const string prefix = long_text.substr(0, offset);
+			// Not cutting a character
+			size_t cut = prefix.size();
+			while (cut > 0 && (prefix[cut - 1] & 0xC0) == 0x80) --cut;
+			if (cut > 0 && (unsigned char) prefix[cut - 1] >= 0xC0) --cut;
+			results +=
+				validate(prefix.substr(0, cut) + sequence + long_text) + "; ";
+			expected += to_string(cut) + ": UTF-8: " + message + "; ";
+		}
+		test->should_be<string>(
+			"‘validate_utf8’ gives the exact offset of: " + message,
+			results,
+			expected
+		);
+	}
+
+	test->should_be<string>(
+		"‘validate_utf8’ rejects a sequence cut at the end of the input",
+		validate(long_text + "\xE2\x82"),
+		to_string(long_text.size()) + ": UTF-8: truncated sequence"
+	);
+
+	const string json = "{\"a\": \"données\", \"b\": \"\xFF\"}";
+	const auto err = utf8_parsing_error(json);
+	test->should_be<size_t>(
+		"‘utf8_parsing_error’ points at the malformed byte",
+		err ? parsing_error_offset(json, *err) : 0,
+		json.size() - 3
+	);
+}
+
+#if __cplusplus >= 202002L
+void test_static_json(shared_ptr<Test> test)
+{
+	static constexpr char literal[] = R"(
+		{
+			"name": "Some \"service\"",
+			"path": "C:\\\u00e9\n",
+			"empty": "",
+			"port": 8080,
+			"ratio": -0.125,
+			"offset": -9223372036854775808,
+			"mask": 18446744073709551615,
+			"delay": 25E-3,
+			"enabled": true,
+			"parent": null,
+			"hosts": [ "a", "b", [], {} ],
+			"limits": { "connections": 100, "timeout": 1.5 },
+			"port": 1
+		}
+	)";
+	static constexpr auto doc = static_json<literal>();
+
+	static_assert(doc.root()["name"].as_string() == "Some \"service\"");
+	static_assert(doc.root()["path"].as_string() == "C:\\\u00e9\n");
+	static_assert(doc.root()["empty"].as_string().empty());
+	static_assert(doc.root()["port"].as_int() == 8080);
+	static_assert(doc.root()["ratio"].as_double() == -0.125);
+	static_assert(doc.root()["offset"].as_int() == INT64_MIN);
+	static_assert(doc.root()["mask"].as_uint() == UINT64_MAX);
+	static_assert(doc.root()["delay"].as_double() == 0.025);
+	static_assert(doc.root()["enabled"].as_bool());
+	static_assert(doc.root()["parent"].is_null());
+	static_assert(doc.root()["hosts"].size() == 4);
+	static_assert(doc.root()["hosts"][1].as_string() == "b");
+	static_assert(doc.root()["limits"]["connections"].as_int() == 100);
+	static_assert(doc.root()["limits"]["timeout"].as_double() == 1.5);
+	static_assert(!doc.root().contains("missing"));
+
+	test->should_be<string>(
+		"‘static_json’ gives the same value as ‘parse_json’",
+		serialize_json(to_json_value(doc.root())),
+		visit(overloaded {
+			[](ParsingError<I>) -> string { return "failure"; },
+			[](JsonValue x) -> string { return serialize_json(x); }
+		}, parse_json(literal))
+	);
+}
+#endif
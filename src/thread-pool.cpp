@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "thread-pool.hpp"
+
+using namespace std;
+
+
+// The pool and the worker index of the current thread (if it is a worker)
+static thread_local const ThreadPool *current_pool = nullptr;
+static thread_local size_t current_worker = 0;
+
+ThreadPool::ThreadPool(size_t threads_count): queues(max<size_t>(1, threads_count))
+{
+	for (size_t i = 0; i < queues.size(); ++i)
+		workers.emplace_back([this, i]() { work(i); });
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		lock_guard<mutex> guard(state_lock);
+		stopping = true;
+	}
+	tasks_available.notify_all();
+	for (auto &x : workers) x.join();
+}
+
+void ThreadPool::submit(function<void()> task)
+{
+	size_t queue_index;
+	{
+		lock_guard<mutex> guard(state_lock);
+		++queued;
+		++unfinished;
+		queue_index =
+			current_pool == this ? current_worker : next_queue++ % queues.size();
+	}
+
+	{
+		Queue &queue = queues[queue_index];
+		lock_guard<mutex> guard(queue.lock);
+		queue.tasks.push_back(move(task));
+	}
+
+	tasks_available.notify_one();
+	state_changed.notify_all();
+}
+
+bool ThreadPool::run_one(size_t queue_index)
+{
+	function<void()> task;
+
+	for (size_t i = 0; i < queues.size() && !task; ++i) {
+		Queue &queue = queues[(queue_index + i) % queues.size()];
+		lock_guard<mutex> guard(queue.lock);
+		if (queue.tasks.empty()) continue;
+
+		// Own tasks are taken from the back, the stolen ones from the front
+		if (i == 0) {
+			task = move(queue.tasks.back());
+			queue.tasks.pop_back();
+		} else {
+			task = move(queue.tasks.front());
+			queue.tasks.pop_front();
+		}
+	}
+
+	if (!task) return false;
+
+	{
+		lock_guard<mutex> guard(state_lock);
+		--queued;
+	}
+
+	task();
+
+	{
+		lock_guard<mutex> guard(state_lock);
+		--unfinished;
+	}
+	state_changed.notify_all();
+
+	return true;
+}
+
+void ThreadPool::work(size_t worker_index)
+{
+	current_pool = this;
+	current_worker = worker_index;
+
+	for (;;) {
+		{
+			unique_lock<mutex> guard(state_lock);
+			tasks_available.wait(guard, [this]() { return stopping || queued > 0; });
+			if (stopping && queued == 0) return;
+		}
+
+		run_one(worker_index);
+	}
+}
+
+void ThreadPool::wait()
+{
+	for (;;) {
+		if (run_one(0)) continue;
+
+		unique_lock<mutex> guard(state_lock);
+		if (unfinished == 0) return;
+		state_changed.wait(guard, [this]() {
+			return unfinished == 0 || queued > 0;
+		});
+		if (unfinished == 0) return;
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+// A fixed set of worker threads with work stealing.
+//
+// Every worker has its own queue of tasks. A task submitted from a worker goes
+// to the queue of that worker, other tasks are spread over the queues one by
+// one. A worker takes the tasks from the back of its own queue and when it is
+// empty it steals the tasks from the front of the queues of the other workers.
+//
+// Mind that the tasks must not throw.
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+
+class ThreadPool
+{
+public:
+	// At least one worker is started even if “threads_count” is 0
+	explicit ThreadPool(size_t threads_count);
+	~ThreadPool();
+
+	size_t size() const { return workers.size(); }
+
+	void submit(function<void()> task);
+
+	// Wait until all the submitted tasks are done (including the ones submitted
+	// by other tasks in the meantime). The calling thread runs the tasks too
+	// while there are any in the queues.
+	// Mind that it must not be called from a task.
+	void wait();
+
+private:
+	struct Queue
+	{
+		mutex lock;
+		deque<function<void()>> tasks;
+	};
+
+	vector<Queue> queues;
+	vector<thread> workers;
+
+	mutex state_lock;
+	condition_variable tasks_available;
+	condition_variable state_changed;
+	size_t queued = 0;     // Tasks in the queues
+	size_t unfinished = 0; // Tasks in the queues and the running ones
+	size_t next_queue = 0;
+	bool stopping = false;
+
+	// Run one task from the given queue or steal one from the other queues.
+	// Returns false if all the queues are empty.
+	bool run_one(size_t queue_index);
+
+	void work(size_t worker_index);
+};